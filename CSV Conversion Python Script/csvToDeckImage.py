@@ -0,0 +1,146 @@
+import struct, zlib
+
+# --- Deck image format ------------------------------------------------------
+# Mirrors lib/Deck/deck_store.h; keep the two in step.
+FLASH_PAGE_SIZE = 256
+DECK_FLASH_SIZE = 1024 * 1024
+DECK_STORE_SLOT_SIZE = DECK_FLASH_SIZE // 2
+DECK_STORE_INDEX = FLASH_PAGE_SIZE
+DECK_STORE_STRINGS = 128 * 1024
+DECK_STORE_MAGIC = 0x4b434544
+DECK_STORE_VERSION = 4
+DECK_CSV_MAX_RECORD = 1024
+DECK_STORE_ETAG_SIZE = 128
+DECK_STORE_LAST_MODIFIED_SIZE = 32
+
+HEADER = struct.Struct(          # Fields before header_crc
+    f"<9I{DECK_STORE_ETAG_SIZE}s{DECK_STORE_LAST_MODIFIED_SIZE}s")
+ENTRY = struct.Struct("<IHHI")   # front, front_length, back_length, hash
+
+# --- CSV parsing ------------------------------------------------------------
+# Same rules as lib/Deck/deck_csv.c, so the image matches what the Pico
+# would build from the same file.
+START, UNQUOTED, QUOTED, QUOTE, AFTER_QUOTED = range(5)
+QUOTE_CHAR, COMMA, NEWLINES, SPACES = ord('"'), ord(","), b"\r\n", b" \t\r\n"
+
+class DeckCsvParser:
+    def __init__(self):
+        self.cards = []
+        self.start_record()
+
+    def start_record(self):
+        self.state, self.field, self.record, self.back = START, 0, bytearray(), 0
+
+    def append(self, c):                    # Front capped at half the record
+        limit = DECK_CSV_MAX_RECORD // 2 - 1 if self.field == 0 else DECK_CSV_MAX_RECORD - 1
+        if len(self.record) < limit:
+            self.record.append(c)
+
+    def end_front(self):
+        self.record.append(0)
+        self.back, self.field, self.state = len(self.record), 1, START
+
+    def end_record(self):
+        if self.field == 1:
+            front = bytes(self.record[:self.back - 1]).strip(SPACES)
+            back = bytes(self.record[self.back:]).strip(SPACES)
+            if front and back:
+                self.cards.append((front, back))
+        self.start_record()
+
+    def feed(self, data: bytes):
+        for c in data:
+            if self.state == QUOTE:
+                if c == QUOTE_CHAR:                 # ""  ->  "
+                    self.append(c)
+                    self.state = QUOTED
+                    continue
+                self.state = AFTER_QUOTED           # Closing quote
+            if self.state == AFTER_QUOTED:
+                if c == COMMA and self.field == 0:
+                    self.end_front()
+                elif c in NEWLINES:
+                    self.end_record()
+                continue                            # Junk is ignored
+            if self.state == QUOTED:
+                if c == QUOTE_CHAR:
+                    self.state = QUOTE
+                else:
+                    self.append(c)
+                continue
+            if self.state == START:
+                if c == QUOTE_CHAR:
+                    self.state = QUOTED
+                    continue
+                self.state = UNQUOTED
+            if c == COMMA and self.field == 0:
+                self.end_front()
+            elif c in NEWLINES:
+                self.end_record()
+            else:
+                self.append(c)
+
+    def finish(self):
+        self.end_record()
+        return self.cards
+
+def parse_csv(data: bytes):
+    parser = DeckCsvParser()
+    parser.feed(data)
+    return parser.finish()
+
+# --- Image ------------------------------------------------------------------
+def build_image(cards, sequence: int) -> bytes:
+    index, strings = bytearray(), bytearray()
+    for front, back in cards:
+        if len(front) > 0xffff or len(back) > 0xffff:
+            raise ValueError("Card text too long")
+        text = front + b"\0" + back + b"\0"
+        index += ENTRY.pack(len(strings), len(front), len(back), zlib.crc32(text))
+        strings += text
+
+    if DECK_STORE_INDEX + len(index) > DECK_STORE_STRINGS:
+        raise ValueError(f"Too many cards ({len(cards)})")
+    if DECK_STORE_STRINGS + len(strings) > DECK_STORE_SLOT_SIZE:
+        raise ValueError(f"Card text too large ({len(strings)} bytes)")
+
+    fields = HEADER.pack(
+        DECK_STORE_MAGIC, DECK_STORE_VERSION, sequence, len(cards),
+        DECK_STORE_INDEX, DECK_STORE_STRINGS, len(strings),
+        zlib.crc32(index), zlib.crc32(strings),
+        b"", b"",                   # No HTTP validators; next refresh is a full GET
+    )
+    header = fields + struct.pack("<I", zlib.crc32(fields))
+
+    image = bytearray(b"\xff" * (DECK_STORE_STRINGS + len(strings)))
+    image[0:len(header)] = header
+    image[DECK_STORE_INDEX:DECK_STORE_INDEX + len(index)] = index
+    image[DECK_STORE_STRINGS:] = strings
+    pad = -len(image) % FLASH_PAGE_SIZE
+    return bytes(image + b"\xff" * pad)
+
+# --- CLI --------------------------------------------------------------------
+if __name__ == "__main__":
+    import argparse
+    ap = argparse.ArgumentParser(
+        description="Build a deck flash image for the Pico from cards.csv")
+    ap.add_argument("csv", help="CSV deck (as produced by ankiToCSV.py)")
+    ap.add_argument("image", help="Output image (.bin)")
+    ap.add_argument("--slot", type=int, choices=(0, 1), default=0,
+                    help="Deck slot the image will be loaded into")
+    ap.add_argument("--sequence", type=int, default=1,
+                    help="Deck sequence number; the newest valid slot is used")
+    ap.add_argument("--flash-size", type=int, default=2 * 1024 * 1024,
+                    help="Size of the Pico's flash in bytes")
+    args = ap.parse_args()
+
+    with open(args.csv, "rb") as fh:
+        cards = parse_csv(fh.read())
+    image = build_image(cards, args.sequence)
+    with open(args.image, "wb") as fh:
+        fh.write(image)
+
+    address = (0x10000000 + args.flash_size - DECK_FLASH_SIZE
+               + args.slot * DECK_STORE_SLOT_SIZE)
+    print(f"{len(cards)} cards, {len(image)} bytes")
+    print(f"Load with: picotool load -o 0x{address:08x} {args.image}")
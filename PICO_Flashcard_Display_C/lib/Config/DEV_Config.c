@@ -32,6 +32,8 @@
 #define I2C_PORT spi1
 
 uint slice_num;
+static int spi_dma_chan = -1;
+static volatile DEV_SPI_DMA_Callback spi_dma_done = NULL;
 /**
  * GPIO read and write
 **/
@@ -58,6 +60,57 @@ void DEV_SPI_Write_nByte(uint8_t pData[], uint32_t Len)
     spi_write_blocking(SPI_PORT, pData, Len);
 }
 
+/**
+ * SPI DMA
+ *
+ * One channel feeds the SPI TX FIFO. Done is called from the DMA_IRQ_1
+ * handler once the last byte has been handed to the FIFO; use
+ * DEV_SPI_Wait_Idle before touching CS/DC after that.
+**/
+static void DEV_SPI_DMA_IRQHandler(void)
+{
+    if (spi_dma_chan < 0 || !dma_channel_get_irq1_status(spi_dma_chan))
+        return;
+    dma_channel_acknowledge_irq1(spi_dma_chan);
+
+    DEV_SPI_DMA_Callback Done = spi_dma_done;
+    spi_dma_done = NULL;
+    if (Done)
+        Done();
+}
+
+static void DEV_SPI_DMA_Init(void)
+{
+    spi_dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(spi_dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, spi_get_dreq(SPI_PORT, true));
+    dma_channel_configure(spi_dma_chan, &c, &spi_get_hw(SPI_PORT)->dr, NULL, 0, false);
+
+    dma_channel_set_irq1_enabled(spi_dma_chan, true);
+    irq_add_shared_handler(DMA_IRQ_1, DEV_SPI_DMA_IRQHandler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+}
+
+void DEV_SPI_DMA_Write_nByte(const uint8_t *pData, uint32_t Len, DEV_SPI_DMA_Callback Done)
+{
+    spi_dma_done = Done;
+    dma_channel_transfer_from_buffer_now(spi_dma_chan, pData, Len);
+}
+
+bool DEV_SPI_DMA_Busy(void)
+{
+    return dma_channel_is_busy(spi_dma_chan);
+}
+
+void DEV_SPI_Wait_Idle(void)
+{
+    while (spi_is_busy(SPI_PORT))
+        tight_loop_contents();
+}
+
 
 
 /**
@@ -150,6 +203,7 @@ UBYTE DEV_Module_Init(void)
     spi_init(SPI_PORT, 10000 * 1000);
     gpio_set_function(LCD_CLK_PIN, GPIO_FUNC_SPI);
     gpio_set_function(LCD_MOSI_PIN, GPIO_FUNC_SPI);
+    DEV_SPI_DMA_Init();
     printf("SPI Init OK \r\n");
 
 
@@ -34,6 +34,7 @@
 #include "stdio.h"
 #include "hardware/i2c.h"
 #include "hardware/pwm.h"
+#include "hardware/dma.h"
 
 /**
  * data
@@ -68,6 +69,11 @@ UBYTE DEV_Digital_Read(UWORD Pin);
 void DEV_SPI_WriteByte(UBYTE Value);
 void DEV_SPI_Write_nByte(uint8_t *pData, uint32_t Len);
 
+typedef void (*DEV_SPI_DMA_Callback)(void);
+void DEV_SPI_DMA_Write_nByte(const uint8_t *pData, uint32_t Len, DEV_SPI_DMA_Callback Done);
+bool DEV_SPI_DMA_Busy(void);
+void DEV_SPI_Wait_Idle(void);
+
 void DEV_Delay_ms(UDOUBLE xms);
 void DEV_Delay_us(UDOUBLE xus);
 
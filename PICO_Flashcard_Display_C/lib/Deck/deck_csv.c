@@ -0,0 +1,158 @@
+/* Streaming deck CSV parser **************************************************
+ *                                                                            *
+ *  Handles:                                                                  *
+ *    • quoted and un-quoted fields                                           *
+ *    • embedded commas (anywhere in the back field, quoted in the front)     *
+ *    • embedded CR/LF inside quoted fields                                   *
+ *    • escaped quotes  ""  →  "                                              *
+ *  Lines without a separating comma (blank lines, junk) are skipped.         *
+ *                                                                            *
+ ******************************************************************************/
+
+
+/* Includes *******************************************************************/
+
+#include "deck_csv.h"
+
+
+/* Data structures ************************************************************/
+
+// Position within the current field
+enum{
+    DECK_CSV_FIELD_START,           // Nothing read yet
+    DECK_CSV_UNQUOTED,              // Inside an un-quoted field
+    DECK_CSV_QUOTED,                // Inside a quoted field
+    DECK_CSV_QUOTE,                 // Quote seen inside a quoted field; either
+                                    // the first half of "" or the closing quote
+    DECK_CSV_AFTER_QUOTED           // Closing quote seen, awaiting delimiter
+};
+
+
+/* Functions ******************************************************************/
+
+// Whitespace as understood by the trimming below
+static bool is_space(char c){
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Trim leading/trailing whitespace in place, returns the new start
+static char* trim(char* str){
+    while(is_space(*str)) str++;
+    char* end = str;
+    while(*end) end++;
+    while(end > str && is_space(end[-1])) *--end = '\0';
+    return str;
+}
+
+// Append byte to current field
+//
+//  The front may fill at most half the record, so an over-long front still
+//  leaves the back room. A byte is kept spare for each field's terminator.
+//
+static void append(deck_csv_parser_t* parser, char c){
+    uint16_t limit = parser->field == 0 ? DECK_CSV_MAX_RECORD / 2 - 1
+                                        : DECK_CSV_MAX_RECORD - 1;
+    if(parser->length < limit){
+        parser->record[parser->length++] = c;
+    } else if(!parser->overflowed){
+        parser->overflowed = true;
+        parser->truncated++;
+    }
+}
+
+// Reset for the next record
+static void start_record(deck_csv_parser_t* parser){
+    parser->state = DECK_CSV_FIELD_START;
+    parser->field = 0;
+    parser->length = 0;
+    parser->back = 0;
+    parser->overflowed = false;
+}
+
+// Front field complete
+static void end_front(deck_csv_parser_t* parser){
+    parser->record[parser->length++] = '\0';
+    parser->back = parser->length;
+    parser->field = 1;
+    parser->state = DECK_CSV_FIELD_START;
+}
+
+// Record complete
+static void end_record(deck_csv_parser_t* parser){
+    if(parser->field == 1){
+        parser->record[parser->length] = '\0';
+        char* front = trim(parser->record);
+        char* back = trim(parser->record + parser->back);
+        if(front[0] && back[0]){
+            parser->cards++;
+            if(parser->on_card) parser->on_card(front, back, parser->arg);
+        }
+    }
+    start_record(parser);
+}
+
+// Initialise (or reset) parser
+void deck_csv_init(
+    deck_csv_parser_t* parser,
+    deck_csv_card_callback on_card,
+    void* arg
+){
+    start_record(parser);
+    parser->cards = 0;
+    parser->truncated = 0;
+    parser->on_card = on_card;
+    parser->arg = arg;
+}
+
+// Feed input to parser
+void deck_csv_feed(deck_csv_parser_t* parser, const char* data, size_t len){
+
+    for(size_t i = 0; i < len; i++){
+        char c = data[i];
+        bool newline = (c == '\r' || c == '\n');
+
+        switch(parser->state){
+
+            case DECK_CSV_QUOTE:
+                if(c == '"'){                           // ""  ->  "
+                    append(parser, '"');
+                    parser->state = DECK_CSV_QUOTED;
+                    break;
+                }
+                parser->state = DECK_CSV_AFTER_QUOTED;  // Closing quote
+                // …fall-through to handle delimiter…
+
+            case DECK_CSV_AFTER_QUOTED:
+                if(c == ',' && parser->field == 0) end_front(parser);
+                else if(newline) end_record(parser);
+                break;                                  // Junk is ignored
+
+            case DECK_CSV_QUOTED:
+                if(c == '"') parser->state = DECK_CSV_QUOTE;
+                else append(parser, c);
+                break;
+
+            case DECK_CSV_FIELD_START:
+                if(c == '"'){
+                    parser->state = DECK_CSV_QUOTED;
+                    break;
+                }
+                parser->state = DECK_CSV_UNQUOTED;
+                // …fall-through…
+
+            case DECK_CSV_UNQUOTED:
+                if(c == ',' && parser->field == 0) end_front(parser);
+                else if(newline) end_record(parser);
+                else append(parser, c);
+                break;
+
+        }
+    }
+
+}
+
+// Finish parsing
+uint32_t deck_csv_finish(deck_csv_parser_t* parser){
+    end_record(parser);
+    return parser->cards;
+}
@@ -0,0 +1,97 @@
+/* Streaming deck CSV parser **************************************************
+ *                                                                            *
+ *  Incremental parser for the two column (front,back) CSV decks produced by  *
+ *  the Anki conversion script. Input may be fed in arbitrarily sized pieces  *
+ *  (e.g. straight from lwIP packet buffers); all state needed to resume in   *
+ *  the middle of a field, quote or "" escape is kept in the parser.          *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef DECK_CSV_H
+#define DECK_CSV_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/* Options ********************************************************************/
+
+// Longest record held while parsing
+//
+//  Both fields of a record (after unescaping) plus their terminators must fit,
+//  and the front may use at most half of it; anything beyond is dropped and
+//  the card is kept truncated.
+//
+#define DECK_CSV_MAX_RECORD                         1024            // bytes
+
+
+/* Data structures ************************************************************/
+
+// Card callback
+//
+//  Fired once per complete record with both fields unescaped, trimmed of
+//  surrounding whitespace and NUL-terminated. Records with an empty field are
+//  not reported. The strings are only valid for the duration of the call.
+//
+typedef void (*deck_csv_card_callback)(
+    const char* front,
+    const char* back,
+    void* arg
+);
+
+// Parser state
+//
+//  Treat as opaque; initialise with deck_csv_init().
+//
+typedef struct deck_csv_parser{
+    uint8_t state;                  // Position within the current field
+    uint8_t field;                  // 0 while reading the front, 1 the back
+    bool overflowed;                // Current record has been truncated
+    uint16_t length;                // Bytes used in `record`
+    uint16_t back;                  // Offset of the back field in `record`
+    uint32_t cards;                 // Cards reported so far
+    uint32_t truncated;             // Records that overflowed `record`
+    deck_csv_card_callback on_card;
+    void* arg;
+    char record[DECK_CSV_MAX_RECORD];
+} deck_csv_parser_t;
+
+
+/* Functions ******************************************************************/
+
+// Initialise (or reset) parser
+//
+//  @param parser   Parser to initialise
+//  @param on_card  Callback fired for every parsed card
+//  @param arg      Argument passed through to `on_card`
+//
+void deck_csv_init(
+    deck_csv_parser_t* parser,
+    deck_csv_card_callback on_card,
+    void* arg
+);
+
+// Feed input to parser
+//
+//  May be called any number of times with consecutive pieces of the CSV.
+//
+//  @param parser   Parser
+//  @param data     Next piece of input (need not be NUL-terminated)
+//  @param len      Length of `data`
+//
+void deck_csv_feed(deck_csv_parser_t* parser, const char* data, size_t len);
+
+// Finish parsing
+//
+//  Flushes a final record that was not terminated by a line break (or by a
+//  closing quote). The parser must be re-initialised before further use.
+//
+//  @param parser   Parser
+//
+//  @return         Number of cards reported
+//
+uint32_t deck_csv_finish(deck_csv_parser_t* parser);
+
+
+#endif //DECK_CSV_H
@@ -0,0 +1,89 @@
+/* Deck flash region **********************************************************/
+
+
+/* Includes *******************************************************************/
+
+#include <stdio.h>
+
+#include "pico/flash.h"
+#include "hardware/flash.h"
+#include "hardware/regs/addressmap.h"
+
+#include "deck_flash.h"
+
+
+/* Data structures ************************************************************/
+
+// Argument for the operations run under flash_safe_execute()
+typedef struct{
+    uint32_t offset;                // From the start of flash
+    const uint8_t* data;
+    uint32_t len;
+} deck_flash_op_t;
+
+// End of the program image, from the SDK linker script
+extern char __flash_binary_end;
+
+
+/* Functions ******************************************************************/
+
+static void do_erase(void* arg){
+    deck_flash_op_t* op = arg;
+    flash_range_erase(op->offset, op->len);
+}
+
+static void do_program(void* arg){
+    deck_flash_op_t* op = arg;
+    flash_range_program(op->offset, op->data, op->len);
+}
+
+// Check the reserved region is clear of the program image
+bool deck_flash_init(void){
+    uintptr_t binary_end = (uintptr_t)&__flash_binary_end;
+    if(binary_end > XIP_BASE + DECK_FLASH_OFFSET){
+        printf("Program image overlaps deck flash region\n");
+        return false;
+    }
+    return true;
+}
+
+// Erase part of the region
+bool deck_flash_erase(uint32_t offset, uint32_t len){
+    if(offset + len > DECK_FLASH_SIZE) return false;
+    deck_flash_op_t op = {DECK_FLASH_OFFSET + offset, NULL, len};
+    return flash_safe_execute(do_erase, &op, UINT32_MAX) == PICO_OK;
+}
+
+// Program part of the region
+bool deck_flash_program(uint32_t offset, const uint8_t* data, uint32_t len){
+    if(offset + len > DECK_FLASH_SIZE) return false;
+    deck_flash_op_t op = {DECK_FLASH_OFFSET + offset, data, len};
+    return flash_safe_execute(do_program, &op, UINT32_MAX) == PICO_OK;
+}
+
+// Memory-mapped (XIP) address of part of the region
+const uint8_t* deck_flash_read(uint32_t offset){
+    return (const uint8_t*)(XIP_BASE + DECK_FLASH_OFFSET + offset);
+}
+
+// CRC-32 (IEEE 802.3)
+//
+//  Nibble-wise table; 64 bytes of table is a fair trade against the 1 KB of a
+//  byte-wise one given the amounts checked here.
+//
+uint32_t deck_flash_crc32(uint32_t crc, const void* data, uint32_t len){
+    static const uint32_t table[16] = {
+        0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+        0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+        0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+        0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+    };
+    const uint8_t* bytes = data;
+    crc = ~crc;
+    while(len--){
+        crc ^= *bytes++;
+        crc = (crc >> 4) ^ table[crc & 0x0f];
+        crc = (crc >> 4) ^ table[crc & 0x0f];
+    }
+    return ~crc;
+}
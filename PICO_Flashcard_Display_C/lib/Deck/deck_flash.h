@@ -0,0 +1,80 @@
+/* Deck flash region **********************************************************
+ *                                                                            *
+ *  Reserved area at the top of on-board flash that holds downloaded decks.   *
+ *  Reads go straight through the XIP window; erase and program are wrapped   *
+ *  in flash_safe_execute() so they are safe with the wireless driver's       *
+ *  interrupts running.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef DECK_FLASH_H
+#define DECK_FLASH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "hardware/flash.h"
+
+
+/* Options ********************************************************************/
+
+// Size of the reserved region
+//
+//  Must be a multiple of FLASH_BLOCK_SIZE. The program image must end below
+//  DECK_FLASH_OFFSET; deck_flash_init() checks this at run time.
+//
+#ifndef DECK_FLASH_SIZE
+#define DECK_FLASH_SIZE                             (1024 * 1024)   // bytes
+#endif //DECK_FLASH_SIZE
+
+// Offset of the reserved region from the start of flash
+#define DECK_FLASH_OFFSET                           (PICO_FLASH_SIZE_BYTES - DECK_FLASH_SIZE)
+
+
+/* Functions ******************************************************************/
+
+// Check the reserved region is clear of the program image
+//
+//  @return         `true` if the region may be used
+//
+bool deck_flash_init(void);
+
+// Erase part of the region
+//
+//  @param offset   Offset within the region, multiple of FLASH_SECTOR_SIZE
+//  @param len      Length, multiple of FLASH_SECTOR_SIZE
+//
+//  @return         `true` on success
+//
+bool deck_flash_erase(uint32_t offset, uint32_t len);
+
+// Program part of the region
+//
+//  Target must have been erased.
+//
+//  @param offset   Offset within the region, multiple of FLASH_PAGE_SIZE
+//  @param data     Data to write
+//  @param len      Length, multiple of FLASH_PAGE_SIZE
+//
+//  @return         `true` on success
+//
+bool deck_flash_program(uint32_t offset, const uint8_t* data, uint32_t len);
+
+// Memory-mapped (XIP) address of part of the region
+//
+//  @param offset   Offset within the region
+//
+const uint8_t* deck_flash_read(uint32_t offset);
+
+// CRC-32 (IEEE 802.3)
+//
+//  @param crc      CRC of the preceding data, 0 to start
+//  @param data     Data to add
+//  @param len      Length of `data`
+//
+//  @return         CRC of the preceding data followed by `data`
+//
+uint32_t deck_flash_crc32(uint32_t crc, const void* data, uint32_t len);
+
+
+#endif //DECK_FLASH_H
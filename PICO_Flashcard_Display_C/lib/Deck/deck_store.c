@@ -0,0 +1,320 @@
+/* Deck store *****************************************************************
+ *                                                                            *
+ *  The deck flash region is split into two slots. A new deck is always       *
+ *  written into the slot not holding the current deck, and only becomes      *
+ *  current once its header, written last, is in flash. Losing power part     *
+ *  way through therefore leaves the previous deck intact.                    *
+ *                                                                            *
+ *  Slot layout (see deck_store.h for the structures):                        *
+ *                                                                            *
+ *    DECK_STORE_HEADER   deck_store_header_t, rest of the page erased        *
+ *    DECK_STORE_INDEX    deck_store_entry_t per card                         *
+ *    DECK_STORE_STRINGS  card text, "front\0back\0" packed back to back      *
+ *                                                                            *
+ *  Index and strings are written as two independent streams, each through    *
+ *  its own page buffer. Everything is read in place through XIP, so no RAM   *
+ *  is needed per card.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+
+/* Includes *******************************************************************/
+
+#include <stddef.h>
+#include <string.h>
+
+#include "deck_flash.h"
+#include "deck_store.h"
+
+
+/* Options ********************************************************************/
+
+// Erase step
+//
+//  flash_range_erase() uses the faster 64 KB block erase for aligned ranges,
+//  so erasing in blocks keeps the time spent with interrupts off per byte
+//  written lowest.
+//
+#define DECK_STORE_ERASE_SIZE                       FLASH_BLOCK_SIZE
+
+_Static_assert(DECK_STORE_SLOT_SIZE / DECK_STORE_ERASE_SIZE <= 32, "erase bitmap too small");
+_Static_assert(DECK_STORE_STRINGS % FLASH_PAGE_SIZE == 0, "strings must be page aligned");
+
+
+/* Data structures ************************************************************/
+
+// Sequential writer into the staged slot
+typedef struct{
+    uint32_t offset;                // Slot offset of next byte
+    uint32_t end;                   // Slot offset this stream may not pass
+    uint32_t crc;                   // CRC-32 of everything written
+    uint8_t page[FLASH_PAGE_SIZE];  // Page being filled
+} deck_store_stream_t;
+
+
+/* Data ***********************************************************************/
+
+static const deck_store_header_t* current = NULL;   // Deck being read
+static const deck_store_entry_t* current_index = NULL;
+static const char* current_strings = NULL;
+static int current_slot = -1;
+static uint32_t current_sequence = 0;
+
+static uint32_t slot_base = 0;              // Region offset of staged slot
+static uint32_t erased_blocks = 0;          // Staged slot blocks erased
+static deck_store_stream_t index_stream;
+static deck_store_stream_t strings_stream;
+static uint32_t staged_cards = 0;
+static uint32_t dropped_cards = 0;          // Refused for want of room
+static bool write_failed = false;
+
+
+/* Functions ******************************************************************/
+
+// Slot header in memory-mapped flash
+static const deck_store_header_t* slot_header(uint32_t slot){
+    return (const deck_store_header_t*)deck_flash_read(slot * DECK_STORE_SLOT_SIZE);
+}
+
+// Erase the staged slot block holding `offset`, unless already erased
+static void erase_block(uint32_t offset){
+    uint32_t block = offset / DECK_STORE_ERASE_SIZE;
+    if(write_failed || (erased_blocks & (1u << block))) return;
+    write_failed = !deck_flash_erase(
+        slot_base + block * DECK_STORE_ERASE_SIZE,
+        DECK_STORE_ERASE_SIZE
+    );
+    erased_blocks |= 1u << block;
+}
+
+static void stream_init(deck_store_stream_t* stream, uint32_t start, uint32_t end){
+    stream->offset = start;
+    stream->end = end;
+    stream->crc = 0;
+    memset(stream->page, 0xff, sizeof(stream->page));
+}
+
+// Program the page being filled
+static void stream_flush(deck_store_stream_t* stream){
+    uint32_t page_offset = (stream->offset - 1) & ~(uint32_t)(FLASH_PAGE_SIZE - 1);
+    erase_block(page_offset);
+    if(!write_failed)
+        write_failed = !deck_flash_program(slot_base + page_offset, stream->page, FLASH_PAGE_SIZE);
+    memset(stream->page, 0xff, sizeof(stream->page));
+}
+
+// Append bytes to a stream
+static void stream_write(deck_store_stream_t* stream, const void* data, uint32_t len){
+    const uint8_t* bytes = data;
+    stream->crc = deck_flash_crc32(stream->crc, data, len);
+    while(len){
+        uint32_t used = stream->offset % FLASH_PAGE_SIZE;
+        uint32_t chunk = FLASH_PAGE_SIZE - used;
+        if(chunk > len) chunk = len;
+        memcpy(stream->page + used, bytes, chunk);
+        stream->offset += chunk;
+        bytes += chunk;
+        len -= chunk;
+        if(stream->offset % FLASH_PAGE_SIZE == 0) stream_flush(stream);
+    }
+}
+
+// Check slot header, index and strings
+static bool slot_valid(uint32_t slot){
+    const deck_store_header_t* header = slot_header(slot);
+    if(header->magic != DECK_STORE_MAGIC) return false;
+    if(header->version != DECK_STORE_VERSION) return false;
+    if(header->header_crc != deck_flash_crc32(0, header, offsetof(deck_store_header_t, header_crc)))
+        return false;
+
+    // Layout within slot
+    if(header->index_offset < sizeof(*header)) return false;
+    if(header->cards > DECK_STORE_SLOT_SIZE / sizeof(deck_store_entry_t)) return false;
+    uint32_t index_length = header->cards * sizeof(deck_store_entry_t);
+    if(header->index_offset + index_length > header->strings_offset) return false;
+    if(header->strings_offset > DECK_STORE_SLOT_SIZE) return false;
+    if(header->strings_length > DECK_STORE_SLOT_SIZE - header->strings_offset) return false;
+
+    // Contents
+    uint32_t base = slot * DECK_STORE_SLOT_SIZE;
+    if(header->index_crc != deck_flash_crc32(
+        0,
+        deck_flash_read(base + header->index_offset),
+        index_length
+    )) return false;
+    return header->strings_crc == deck_flash_crc32(
+        0,
+        deck_flash_read(base + header->strings_offset),
+        header->strings_length
+    );
+}
+
+// Make slot the current deck
+static void use_slot(uint32_t slot){
+    uint32_t base = slot * DECK_STORE_SLOT_SIZE;
+    current = slot_header(slot);
+    current_index = (const deck_store_entry_t*)deck_flash_read(base + current->index_offset);
+    current_strings = (const char*)deck_flash_read(base + current->strings_offset);
+    current_slot = slot;
+    current_sequence = current->sequence;
+}
+
+// Load the newest valid deck from flash
+bool deck_store_load(void){
+    current = NULL;
+    current_slot = -1;
+    current_sequence = 0;
+    if(!deck_flash_init()) return false;
+
+    // Pick newest valid slot
+    int newest = -1;
+    for(uint32_t slot = 0; slot < 2; slot++){
+        if(!slot_valid(slot)) continue;
+        if(
+            newest < 0
+            || (int32_t)(slot_header(slot)->sequence - slot_header(newest)->sequence) > 0
+        ) newest = slot;
+    }
+    if(newest < 0) return false;
+
+    use_slot(newest);
+    return current->cards > 0;
+}
+
+// Start a new deck
+bool deck_store_begin(void){
+    slot_base = (current_slot == 0 ? 1 : 0) * DECK_STORE_SLOT_SIZE;
+    erased_blocks = 0;
+    stream_init(&index_stream, DECK_STORE_INDEX, DECK_STORE_STRINGS);
+    stream_init(&strings_stream, DECK_STORE_STRINGS, DECK_STORE_SLOT_SIZE);
+    staged_cards = 0;
+    dropped_cards = 0;
+    write_failed = !deck_flash_init();
+    return !write_failed;
+}
+
+// Append card
+bool deck_store_add(const char* front, const char* back){
+    size_t front_length = strlen(front);
+    size_t back_length = strlen(back);
+
+    if(write_failed) return false;
+    if(
+        front_length > UINT16_MAX || back_length > UINT16_MAX
+        || index_stream.offset + sizeof(deck_store_entry_t) > index_stream.end
+        || strings_stream.offset + front_length + back_length + 2 > strings_stream.end
+    ){
+        dropped_cards++;
+        return false;
+    }
+
+    deck_store_entry_t entry = {
+        .front = strings_stream.offset - DECK_STORE_STRINGS,
+        .front_length = front_length,
+        .back_length = back_length,
+        .hash = deck_flash_crc32(deck_flash_crc32(0, front, front_length + 1), back, back_length + 1)
+    };
+    stream_write(&index_stream, &entry, sizeof(entry));
+    stream_write(&strings_stream, front, front_length + 1);
+    stream_write(&strings_stream, back, back_length + 1);
+    staged_cards++;
+    return !write_failed;
+}
+
+// Cards in the deck being written
+uint32_t deck_store_staged(void){
+    return staged_cards;
+}
+
+// Cards refused for want of room
+uint32_t deck_store_dropped(void){
+    return dropped_cards;
+}
+
+// Copy validator into header field if it fits, otherwise leave empty
+static void copy_validator(char* dest, size_t size, const char* value){
+    size_t len = value ? strlen(value) : 0;
+    memset(dest, 0, size);
+    if(value && len < size) memcpy(dest, value, len);
+}
+
+// Finish the deck
+bool deck_store_finish(const char* etag, const char* last_modified){
+    if(write_failed) return false;
+    if(index_stream.offset % FLASH_PAGE_SIZE) stream_flush(&index_stream);
+    if(strings_stream.offset % FLASH_PAGE_SIZE) stream_flush(&strings_stream);
+    erase_block(DECK_STORE_HEADER);                 // If no index page was written
+
+    // Header last; until it is programmed the slot reads as invalid
+    deck_store_header_t header = {
+        .magic = DECK_STORE_MAGIC,
+        .version = DECK_STORE_VERSION,
+        .sequence = current_sequence + 1,
+        .cards = staged_cards,
+        .index_offset = DECK_STORE_INDEX,
+        .strings_offset = DECK_STORE_STRINGS,
+        .strings_length = strings_stream.offset - DECK_STORE_STRINGS,
+        .index_crc = index_stream.crc,
+        .strings_crc = strings_stream.crc
+    };
+    if(dropped_cards) etag = last_modified = NULL;  // Not the deck they name
+    copy_validator(header.etag, sizeof(header.etag), etag);
+    copy_validator(header.last_modified, sizeof(header.last_modified), last_modified);
+    header.header_crc = deck_flash_crc32(0, &header, offsetof(deck_store_header_t, header_crc));
+    uint8_t page[FLASH_PAGE_SIZE];
+    memset(page, 0xff, sizeof(page));
+    memcpy(page, &header, sizeof(header));
+    if(!write_failed)
+        write_failed = !deck_flash_program(slot_base + DECK_STORE_HEADER, page, FLASH_PAGE_SIZE);
+    if(write_failed) return false;
+
+    // Switch over, if it reads back intact
+    if(!slot_valid(slot_base / DECK_STORE_SLOT_SIZE)) return false;
+    use_slot(slot_base / DECK_STORE_SLOT_SIZE);
+    return true;
+}
+
+// Abandon the deck being written
+void deck_store_abort(void){
+    write_failed = true;
+}
+
+// Number of cards held
+uint32_t deck_count(void){
+    return current ? current->cards : 0;
+}
+
+// HTTP cache validators the current deck was served with
+const char* deck_etag(void){
+    if(!current || !memchr(current->etag, '\0', sizeof(current->etag))) return "";
+    return current->etag;
+}
+
+const char* deck_last_modified(void){
+    if(!current || !memchr(current->last_modified, '\0', sizeof(current->last_modified))) return "";
+    return current->last_modified;
+}
+
+// Card text
+const char* deck_front(uint32_t index){
+    return current_strings + current_index[index].front;
+}
+
+const char* deck_back(uint32_t index){
+    return deck_front(index) + current_index[index].front_length + 1;
+}
+
+// Card content hash
+uint32_t deck_hash(uint32_t index){
+    return current_index[index].hash;
+}
+
+// Find card by content hash
+bool deck_find(uint32_t hash, uint32_t* index){
+    for(uint32_t i = 0; i < deck_count(); i++){
+        if(current_index[i].hash != hash) continue;
+        *index = i;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,200 @@
+/* Deck store *****************************************************************
+ *                                                                            *
+ *  Holds the cards of the current deck. Cards are appended one at a time as  *
+ *  the CSV parser produces them and read back by index.                      *
+ *                                                                            *
+ *  Decks live in the deck flash region (see deck_flash.h) in a read-only     *
+ *  format that is used in place through XIP: a fixed-size index entry per    *
+ *  card followed by packed NUL-terminated strings. RAM use does not depend   *
+ *  on deck size. The last complete deck survives a reboot, so cards can be   *
+ *  shown before the network is up.                                           *
+ *                                                                            *
+ *  The same image can be built on a host with csvToDeckImage.py.             *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef DECK_STORE_H
+#define DECK_STORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "deck_flash.h"
+
+
+/* Options ********************************************************************/
+
+// Slot size
+//
+//  The deck flash region holds two slots, the current deck and the one
+//  being downloaded.
+//
+#define DECK_STORE_SLOT_SIZE                        (DECK_FLASH_SIZE / 2)
+
+// Slot layout
+//
+//  Offsets from the start of a slot. The index area bounds the number of
+//  cards: (DECK_STORE_STRINGS - DECK_STORE_INDEX) / 12, i.e. 10901.
+//
+#define DECK_STORE_HEADER                           0
+#define DECK_STORE_INDEX                            FLASH_PAGE_SIZE
+#define DECK_STORE_STRINGS                          (128 * 1024)
+
+// Header identification
+#define DECK_STORE_MAGIC                            0x4b434544      // "DECK"
+#define DECK_STORE_VERSION                          4
+
+// Stored HTTP cache validator sizes (including terminator)
+#define DECK_STORE_ETAG_SIZE                        128             // bytes
+#define DECK_STORE_LAST_MODIFIED_SIZE               32              // bytes
+
+
+/* Data structures ************************************************************/
+
+// Slot header
+//
+//  All fields little-endian. Offsets are from the start of the slot.
+//
+typedef struct{
+    uint32_t magic;                 // DECK_STORE_MAGIC
+    uint32_t version;               // DECK_STORE_VERSION
+    uint32_t sequence;              // Incremented per deck; newest wins
+    uint32_t cards;                 // Number of index entries
+    uint32_t index_offset;          // Offset of the index
+    uint32_t strings_offset;        // Offset of the strings
+    uint32_t strings_length;        // Bytes of strings
+    uint32_t index_crc;             // CRC-32 of the index entries
+    uint32_t strings_crc;           // CRC-32 of the strings
+    char etag[DECK_STORE_ETAG_SIZE];                    // ETag the deck was
+                                                        // served with, or ""
+    char last_modified[DECK_STORE_LAST_MODIFIED_SIZE];  // Likewise
+                                                        // Last-Modified
+    uint32_t header_crc;            // CRC-32 of the fields above
+} deck_store_header_t;
+
+_Static_assert(sizeof(deck_store_header_t) <= DECK_STORE_INDEX, "header overlaps index");
+
+// Index entry
+//
+//  The back text immediately follows the front text's terminator.
+//
+typedef struct{
+    uint32_t front;                 // Offset of front text from the strings
+    uint16_t front_length;          // Excluding terminator
+    uint16_t back_length;           // Excluding terminator
+    uint32_t hash;                  // CRC-32 of "front\0back\0"
+} deck_store_entry_t;
+
+
+/* Functions ******************************************************************/
+
+// Load deck saved in flash
+//
+//  Picks the newest deck whose header and records check out; a deck that was
+//  being written when power was lost is ignored.
+//
+//  @return         `true` if a non-empty deck was loaded
+//
+bool deck_store_load(void);
+
+// Start a new deck
+//
+//  The new deck is written alongside the current one, which stays readable
+//  until deck_store_finish() succeeds. Flash is erased lazily as cards are
+//  added.
+//
+//  @return         `true` on success
+//
+bool deck_store_begin(void);
+
+// Append card
+//
+//  Strings are copied into the store.
+//
+//  @param front    Front text (NUL-terminated)
+//  @param back     Back text (NUL-terminated)
+//
+//  @return         `true` on success, `false` if the card was dropped (see
+//                  deck_store_dropped()) or a flash operation failed
+//
+bool deck_store_add(const char* front, const char* back);
+
+// Cards added to the deck being written
+//
+//  @return         Cards accepted by deck_store_add() since deck_store_begin()
+//
+uint32_t deck_store_staged(void);
+
+// Cards refused for want of room
+//
+//  @return         Cards deck_store_add() dropped since deck_store_begin()
+//                  because the slot's index or string area was full (or the
+//                  card was too long to index)
+//
+uint32_t deck_store_dropped(void);
+
+// Finish the deck
+//
+//  Writes out the final partial pages and then the header, and checks the
+//  new deck back from flash. Only then does it replace the current one (and
+//  become what deck_store_load() will find after a reboot). Cards of the
+//  current deck are valid up to this point, so the deck can be read while a
+//  new one is written.
+//
+//  Validators are not stored with a deck that lost cards (see
+//  deck_store_dropped()): they name the whole deck, and a conditional
+//  request made with them would keep the truncated one forever.
+//
+//  @param etag     ETag the deck was served with, "" or NULL if none; values
+//                  too long to store are dropped
+//  @param last_modified
+//                  Likewise Last-Modified
+//
+//  @return         `true` if the deck was committed
+//
+bool deck_store_finish(const char* etag, const char* last_modified);
+
+// Abandon the deck being written
+//
+//  The current deck is kept.
+//
+void deck_store_abort(void);
+
+// Number of cards held
+uint32_t deck_count(void);
+
+// HTTP cache validators the current deck was served with
+//
+//  @return         NUL-terminated value, "" if none or no deck
+//
+const char* deck_etag(void);
+const char* deck_last_modified(void);
+
+// Card text
+//
+//  @param index    Card index, less than deck_count()
+//
+//  @return         NUL-terminated text in memory-mapped flash
+//
+const char* deck_front(uint32_t index);
+const char* deck_back(uint32_t index);
+
+// Card content hash
+//
+//  Identifies a card across decks, as long as its text is unchanged.
+//
+//  @param index    Card index, less than deck_count()
+//
+uint32_t deck_hash(uint32_t index);
+
+// Find card by content hash
+//
+//  @param hash     Hash as returned by deck_hash()
+//  @param index    Set to the index of the first card with that hash
+//
+//  @return         `true` if found
+//
+bool deck_find(uint32_t hash, uint32_t* index);
+
+
+#endif //DECK_STORE_H
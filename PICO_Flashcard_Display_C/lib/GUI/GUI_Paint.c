@@ -7,6 +7,12 @@
 #include <math.h>
 
 PAINT Paint;
+static UBYTE Paint_DirtyRows[PAINT_DIRTY_MAX_ROWS / 8];
+
+static void Paint_SelectPixelWriter(void);
+
+#define PAINT_MARK_DIRTY(Y) \
+    do { if ((Y) < PAINT_DIRTY_MAX_ROWS) Paint_DirtyRows[(Y) >> 3] |= 1 << ((Y) & 7); } while (0)
 
 /******************************************************************************
 function: Create Image
@@ -44,6 +50,11 @@ void Paint_NewImage(UBYTE *image, UWORD Width, UWORD Height, UWORD Rotate, UWORD
         Paint.Width = Height;
         Paint.Height = Width;
     }
+
+    Paint_SelectPixelWriter();
+
+    // Nothing is known about what the panel shows yet
+    Paint_MarkDirty(0, Height);
 }
 
 /******************************************************************************
@@ -54,6 +65,35 @@ parameter:
 void Paint_SelectImage(UBYTE *image)
 {
     Paint.Image = image;
+    Paint_MarkDirty(0, Paint.HeightMemory);
+}
+
+/******************************************************************************
+function: Forget the dirty rows, e.g. once they have been sent to the panel
+******************************************************************************/
+void Paint_ClearDirty(void)
+{
+    memset(Paint_DirtyRows, 0, sizeof(Paint_DirtyRows));
+}
+
+/******************************************************************************
+function: Mark image memory rows as dirty
+parameter:
+    Ystart : first memory row
+    Yend   : one past the last memory row
+******************************************************************************/
+void Paint_MarkDirty(UWORD Ystart, UWORD Yend)
+{
+    for (UWORD Y = Ystart; Y < Yend; Y++)
+        PAINT_MARK_DIRTY(Y);
+}
+
+/******************************************************************************
+function: Get the dirty row bitmap, one bit per memory row, LSB first
+******************************************************************************/
+const UBYTE *Paint_GetDirtyRows(void)
+{
+    return Paint_DirtyRows;
 }
 
 /******************************************************************************
@@ -67,6 +107,7 @@ void Paint_SetRotate(UWORD Rotate)
     {
         Debug("Set image Rotate %d\r\n", Rotate);
         Paint.Rotate = Rotate;
+        Paint_SelectPixelWriter();
     }
     else
     {
@@ -100,7 +141,9 @@ void Paint_SetScale(UBYTE scale)
     {
         Debug("Set Scale Input parameter error\r\n");
         Debug("Scale Only support: 2 4 16 65\r\n");
+        return;
     }
+    Paint_SelectPixelWriter();
 }
 /******************************************************************************
 function:	Select Image mirror
@@ -114,6 +157,7 @@ void Paint_SetMirroring(UBYTE mirror)
     {
         Debug("mirror image x:%s, y:%s\r\n", (mirror & 0x01) ? "mirror" : "none", ((mirror >> 1) & 0x01) ? "mirror" : "none");
         Paint.Mirror = mirror;
+        Paint_SelectPixelWriter();
     }
     else
     {
@@ -123,99 +167,158 @@ void Paint_SetMirroring(UBYTE mirror)
 }
 
 /******************************************************************************
-function: Draw Pixels
-parameter:
-    Xpoint : At point X
-    Ypoint : At point Y
-    Color  : Painted colors
+Pixel writers
+    One writer per rotation x mirror x scale combination, generated below,
+    so drawing a pixel costs a single indirect call through Paint.SetPixel
+    instead of re-deciding the rotation, mirroring and bit depth each time.
+    Paint_SelectPixelWriter picks the writer whenever one of those changes.
 ******************************************************************************/
-void Paint_SetPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color)
-{
-    if (Xpoint > Paint.Width || Ypoint > Paint.Height)
-    {
-        Debug("Exceeding display boundaries\r\n");
-        return;
-    }
-    UWORD X, Y;
+#define PAINT_ROTATE_0(Xpoint, Ypoint)   X = Xpoint; Y = Ypoint;
+#define PAINT_ROTATE_90(Xpoint, Ypoint)  X = Paint.WidthMemory - Ypoint - 1; Y = Xpoint;
+#define PAINT_ROTATE_180(Xpoint, Ypoint) X = Paint.WidthMemory - Xpoint - 1; Y = Paint.HeightMemory - Ypoint - 1;
+#define PAINT_ROTATE_270(Xpoint, Ypoint) X = Ypoint; Y = Paint.HeightMemory - Xpoint - 1;
 
-    switch (Paint.Rotate)
-    {
-    case 0:
-        X = Xpoint;
-        Y = Ypoint;
-        break;
-    case 90:
-        X = Paint.WidthMemory - Ypoint - 1;
-        Y = Xpoint;
-        break;
-    case 180:
-        X = Paint.WidthMemory - Xpoint - 1;
-        Y = Paint.HeightMemory - Ypoint - 1;
-        break;
-    case 270:
-        X = Ypoint;
-        Y = Paint.HeightMemory - Xpoint - 1;
-        break;
-    default:
-        return;
-    }
+#define PAINT_MIRROR_0
+#define PAINT_MIRROR_1  X = Paint.WidthMemory - X - 1;
+#define PAINT_MIRROR_2  Y = Paint.HeightMemory - Y - 1;
+#define PAINT_MIRROR_3  X = Paint.WidthMemory - X - 1; Y = Paint.HeightMemory - Y - 1;
 
-    switch (Paint.Mirror)
-    {
-    case MIRROR_NONE:
-        break;
-    case MIRROR_HORIZONTAL:
-        X = Paint.WidthMemory - X - 1;
-        break;
-    case MIRROR_VERTICAL:
-        Y = Paint.HeightMemory - Y - 1;
-        break;
-    case MIRROR_ORIGIN:
-        X = Paint.WidthMemory - X - 1;
-        Y = Paint.HeightMemory - Y - 1;
-        break;
-    default:
-        return;
+#define PAINT_STORE_2(X, Y, Color)                                      \
+    {                                                                   \
+        UDOUBLE Addr = X / 8 + Y * Paint.WidthByte;                     \
+        UBYTE Rdata = Paint.Image[Addr];                                \
+        UBYTE Wdata;                                                    \
+        if ((Color & 0xff) == BLACK)                                    \
+            Wdata = Rdata & ~(0x80 >> (X % 8));                         \
+        else                                                            \
+            Wdata = Rdata | (0x80 >> (X % 8));                          \
+        if (Wdata != Rdata)                                             \
+        {                                                               \
+            Paint.Image[Addr] = Wdata;                                  \
+            PAINT_MARK_DIRTY(Y);                                        \
+        }                                                               \
     }
 
-    if (X > Paint.WidthMemory || Y > Paint.HeightMemory)
-    {
-        Debug("Exceeding display boundaries\r\n");
-        return;
+#define PAINT_STORE_4(X, Y, Color)                                      \
+    {                                                                   \
+        UDOUBLE Addr = X / 4 + Y * Paint.WidthByte;                     \
+        UBYTE Rdata = Paint.Image[Addr];                                \
+        UBYTE Wdata = Rdata & (~(0xC0 >> ((X % 4) * 2)));               \
+        Wdata = Wdata | (((Color % 4) << 6) >> ((X % 4) * 2));          \
+        if (Wdata != Rdata)                                             \
+        {                                                               \
+            Paint.Image[Addr] = Wdata;                                  \
+            PAINT_MARK_DIRTY(Y);                                        \
+        }                                                               \
     }
 
-    if (Paint.Scale == 2)
-    {
-        UDOUBLE Addr = X / 8 + Y * Paint.WidthByte;
-        UBYTE Rdata = Paint.Image[Addr];
-        if ((Color & 0xff) == BLACK)
-            Paint.Image[Addr] = Rdata & ~(0x80 >> (X % 8));
-        else
-            Paint.Image[Addr] = Rdata | (0x80 >> (X % 8));
+#define PAINT_STORE_16(X, Y, Color)                                     \
+    {                                                                   \
+        UDOUBLE Addr = X / 2 + Y * Paint.WidthByte;                     \
+        UBYTE Rdata = Paint.Image[Addr];                                \
+        Rdata = Rdata & (~(0xf0 >> ((X % 2) * 4)));                     \
+        Paint.Image[Addr] = Rdata | (((Color % 16) << 4) >> ((X % 2) * 4)); \
+        PAINT_MARK_DIRTY(Y);                                            \
     }
-    else if (Paint.Scale == 4)
-    {
-        UDOUBLE Addr = X / 4 + Y * Paint.WidthByte;
-        Color = Color % 4; // Guaranteed color scale is 4  --- 0~3
-        UBYTE Rdata = Paint.Image[Addr];
 
-        Rdata = Rdata & (~(0xC0 >> ((X % 4) * 2)));
-        Paint.Image[Addr] = Rdata | ((Color << 6) >> ((X % 4) * 2));
+#define PAINT_STORE_65(X, Y, Color)                                     \
+    {                                                                   \
+        UDOUBLE Addr = X * 2 + Y * Paint.WidthByte;                     \
+        Paint.Image[Addr] = 0xff & (Color >> 8);                        \
+        Paint.Image[Addr + 1] = 0xff & Color;                           \
+        PAINT_MARK_DIRTY(Y);                                            \
     }
-    else if (Paint.Scale == 16)
-    {
-        UDOUBLE Addr = X / 2 + Y * Paint.WidthByte;
-        UBYTE Rdata = Paint.Image[Addr];
-        Color = Color % 16;
-        Rdata = Rdata & (~(0xf0 >> ((X % 2) * 4)));
-        Paint.Image[Addr] = Rdata | ((Color << 4) >> ((X % 2) * 4));
+
+// Any in-range logical point maps inside the image memory, so the single
+// bounds check up front is enough
+#define PAINT_PIXEL_WRITER(R, M, S)                                                         \
+    static void Paint_SetPixel_R##R##_M##M##_S##S(UWORD Xpoint, UWORD Ypoint, UWORD Color) \
+    {                                                                                       \
+        UWORD X, Y;                                                                         \
+        if (Xpoint >= Paint.Width || Ypoint >= Paint.Height)                                \
+        {                                                                                   \
+            Debug("Exceeding display boundaries\r\n");                                      \
+            return;                                                                         \
+        }                                                                                   \
+        PAINT_ROTATE_##R(Xpoint, Ypoint)                                                    \
+        PAINT_MIRROR_##M                                                                    \
+        PAINT_STORE_##S(X, Y, Color)                                                        \
     }
-    else if (Paint.Scale == 65)
+
+#define PAINT_PIXEL_WRITERS_SCALE(R, M) \
+    PAINT_PIXEL_WRITER(R, M, 2)         \
+    PAINT_PIXEL_WRITER(R, M, 4)         \
+    PAINT_PIXEL_WRITER(R, M, 16)        \
+    PAINT_PIXEL_WRITER(R, M, 65)
+
+#define PAINT_PIXEL_WRITERS_MIRROR(R)  \
+    PAINT_PIXEL_WRITERS_SCALE(R, 0)     \
+    PAINT_PIXEL_WRITERS_SCALE(R, 1)     \
+    PAINT_PIXEL_WRITERS_SCALE(R, 2)     \
+    PAINT_PIXEL_WRITERS_SCALE(R, 3)
+
+PAINT_PIXEL_WRITERS_MIRROR(0)
+PAINT_PIXEL_WRITERS_MIRROR(90)
+PAINT_PIXEL_WRITERS_MIRROR(180)
+PAINT_PIXEL_WRITERS_MIRROR(270)
+
+#define PAINT_PIXEL_ENTRY_SCALE(R, M) \
+    { Paint_SetPixel_R##R##_M##M##_S2, Paint_SetPixel_R##R##_M##M##_S4, \
+      Paint_SetPixel_R##R##_M##M##_S16, Paint_SetPixel_R##R##_M##M##_S65 }
+
+#define PAINT_PIXEL_ENTRY_MIRROR(R) \
+    { PAINT_PIXEL_ENTRY_SCALE(R, 0), PAINT_PIXEL_ENTRY_SCALE(R, 1), \
+      PAINT_PIXEL_ENTRY_SCALE(R, 2), PAINT_PIXEL_ENTRY_SCALE(R, 3) }
+
+// [Rotate / 90][Mirror][Scale 2, 4, 16, 65]
+static PAINT_PIXEL_FN const Paint_PixelWriters[4][4][4] = {
+    PAINT_PIXEL_ENTRY_MIRROR(0),
+    PAINT_PIXEL_ENTRY_MIRROR(90),
+    PAINT_PIXEL_ENTRY_MIRROR(180),
+    PAINT_PIXEL_ENTRY_MIRROR(270),
+};
+
+// Used while the rotation is not one of 0/90/180/270: draws nothing
+static void Paint_SetPixel_None(UWORD Xpoint, UWORD Ypoint, UWORD Color)
+{
+    Debug("Invalid rotation, pixel dropped\r\n");
+}
+
+static void Paint_SelectPixelWriter(void)
+{
+    UBYTE S;
+    switch (Paint.Scale)
     {
-        UDOUBLE Addr = X * 2 + Y * Paint.WidthByte;
-        Paint.Image[Addr] = 0xff & (Color >> 8);
-        Paint.Image[Addr + 1] = 0xff & Color;
+    case 4:
+        S = 1;
+        break;
+    case 16:
+        S = 2;
+        break;
+    case 65:
+        S = 3;
+        break;
+    default:
+        S = 0;
+        break;
     }
+
+    if (Paint.Rotate % 90 != 0 || Paint.Rotate > ROTATE_270 || Paint.Mirror > MIRROR_ORIGIN)
+        Paint.SetPixel = Paint_SetPixel_None;
+    else
+        Paint.SetPixel = Paint_PixelWriters[Paint.Rotate / 90][Paint.Mirror][S];
+}
+
+/******************************************************************************
+function: Draw Pixels
+parameter:
+    Xpoint : At point X
+    Ypoint : At point Y
+    Color  : Painted colors
+******************************************************************************/
+void Paint_SetPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color)
+{
+    Paint.SetPixel(Xpoint, Ypoint, Color);
 }
 
 /******************************************************************************
@@ -227,14 +330,21 @@ void Paint_Clear(UWORD Color)
 {
     if (Paint.Scale == 2 || Paint.Scale == 4)
     {
+        // Whole rows are memset; only rows that actually change are marked dirty
         for (UWORD Y = 0; Y < Paint.HeightByte; Y++)
         {
+            UBYTE *Row = Paint.Image + (UDOUBLE)Y * Paint.WidthByte;
             for (UWORD X = 0; X < Paint.WidthByte; X++)
-            { // 8 pixel =  1 byte
-                UDOUBLE Addr = X + Y * Paint.WidthByte;
-                Paint.Image[Addr] = Color;
+            {
+                if (Row[X] != (UBYTE)Color)
+                {
+                    memset(Row, (UBYTE)Color, Paint.WidthByte);
+                    PAINT_MARK_DIRTY(Y);
+                    break;
+                }
             }
         }
+        return;
     }
     else if (Paint.Scale == 16)
     {
@@ -260,6 +370,155 @@ void Paint_Clear(UWORD Color)
             }
         }
     }
+    Paint_MarkDirty(0, Paint.HeightByte);
+}
+
+/******************************************************************************
+function: Fill part of one image memory row
+parameter:
+    Y       : memory row
+    Xstart  : first memory pixel
+    Xend    : last memory pixel (inclusive)
+    Pattern : colour replicated across a whole byte
+    Bpp     : bits per pixel, 1 (Scale 2) or 2 (Scale 4)
+info:
+    The leading and trailing partial bytes are merged through masks and the
+    bytes in between are memset.
+******************************************************************************/
+static void Paint_FillSpan(UWORD Y, UWORD Xstart, UWORD Xend, UBYTE Pattern, UBYTE Bpp)
+{
+    UDOUBLE BitStart = (UDOUBLE)Xstart * Bpp;
+    UDOUBLE BitEnd = ((UDOUBLE)Xend + 1) * Bpp; // one past the last bit
+    UBYTE *Row = Paint.Image + (UDOUBLE)Y * Paint.WidthByte;
+    UWORD First = BitStart / 8;
+    UWORD Last = (BitEnd - 1) / 8;
+    UBYTE HeadMask = 0xFF >> (BitStart % 8);
+    UBYTE TailMask = 0xFF << ((8 - BitEnd % 8) % 8);
+    bool Changed = false;
+
+    if (First == Last)
+        HeadMask &= TailMask;
+
+    UBYTE Wdata = (Row[First] & ~HeadMask) | (Pattern & HeadMask);
+    if (Wdata != Row[First])
+    {
+        Row[First] = Wdata;
+        Changed = true;
+    }
+    if (First != Last)
+    {
+        for (UWORD i = First + 1; i < Last; i++)
+        {
+            if (Row[i] != Pattern)
+            {
+                memset(Row + i, Pattern, Last - i);
+                Changed = true;
+                break;
+            }
+        }
+        Wdata = (Row[Last] & ~TailMask) | (Pattern & TailMask);
+        if (Wdata != Row[Last])
+        {
+            Row[Last] = Wdata;
+            Changed = true;
+        }
+    }
+
+    if (Changed)
+        PAINT_MARK_DIRTY(Y);
+}
+
+/******************************************************************************
+function: Map a logical point to image memory for the current rotation and
+          mirroring (the point must lie inside the image)
+******************************************************************************/
+static void Paint_MapPoint(UWORD Xpoint, UWORD Ypoint, UWORD *Xmem, UWORD *Ymem)
+{
+    UWORD X, Y;
+    switch (Paint.Rotate)
+    {
+    case ROTATE_90:
+        PAINT_ROTATE_90(Xpoint, Ypoint)
+        break;
+    case ROTATE_180:
+        PAINT_ROTATE_180(Xpoint, Ypoint)
+        break;
+    case ROTATE_270:
+        PAINT_ROTATE_270(Xpoint, Ypoint)
+        break;
+    default:
+        PAINT_ROTATE_0(Xpoint, Ypoint)
+        break;
+    }
+    if (Paint.Mirror & MIRROR_HORIZONTAL)
+        X = Paint.WidthMemory - X - 1;
+    if (Paint.Mirror & MIRROR_VERTICAL)
+        Y = Paint.HeightMemory - Y - 1;
+    *Xmem = X;
+    *Ymem = Y;
+}
+
+/******************************************************************************
+function: Fill a logical rectangle, clipped to the image
+parameter:
+    Xstart, Ystart : top left corner
+    Xend, Yend     : bottom right corner (inclusive)
+info:
+    Any rotation/mirror maps a rectangle onto a rectangle in memory, so for
+    Scale 2 and 4 it is filled as one span per memory row. Other scales go
+    through the pixel writer.
+******************************************************************************/
+static void Paint_FillRect(int Xstart, int Ystart, int Xend, int Yend, UWORD Color)
+{
+    if (Xstart < 0)
+        Xstart = 0;
+    if (Ystart < 0)
+        Ystart = 0;
+    if (Xend >= Paint.Width)
+        Xend = Paint.Width - 1;
+    if (Yend >= Paint.Height)
+        Yend = Paint.Height - 1;
+    if (Xstart > Xend || Ystart > Yend)
+        return;
+
+    if ((Paint.Scale != 2 && Paint.Scale != 4) || Paint.SetPixel == Paint_SetPixel_None)
+    {
+        for (int Y = Ystart; Y <= Yend; Y++)
+            for (int X = Xstart; X <= Xend; X++)
+                Paint.SetPixel(X, Y, Color);
+        return;
+    }
+
+    UBYTE Pattern, Bpp;
+    if (Paint.Scale == 2)
+    {
+        Bpp = 1;
+        Pattern = ((Color & 0xff) == BLACK) ? 0x00 : 0xFF;
+    }
+    else
+    {
+        Bpp = 2;
+        Pattern = (Color % 4) * 0x55;
+    }
+
+    UWORD X0, Y0, X1, Y1;
+    Paint_MapPoint(Xstart, Ystart, &X0, &Y0);
+    Paint_MapPoint(Xend, Yend, &X1, &Y1);
+    if (X0 > X1)
+    {
+        UWORD T = X0;
+        X0 = X1;
+        X1 = T;
+    }
+    if (Y0 > Y1)
+    {
+        UWORD T = Y0;
+        Y0 = Y1;
+        Y1 = T;
+    }
+
+    for (UWORD Y = Y0; Y <= Y1; Y++)
+        Paint_FillSpan(Y, X0, X1, Pattern, Bpp);
 }
 
 /******************************************************************************
@@ -273,14 +532,7 @@ parameter:
 ******************************************************************************/
 void Paint_ClearWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color)
 {
-    UWORD X, Y;
-    for (Y = Ystart; Y < Yend; Y++)
-    {
-        for (X = Xstart; X < Xend; X++)
-        { // 8 pixel =  1 byte
-            Paint_SetPixel(X, Y, Color);
-        }
-    }
+    Paint_FillRect(Xstart, Ystart, (int)Xend - 1, (int)Yend - 1, Color);
 }
 
 /******************************************************************************
@@ -313,7 +565,7 @@ void Paint_DrawPoint(UWORD Xpoint, UWORD Ypoint, UWORD Color,
                 if (Xpoint + XDir_Num - Dot_Pixel < 0 || Ypoint + YDir_Num - Dot_Pixel < 0)
                     break;
                 // printf("x = %d, y = %d\r\n", Xpoint + XDir_Num - Dot_Pixel, Ypoint + YDir_Num - Dot_Pixel);
-                Paint_SetPixel(Xpoint + XDir_Num - Dot_Pixel, Ypoint + YDir_Num - Dot_Pixel, Color);
+                Paint.SetPixel(Xpoint + XDir_Num - Dot_Pixel, Ypoint + YDir_Num - Dot_Pixel, Color);
             }
         }
     }
@@ -323,7 +575,7 @@ void Paint_DrawPoint(UWORD Xpoint, UWORD Ypoint, UWORD Color,
         {
             for (YDir_Num = 0; YDir_Num < Dot_Pixel; YDir_Num++)
             {
-                Paint_SetPixel(Xpoint + XDir_Num - 1, Ypoint + YDir_Num - 1, Color);
+                Paint.SetPixel(Xpoint + XDir_Num - 1, Ypoint + YDir_Num - 1, Color);
             }
         }
     }
@@ -420,10 +672,17 @@ void Paint_DrawRectangle(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
 
     if (Draw_Fill)
     {
-        UWORD Ypoint;
-        for (Ypoint = Ystart; Ypoint < Yend; Ypoint++)
+        // Same pixels as one Paint_DrawLine per row from Ystart to Yend - 1:
+        // each point of width w covers [x - w, x + w - 2] x [y - w, y + w - 2],
+        // clipped to the image. (Paint_DrawPoint's "< 0" test never fires:
+        // DOT_PIXEL is unsigned, so the sum wraps and the pixel writer's
+        // bounds check does the clipping.)
+        int Xlow = Xstart < Xend ? Xstart : Xend;
+        int Xhigh = Xstart < Xend ? Xend : Xstart;
+        if (Ystart < Yend)
         {
-            Paint_DrawLine(Xstart, Ypoint, Xend, Ypoint, Color, Line_width, LINE_STYLE_SOLID);
+            Paint_FillRect(Xlow - Line_width, Ystart - Line_width,
+                           Xhigh + Line_width - 2, Yend - 1 + Line_width - 2, Color);
         }
     }
     else
@@ -514,6 +773,54 @@ void Paint_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius,
     }
 }
 
+/******************************************************************************
+function: Byte-aligned glyph blitter for ROTATE_0, MIRROR_NONE, Scale 2
+info:
+    Each glyph row is widened to a 32-bit word, coloured, shifted to the
+    pixel offset of Xpoint and merged into the (at most 4) framebuffer
+    bytes it covers. Output matches the per-pixel path; the caller makes
+    sure the whole glyph lies inside the image.
+******************************************************************************/
+static void Paint_DrawChar_Fast(UWORD Xpoint, UWORD Ypoint, const unsigned char *ptr,
+                                sFONT *Font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    UWORD RowBytes = Font->Width / 8 + (Font->Width % 8 ? 1 : 0);
+    UDOUBLE GlyphMask = 0xFFFFFFFFu << (32 - Font->Width);
+    // Set font bits take Color_Background, clear ones Color_Foreground
+    UDOUBLE SetBits = ((Color_Background & 0xff) == BLACK) ? 0 : GlyphMask;
+    UDOUBLE ClearBits = ((Color_Foreground & 0xff) == BLACK) ? 0 : GlyphMask;
+    UBYTE Shift = Xpoint % 8;
+    UBYTE Span = (Shift + Font->Width + 7) / 8;
+    UDOUBLE Mask = GlyphMask >> Shift;
+    UBYTE *Row = Paint.Image + Xpoint / 8 + (UDOUBLE)Ypoint * Paint.WidthByte;
+
+    for (UWORD Page = 0; Page < Font->Height; Page++)
+    {
+        UDOUBLE Bits = 0;
+        for (UWORD i = 0; i < RowBytes; i++)
+            Bits |= (UDOUBLE)ptr[i] << (24 - 8 * i);
+        ptr += RowBytes;
+
+        Bits = ((Bits & SetBits) | (~Bits & ClearBits)) >> Shift;
+
+        bool Changed = false;
+        for (UBYTE i = 0; i < Span; i++)
+        {
+            UBYTE M = Mask >> (24 - 8 * i);
+            UBYTE Rdata = Row[i];
+            UBYTE Wdata = (Rdata & ~M) | ((Bits >> (24 - 8 * i)) & M);
+            if (Wdata != Rdata)
+            {
+                Row[i] = Wdata;
+                Changed = true;
+            }
+        }
+        if (Changed)
+            PAINT_MARK_DIRTY(Ypoint + Page);
+        Row += Paint.WidthByte;
+    }
+}
+
 /******************************************************************************
 function: Show English characters
 parameter:
@@ -538,6 +845,14 @@ void Paint_DrawChar(UWORD Xpoint, UWORD Ypoint, const char Acsii_Char,
     uint32_t Char_Offset = (Acsii_Char - ' ') * Font->Height * (Font->Width / 8 + (Font->Width % 8 ? 1 : 0));
     const unsigned char *ptr = &Font->table[Char_Offset];
 
+    if (Paint.Rotate == ROTATE_0 && Paint.Mirror == MIRROR_NONE && Paint.Scale == 2 &&
+        Font->Width <= 25 &&
+        Xpoint + Font->Width <= Paint.Width && Ypoint + Font->Height <= Paint.Height)
+    {
+        Paint_DrawChar_Fast(Xpoint, Ypoint, ptr, Font, Color_Foreground, Color_Background);
+        return;
+    }
+
     for (Page = 0; Page < Font->Height; Page++)
     {
         for (Column = 0; Column < Font->Width; Column++)
@@ -546,12 +861,12 @@ void Paint_DrawChar(UWORD Xpoint, UWORD Ypoint, const char Acsii_Char,
             // To determine whether the font background color and screen background color is consistent
             if (*ptr & (0x80 >> (Column % 8)))
             {
-                Paint_SetPixel(Xpoint + Column, Ypoint + Page, Color_Background);
+                Paint.SetPixel(Xpoint + Column, Ypoint + Page, Color_Background);
                 // Paint_DrawPoint(Xpoint + Column, Ypoint + Page, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
             }
             else
             {
-                Paint_SetPixel(Xpoint + Column, Ypoint + Page, Color_Foreground);
+                Paint.SetPixel(Xpoint + Column, Ypoint + Page, Color_Foreground);
                 // Paint_DrawPoint(Xpoint + Column, Ypoint + Page, Color_Background, DOT_PIXEL_DFT, DOT_STYLE_DFT);
             }
             // One pixel is 8 bits
@@ -647,7 +962,7 @@ void Paint_DrawString_CN(UWORD Xstart, UWORD Ystart, const char *pString, cFONT
                             { // this process is to speed up the scan
                                 if (*ptr & (0x80 >> (i % 8)))
                                 {
-                                    Paint_SetPixel(x + i, y + j, Color_Foreground);
+                                    Paint.SetPixel(x + i, y + j, Color_Foreground);
                                     // Paint_DrawPoint(x + i, y + j, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
                                 }
                             }
@@ -655,12 +970,12 @@ void Paint_DrawString_CN(UWORD Xstart, UWORD Ystart, const char *pString, cFONT
                             {
                                 if (*ptr & (0x80 >> (i % 8)))
                                 {
-                                    Paint_SetPixel(x + i, y + j, Color_Foreground);
+                                    Paint.SetPixel(x + i, y + j, Color_Foreground);
                                     // Paint_DrawPoint(x + i, y + j, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
                                 }
                                 else
                                 {
-                                    Paint_SetPixel(x + i, y + j, Color_Background);
+                                    Paint.SetPixel(x + i, y + j, Color_Background);
                                     // Paint_DrawPoint(x + i, y + j, Color_Background, DOT_PIXEL_DFT, DOT_STYLE_DFT);
                                 }
                             }
@@ -698,7 +1013,7 @@ void Paint_DrawString_CN(UWORD Xstart, UWORD Ystart, const char *pString, cFONT
                             { // this process is to speed up the scan
                                 if (*ptr & (0x80 >> (i % 8)))
                                 {
-                                    Paint_SetPixel(x + i, y + j, Color_Foreground);
+                                    Paint.SetPixel(x + i, y + j, Color_Foreground);
                                     // Paint_DrawPoint(x + i, y + j, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
                                 }
                             }
@@ -706,12 +1021,12 @@ void Paint_DrawString_CN(UWORD Xstart, UWORD Ystart, const char *pString, cFONT
                             {
                                 if (*ptr & (0x80 >> (i % 8)))
                                 {
-                                    Paint_SetPixel(x + i, y + j, Color_Foreground);
+                                    Paint.SetPixel(x + i, y + j, Color_Foreground);
                                     // Paint_DrawPoint(x + i, y + j, Color_Foreground, DOT_PIXEL_DFT, DOT_STYLE_DFT);
                                 }
                                 else
                                 {
-                                    Paint_SetPixel(x + i, y + j, Color_Background);
+                                    Paint.SetPixel(x + i, y + j, Color_Background);
                                     // Paint_DrawPoint(x + i, y + j, Color_Background, DOT_PIXEL_DFT, DOT_STYLE_DFT);
                                 }
                             }
@@ -800,7 +1115,7 @@ void Paint_DrawImage(const unsigned char *image, UWORD xStart, UWORD yStart, UWO
         for (i = 0; i < W_Image; i++)
         {
             if (xStart + i < Paint.WidthMemory && yStart + j < Paint.HeightMemory) // Exceeded part does not display
-                Paint_SetPixel(xStart + i, yStart + j, (*(image + j * W_Image * 2 + i * 2 + 1)) << 8 | (*(image + j * W_Image * 2 + i * 2)));
+                Paint.SetPixel(xStart + i, yStart + j, (*(image + j * W_Image * 2 + i * 2 + 1)) << 8 | (*(image + j * W_Image * 2 + i * 2)));
             // Using arrays is a property of sequential storage, accessing the original array by algorithm
             // j*W_Image*2 			   Y offset
             // i*2              	   X offset
@@ -816,7 +1131,7 @@ void Paint_DrawImage1(const unsigned char *image, UWORD xStart, UWORD yStart, UW
         for (i = 0; i < W_Image; i++)
         {
             if (xStart + i < Paint.HeightMemory && yStart + j < Paint.WidthMemory) // Exceeded part does not display
-                Paint_SetPixel(xStart + i, yStart + j, (*(image + j * W_Image * 2 + i * 2 + 1)) << 8 | (*(image + j * W_Image * 2 + i * 2)));
+                Paint.SetPixel(xStart + i, yStart + j, (*(image + j * W_Image * 2 + i * 2 + 1)) << 8 | (*(image + j * W_Image * 2 + i * 2)));
             // Using arrays is a property of sequential storage, accessing the original array by algorithm
             // j*W_Image*2 			   Y offset
             // i*2              	   X offset
@@ -845,6 +1160,7 @@ void Paint_DrawBitMap(const unsigned char *image_buffer)
             Paint.Image[Addr] = (unsigned char)image_buffer[Addr];
         }
     }
+    Paint_MarkDirty(0, Paint.HeightByte);
 }
 
 void Paint_DrawBitMap_Block(const unsigned char *image_buffer, UBYTE Region)
@@ -860,6 +1176,7 @@ void Paint_DrawBitMap_Block(const unsigned char *image_buffer, UBYTE Region)
                 (unsigned char)image_buffer[Addr + (Paint.HeightByte) * Paint.WidthByte * (Region - 1)];
         }
     }
+    Paint_MarkDirty(0, Paint.HeightByte);
 }
 
 void Paint_BmpWindows(unsigned char x, unsigned char y, const unsigned char *pBmp,
@@ -872,7 +1189,7 @@ void Paint_BmpWindows(unsigned char x, unsigned char y, const unsigned char *pBm
         {
             if (*(pBmp + j * byteWidth + i / 8) & (128 >> (i & 7)))
             {
-                Paint_SetPixel(x + i, y + j, 0xffff);
+                Paint.SetPixel(x + i, y + j, 0xffff);
             }
         }
     }
@@ -4,6 +4,11 @@
 #include "DEV_Config.h"
 #include "../Fonts/fonts.h"
 
+/**
+ * Pixel writer, chosen from Rotate, Mirror and Scale
+**/
+typedef void (*PAINT_PIXEL_FN)(UWORD Xpoint, UWORD Ypoint, UWORD Color);
+
 /**
  * Image attributes
 **/
@@ -19,9 +24,17 @@ typedef struct {
     UWORD WidthByte;
     UWORD HeightByte;
     UWORD Scale;
+    PAINT_PIXEL_FN SetPixel;
 } PAINT;
 extern PAINT Paint;
 
+/**
+ * Dirty row tracking
+ * One bit per image memory row (LSB first), set when a row's bytes change.
+ * For the OLED_1in3_C each memory row is one panel column.
+**/
+#define PAINT_DIRTY_MAX_ROWS    256
+
 /**
  * Display rotate
 **/
@@ -125,6 +138,9 @@ void Paint_SetPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color);
 void Paint_SetScale(UBYTE scale);
 
 void Paint_Clear(UWORD Color);
+void Paint_ClearDirty(void);
+void Paint_MarkDirty(UWORD Ystart, UWORD Yend);
+const UBYTE *Paint_GetDirtyRows(void);
 void Paint_ClearWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color);
 
 //Drawing
@@ -0,0 +1,546 @@
+/* Streaming inflate **********************************************************
+ *                                                                            *
+ *  Deflate decoding after Mark Adler's puff.c, restructured as a state       *
+ *  machine so that it can stop whenever input runs out and carry on with     *
+ *  the next piece. Each state needs at most a Huffman code plus its extra   *
+ *  bits; a Huffman code is only consumed once all of its bits are in, so a  *
+ *  state that runs short of input is simply retried on the next feed.        *
+ *                                                                            *
+ ******************************************************************************/
+
+
+/* Includes *******************************************************************/
+
+#include <string.h>
+
+#include "http_inflate.h"
+
+
+/* Data structures ************************************************************/
+
+// Decoder position
+enum{
+    HTTP_INFLATE_HEADER,            // gzip/zlib header, byte at a time
+    HTTP_INFLATE_BLOCK,             // Block header
+    HTTP_INFLATE_STORED_LENGTH,     // Stored block LEN/NLEN
+    HTTP_INFLATE_STORED_COPY,       // Stored block data
+    HTTP_INFLATE_TABLE_COUNTS,      // Dynamic block HLIT/HDIST/HCLEN
+    HTTP_INFLATE_TABLE_CODES,       // Code length code lengths
+    HTTP_INFLATE_TABLE_LENGTHS,     // Literal/length and distance code lengths
+    HTTP_INFLATE_LITLEN,            // Literal/length symbol
+    HTTP_INFLATE_LENGTH_EXTRA,      // Length extra bits
+    HTTP_INFLATE_DIST,              // Distance symbol
+    HTTP_INFLATE_DIST_EXTRA,        // Distance extra bits, then copy
+    HTTP_INFLATE_TRAILER,           // gzip/zlib trailer, byte at a time
+    HTTP_INFLATE_DONE
+};
+
+// gzip header steps and flags
+enum{ GZIP_ID1, GZIP_ID2, GZIP_CM, GZIP_FLG, GZIP_SKIP, GZIP_XLEN1, GZIP_XLEN2, GZIP_STRING };
+enum{ ZLIB_CMF, ZLIB_FLG };
+#define GZIP_FHCRC                                  0x02
+#define GZIP_FEXTRA                                 0x04
+#define GZIP_FNAME                                  0x08
+#define GZIP_FCOMMENT                               0x10
+#define GZIP_FRESERVED                              0xe0
+
+#define WINDOW_MASK                                 (HTTP_INFLATE_WINDOW_SIZE - 1)
+#define MAX_BITS                                    15
+
+// Huffman decode results other than a symbol
+#define NEED_INPUT                                  -1
+#define BAD_CODE                                    -2
+
+
+/* Data ***********************************************************************/
+
+static const uint16_t length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577
+};
+static const uint8_t dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+static const uint8_t code_order[19] = {
+    16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+};
+
+
+/* Functions ******************************************************************/
+
+// CRC-32 (gzip), 4 bits at a time
+static uint32_t crc32_update(uint32_t crc, const uint8_t* data, size_t len){
+    static const uint32_t table[16] = {
+        0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+        0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+        0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+        0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+    };
+    crc = ~crc;
+    while(len--){
+        crc ^= *data++;
+        crc = (crc >> 4) ^ table[crc & 0x0f];
+        crc = (crc >> 4) ^ table[crc & 0x0f];
+    }
+    return ~crc;
+}
+
+// Adler-32 (zlib)
+static uint32_t adler32_update(uint32_t adler, const uint8_t* data, size_t len){
+    uint32_t a = adler & 0xffff, b = adler >> 16;
+    while(len--){
+        a += *data++;
+        if(a >= 65521) a -= 65521;
+        b += a;
+        if(b >= 65521) b -= 65521;
+    }
+    return (b << 16) | a;
+}
+
+// Pass on window contents not yet passed on
+static void flush(http_inflate_t* inflate){
+    uint32_t len = inflate->position - inflate->flushed;
+    if(!len) return;
+    const uint8_t* data = inflate->window + (inflate->flushed & WINDOW_MASK);
+    if(inflate->format == HTTP_INFLATE_GZIP)
+        inflate->check = crc32_update(inflate->check, data, len);
+    else if(inflate->format == HTTP_INFLATE_ZLIB)
+        inflate->check = adler32_update(inflate->check, data, len);
+    if(inflate->on_output) inflate->on_output((const char*)data, len, inflate->arg);
+    inflate->flushed = inflate->position;
+}
+
+// Append decoded byte, passing the window on each time it fills
+static void put(http_inflate_t* inflate, uint8_t c){
+    inflate->window[inflate->position++ & WINDOW_MASK] = c;
+    inflate->inflated++;
+    if(!(inflate->position & WINDOW_MASK)) flush(inflate);
+}
+
+// Gather at least `n` bits (n <= 24), as far as input allows
+static bool need(http_inflate_t* inflate, uint8_t n){
+    while(inflate->bitcount < n){
+        if(inflate->in == inflate->in_end) return false;
+        inflate->bitbuf |= (uint32_t)*inflate->in++ << inflate->bitcount;
+        inflate->bitcount += 8;
+    }
+    return true;
+}
+
+// Consume `n` gathered bits
+static uint32_t take(http_inflate_t* inflate, uint8_t n){
+    uint32_t value = inflate->bitbuf & ((1u << n) - 1);
+    inflate->bitbuf >>= n;
+    inflate->bitcount -= n;
+    return value;
+}
+
+// Next whole byte, from gathered bits first; -1 if none
+static int next_byte(http_inflate_t* inflate){
+    if(inflate->bitcount >= 8) return take(inflate, 8);
+    if(inflate->in == inflate->in_end) return -1;
+    return *inflate->in++;
+}
+
+// Decode a Huffman code, consuming it only if all of its bits are in
+static int decode(http_inflate_t* inflate, const http_inflate_huffman_t* h){
+    need(inflate, MAX_BITS);
+    uint32_t bits = inflate->bitbuf;
+    int code = 0, first = 0, index = 0;
+    for(uint8_t len = 1; len <= MAX_BITS; len++){
+        if(len > inflate->bitcount) return NEED_INPUT;
+        code |= bits & 1;
+        bits >>= 1;
+        int count = h->count[len];
+        if(code - count < first){
+            take(inflate, len);
+            return h->symbol[index + (code - first)];
+        }
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+    return BAD_CODE;
+}
+
+// Build canonical Huffman code from code lengths
+//
+//  @return         0 for a complete code, > 0 incomplete, < 0 over-subscribed
+//
+static int construct(http_inflate_huffman_t* h, const uint8_t* length, int n){
+    uint16_t offsets[MAX_BITS + 1];
+    memset(h->count, 0, sizeof(h->count));
+    for(int symbol = 0; symbol < n; symbol++) h->count[length[symbol]]++;
+    if(h->count[0] == n) return 0;
+
+    int left = 1;
+    for(int len = 1; len <= MAX_BITS; len++){
+        left = (left << 1) - h->count[len];
+        if(left < 0) return left;
+    }
+
+    offsets[1] = 0;
+    for(int len = 1; len < MAX_BITS; len++) offsets[len + 1] = offsets[len] + h->count[len];
+    for(int symbol = 0; symbol < n; symbol++)
+        if(length[symbol]) h->symbol[offsets[length[symbol]]++] = symbol;
+    return left;
+}
+
+// Fixed block codes
+static void construct_fixed(http_inflate_t* inflate){
+    int symbol = 0;
+    for(; symbol < 144; symbol++) inflate->lengths[symbol] = 8;
+    for(; symbol < 256; symbol++) inflate->lengths[symbol] = 9;
+    for(; symbol < 280; symbol++) inflate->lengths[symbol] = 7;
+    for(; symbol < 288; symbol++) inflate->lengths[symbol] = 8;
+    construct(&inflate->lencode, inflate->lengths, 288);
+    memset(inflate->lengths, 5, 30);
+    construct(&inflate->distcode, inflate->lengths, 30);
+}
+
+// Dynamic block codes, once all their lengths are read
+static bool construct_dynamic(http_inflate_t* inflate){
+    if(!inflate->lengths[256]) return false;                // No end-of-block code
+
+    // Incomplete codes only allowed for a single length
+    int left = construct(&inflate->lencode, inflate->lengths, inflate->nlen);
+    if(left < 0 || (left > 0 && inflate->nlen - inflate->lencode.count[0] != 1)) return false;
+    left = construct(&inflate->distcode, inflate->lengths + inflate->nlen, inflate->ndist);
+    return !(left < 0 || (left > 0 && inflate->ndist - inflate->distcode.count[0] != 1));
+}
+
+// Move on from a finished gzip header field to the next present one
+static void gzip_next(http_inflate_t* inflate){
+    if(inflate->flags & GZIP_FEXTRA){
+        inflate->flags &= ~GZIP_FEXTRA;
+        inflate->step = GZIP_XLEN1;
+    } else if(inflate->flags & (GZIP_FNAME | GZIP_FCOMMENT)){
+        inflate->flags &= inflate->flags & GZIP_FNAME ? ~GZIP_FNAME : ~GZIP_FCOMMENT;
+        inflate->step = GZIP_STRING;
+    } else if(inflate->flags & GZIP_FHCRC){
+        inflate->flags &= ~GZIP_FHCRC;
+        inflate->skip = 2;
+        inflate->step = GZIP_SKIP;
+    } else {
+        inflate->state = HTTP_INFLATE_BLOCK;
+    }
+}
+
+// Wrapper header byte
+static bool header_byte(http_inflate_t* inflate, uint8_t c){
+    if(inflate->format == HTTP_INFLATE_RAW){
+        inflate->bitbuf = c;                                // No header
+        inflate->bitcount = 8;
+        inflate->state = HTTP_INFLATE_BLOCK;
+        return true;
+    }
+    if(inflate->format == HTTP_INFLATE_ZLIB){
+        if(inflate->step == ZLIB_CMF){
+
+            // Not a zlib header; take as raw deflate
+            if((c & 0x0f) != 8){
+                inflate->format = HTTP_INFLATE_RAW;
+                inflate->bitbuf = c;
+                inflate->bitcount = 8;
+                inflate->state = HTTP_INFLATE_BLOCK;
+                return true;
+            }
+            inflate->trailer[0] = c;
+            inflate->step = ZLIB_FLG;
+            return true;
+        }
+        uint8_t cmf = inflate->trailer[0];
+        if(((cmf << 8) | c) % 31){
+            inflate->format = HTTP_INFLATE_RAW;
+            inflate->bitbuf = cmf | (c << 8);
+            inflate->bitcount = 16;
+            inflate->state = HTTP_INFLATE_BLOCK;
+            return true;
+        }
+        if((cmf >> 4) + 8 > HTTP_INFLATE_WINDOW_BITS) return false;
+        if(c & 0x20) return false;                          // Preset dictionary
+        inflate->check = 1;
+        inflate->state = HTTP_INFLATE_BLOCK;
+        return true;
+    }
+
+    switch(inflate->step){
+        case GZIP_ID1:
+            inflate->step = GZIP_ID2;
+            return c == 0x1f;
+        case GZIP_ID2:
+            inflate->step = GZIP_CM;
+            return c == 0x8b;
+        case GZIP_CM:
+            inflate->step = GZIP_FLG;
+            return c == 8;
+        case GZIP_FLG:
+            inflate->flags = c;
+            inflate->skip = 6;                              // MTIME, XFL, OS
+            inflate->step = GZIP_SKIP;
+            return !(c & GZIP_FRESERVED);
+        case GZIP_XLEN1:
+            inflate->skip = c;
+            inflate->step = GZIP_XLEN2;
+            return true;
+        case GZIP_XLEN2:
+            inflate->skip |= c << 8;
+            inflate->step = GZIP_SKIP;
+            if(!inflate->skip) gzip_next(inflate);
+            return true;
+        case GZIP_SKIP:
+            if(!--inflate->skip) gzip_next(inflate);
+            return true;
+        case GZIP_STRING:
+            if(!c) gzip_next(inflate);
+            return true;
+    }
+    return false;
+}
+
+// Wrapper trailer byte
+static bool trailer_byte(http_inflate_t* inflate, uint8_t c){
+    inflate->trailer[inflate->step++] = c;
+    const uint8_t* t = inflate->trailer;
+    if(inflate->format == HTTP_INFLATE_ZLIB){
+        if(inflate->step < 4) return true;
+        uint32_t adler = (uint32_t)t[0] << 24 | (uint32_t)t[1] << 16 | t[2] << 8 | t[3];
+        if(adler != inflate->check) return false;
+    } else {
+        if(inflate->step < 8) return true;
+        uint32_t crc = t[0] | t[1] << 8 | t[2] << 16 | (uint32_t)t[3] << 24;
+        uint32_t size = t[4] | t[5] << 8 | t[6] << 16 | (uint32_t)t[7] << 24;
+        if(crc != inflate->check || size != (uint32_t)inflate->inflated) return false;
+    }
+    inflate->state = HTTP_INFLATE_DONE;
+    inflate->complete = true;
+    return true;
+}
+
+// End of a deflate block
+static void end_block(http_inflate_t* inflate){
+    if(!inflate->last){
+        inflate->state = HTTP_INFLATE_BLOCK;
+        return;
+    }
+    flush(inflate);
+    take(inflate, inflate->bitcount & 7);                   // Byte align
+
+    // Raw deflate has no trailer
+    if(inflate->format == HTTP_INFLATE_RAW){
+        inflate->state = HTTP_INFLATE_DONE;
+        inflate->complete = true;
+        return;
+    }
+    inflate->step = 0;
+    inflate->state = HTTP_INFLATE_TRAILER;
+}
+
+// Run decoder on available input
+//
+//  @return         `false` on corrupt stream; `true` once input runs out or
+//                  the stream is complete
+//
+static bool run(http_inflate_t* inflate){
+    int symbol, c;
+    for(;;) switch(inflate->state){
+
+        case HTTP_INFLATE_HEADER:
+            if((c = next_byte(inflate)) < 0) return true;
+            if(!header_byte(inflate, c)) return false;
+            break;
+
+        case HTTP_INFLATE_BLOCK:
+            if(!need(inflate, 3)) return true;
+            inflate->last = take(inflate, 1);
+            switch(take(inflate, 2)){
+                case 0:
+                    take(inflate, inflate->bitcount & 7);   // Byte align
+                    inflate->step = 0;
+                    inflate->state = HTTP_INFLATE_STORED_LENGTH;
+                    break;
+                case 1:
+                    construct_fixed(inflate);
+                    inflate->state = HTTP_INFLATE_LITLEN;
+                    break;
+                case 2:
+                    inflate->state = HTTP_INFLATE_TABLE_COUNTS;
+                    break;
+                default:
+                    return false;
+            }
+            break;
+
+        case HTTP_INFLATE_STORED_LENGTH:
+            if(!need(inflate, 16)) return true;
+            if(!inflate->step){                             // LEN
+                inflate->remaining = take(inflate, 16);
+                inflate->step = 1;
+                break;
+            }
+            if(take(inflate, 16) != (~inflate->remaining & 0xffff)) return false;
+            inflate->state = HTTP_INFLATE_STORED_COPY;
+            if(!inflate->remaining) end_block(inflate);
+            break;
+
+        case HTTP_INFLATE_STORED_COPY:
+            if((c = next_byte(inflate)) < 0) return true;
+            put(inflate, c);
+            if(!--inflate->remaining) end_block(inflate);
+            break;
+
+        case HTTP_INFLATE_TABLE_COUNTS:
+            if(!need(inflate, 14)) return true;
+            inflate->nlen = take(inflate, 5) + 257;
+            inflate->ndist = take(inflate, 5) + 1;
+            inflate->ncode = take(inflate, 4) + 4;
+            if(inflate->nlen > 286 || inflate->ndist > 30) return false;
+            inflate->index = 0;
+            inflate->state = HTTP_INFLATE_TABLE_CODES;
+            break;
+
+        case HTTP_INFLATE_TABLE_CODES:
+            while(inflate->index < inflate->ncode){
+                if(!need(inflate, 3)) return true;
+                inflate->lengths[code_order[inflate->index++]] = take(inflate, 3);
+            }
+            while(inflate->index < 19) inflate->lengths[code_order[inflate->index++]] = 0;
+            if(construct(&inflate->lencode, inflate->lengths, 19)) return false;
+            inflate->index = 0;
+            inflate->symbol = -1;
+            inflate->state = HTTP_INFLATE_TABLE_LENGTHS;
+            break;
+
+        case HTTP_INFLATE_TABLE_LENGTHS:
+            while(inflate->index < inflate->nlen + inflate->ndist){
+
+                // Length, or repeat instruction
+                if(inflate->symbol < 0){
+                    symbol = decode(inflate, &inflate->lencode);
+                    if(symbol == NEED_INPUT) return true;
+                    if(symbol < 0) return false;
+                    if(symbol < 16){
+                        inflate->lengths[inflate->index++] = symbol;
+                        continue;
+                    }
+                    inflate->symbol = symbol;
+                }
+
+                // Repeat count
+                uint8_t len = 0, repeat;
+                if(inflate->symbol == 16){
+                    if(!need(inflate, 2)) return true;
+                    if(!inflate->index) return false;       // Nothing to repeat
+                    len = inflate->lengths[inflate->index - 1];
+                    repeat = 3 + take(inflate, 2);
+                } else if(inflate->symbol == 17){
+                    if(!need(inflate, 3)) return true;
+                    repeat = 3 + take(inflate, 3);
+                } else {
+                    if(!need(inflate, 7)) return true;
+                    repeat = 11 + take(inflate, 7);
+                }
+                if(inflate->index + repeat > inflate->nlen + inflate->ndist) return false;
+                memset(inflate->lengths + inflate->index, len, repeat);
+                inflate->index += repeat;
+                inflate->symbol = -1;
+            }
+            if(!construct_dynamic(inflate)) return false;
+            inflate->state = HTTP_INFLATE_LITLEN;
+            break;
+
+        case HTTP_INFLATE_LITLEN:
+            symbol = decode(inflate, &inflate->lencode);
+            if(symbol == NEED_INPUT) return true;
+            if(symbol < 0) return false;
+            if(symbol < 256){
+                put(inflate, symbol);
+            } else if(symbol == 256){
+                end_block(inflate);
+            } else {
+                symbol -= 257;
+                if(symbol >= 29) return false;
+                inflate->symbol = symbol;
+                inflate->state = HTTP_INFLATE_LENGTH_EXTRA;
+            }
+            break;
+
+        case HTTP_INFLATE_LENGTH_EXTRA:
+            if(!need(inflate, length_extra[inflate->symbol])) return true;
+            inflate->length = length_base[inflate->symbol]
+                + take(inflate, length_extra[inflate->symbol]);
+            inflate->state = HTTP_INFLATE_DIST;
+            break;
+
+        case HTTP_INFLATE_DIST:
+            symbol = decode(inflate, &inflate->distcode);
+            if(symbol == NEED_INPUT) return true;
+            if(symbol < 0 || symbol >= 30) return false;
+            inflate->symbol = symbol;
+            inflate->state = HTTP_INFLATE_DIST_EXTRA;
+            break;
+
+        case HTTP_INFLATE_DIST_EXTRA: {
+            if(!need(inflate, dist_extra[inflate->symbol])) return true;
+            uint32_t dist = dist_base[inflate->symbol] + take(inflate, dist_extra[inflate->symbol]);
+            if(dist > HTTP_INFLATE_WINDOW_SIZE || dist > inflate->inflated) return false;
+            for(uint16_t i = 0; i < inflate->length; i++)
+                put(inflate, inflate->window[(inflate->position - dist) & WINDOW_MASK]);
+            inflate->state = HTTP_INFLATE_LITLEN;
+            break;
+        }
+
+        case HTTP_INFLATE_TRAILER:
+            if((c = next_byte(inflate)) < 0) return true;
+            if(!trailer_byte(inflate, c)) return false;
+            break;
+
+        case HTTP_INFLATE_DONE:
+            return true;
+
+    }
+}
+
+// Initialise (or reset) decoder
+void http_inflate_init(
+    http_inflate_t* inflate,
+    http_inflate_format_t format,
+    http_inflate_output_callback on_output,
+    void* arg
+){
+    inflate->compressed = 0;
+    inflate->inflated = 0;
+    inflate->complete = false;
+    inflate->error = false;
+    inflate->format = format;
+    inflate->state = HTTP_INFLATE_HEADER;
+    inflate->step = 0;
+    inflate->check = 0;
+    inflate->bitbuf = 0;
+    inflate->bitcount = 0;
+    inflate->position = 0;
+    inflate->flushed = 0;
+    inflate->on_output = on_output;
+    inflate->arg = arg;
+}
+
+// Feed compressed input to decoder
+bool http_inflate_feed(http_inflate_t* inflate, const uint8_t* data, size_t len){
+    if(inflate->error) return false;
+    inflate->compressed += len;
+    inflate->in = data;
+    inflate->in_end = data + len;
+    inflate->error = !run(inflate);
+    flush(inflate);
+    return !inflate->error;
+}
@@ -0,0 +1,136 @@
+/* Streaming inflate **********************************************************
+ *                                                                            *
+ *  Incremental decoder for deflate (RFC 1951) streams wrapped as gzip        *
+ *  (RFC 1952) or zlib (RFC 1950), i.e. `Content-Encoding: gzip` and          *
+ *  `deflate` response bodies. Compressed input may be fed in arbitrarily     *
+ *  sized pieces; decoded output is passed on through a callback as it is    *
+ *  produced, so the only buffer needed is the back-reference window.         *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef HTTP_INFLATE_H
+#define HTTP_INFLATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/* Options ********************************************************************/
+
+// Back-reference window size (log2)
+//
+//  Streams referring further back than this are rejected. gzip and zlib
+//  compress with a 32 KB window by default, which needs 15; a server known to
+//  compress with a smaller window (zlib `windowBits`) allows less RAM.
+//
+#ifndef HTTP_INFLATE_WINDOW_BITS
+#define HTTP_INFLATE_WINDOW_BITS                    15
+#endif //HTTP_INFLATE_WINDOW_BITS
+
+#define HTTP_INFLATE_WINDOW_SIZE                    (1u << HTTP_INFLATE_WINDOW_BITS)
+
+
+/* Data structures ************************************************************/
+
+// Output callback
+//
+//  Fired with each run of decoded bytes. Runs follow window boundaries, so
+//  may split the output at any point.
+//
+typedef void (*http_inflate_output_callback)(
+    const char* data,
+    size_t len,
+    void* arg
+);
+
+// Stream wrapper
+typedef enum{
+    HTTP_INFLATE_GZIP,              // `Content-Encoding: gzip`
+    HTTP_INFLATE_ZLIB,              // `Content-Encoding: deflate`; raw deflate
+                                    // is also accepted, as some servers send it
+    HTTP_INFLATE_RAW                // Bare deflate stream
+} http_inflate_format_t;
+
+// Huffman code, canonical form
+typedef struct{
+    uint16_t count[16];             // Codes of each length
+    uint16_t symbol[288];           // Symbols ordered by code
+} http_inflate_huffman_t;
+
+// Decoder state
+//
+//  Fields other than those documented are private; initialise with
+//  http_inflate_init().
+//
+typedef struct http_inflate{
+
+    uint64_t compressed;            // Input bytes fed so far
+    uint64_t inflated;              // Output bytes produced so far
+    bool complete;                  // Stream and its trailer fully decoded
+    bool error;                     // Corrupt stream; further input ignored
+
+    http_inflate_format_t format;
+    uint8_t state;
+    uint8_t step;                   // Position within wrapper header/trailer
+    uint8_t flags;                  // gzip header flags still to be handled
+    bool last;                      // Current block is the final one
+    int16_t symbol;                 // Code length repeat awaiting extra bits
+    uint16_t skip;                  // Header bytes left to skip
+    uint16_t nlen, ndist, ncode;    // Dynamic table sizes
+    uint16_t index;                 // Code lengths read so far
+    uint16_t length;                // Back-reference length
+    uint16_t remaining;             // Stored block bytes left
+    uint32_t check;                 // CRC-32 (gzip) or Adler-32 (zlib) of output
+
+    const uint8_t* in;              // Input being consumed
+    const uint8_t* in_end;
+    uint32_t bitbuf;                // Input bits not yet used, LSB first
+    uint8_t bitcount;
+
+    uint32_t position;              // Window write position
+    uint32_t flushed;               // Window position passed on so far
+    http_inflate_output_callback on_output;
+    void* arg;
+
+    uint8_t trailer[8];
+    uint8_t lengths[320];           // Code lengths of the dynamic tables
+    http_inflate_huffman_t lencode;
+    http_inflate_huffman_t distcode;
+    uint8_t window[HTTP_INFLATE_WINDOW_SIZE];
+
+} http_inflate_t;
+
+
+/* Functions ******************************************************************/
+
+// Initialise (or reset) decoder
+//
+//  @param inflate  Decoder to initialise
+//  @param format   Stream wrapper
+//  @param on_output
+//                  Callback fired with decoded output
+//  @param arg      Argument passed through to `on_output`
+//
+void http_inflate_init(
+    http_inflate_t* inflate,
+    http_inflate_format_t format,
+    http_inflate_output_callback on_output,
+    void* arg
+);
+
+// Feed compressed input to decoder
+//
+//  Output is passed on before returning. Input beyond the end of the stream
+//  is ignored.
+//
+//  @param inflate  Decoder
+//  @param data     Next piece of the compressed stream
+//  @param len      Length of `data`
+//
+//  @return         `false` if the stream is corrupt (or needs a larger window)
+//
+bool http_inflate_feed(http_inflate_t* inflate, const uint8_t* data, size_t len);
+
+
+#endif //HTTP_INFLATE_H
@@ -0,0 +1,266 @@
+/* HTTP/1.1 response parser ***************************************************
+ *                                                                            *
+ *  Follows the message framing rules of RFC 9112 section 6.3 as far as a     *
+ *  client reading a single response to a GET needs them:                    *
+ *    • 1xx interim responses are skipped                                     *
+ *    • 204 and 304 responses have no body                                    *
+ *    • Transfer-Encoding: chunked overrides Content-Length                   *
+ *    • otherwise Content-Length, otherwise the body runs to connection close *
+ *                                                                            *
+ ******************************************************************************/
+
+
+/* Includes *******************************************************************/
+
+#include <string.h>
+#include <strings.h>
+
+#include "http_response.h"
+
+
+/* Data structures ************************************************************/
+
+// Parser position
+enum{
+    HTTP_RESPONSE_STATUS_LINE,      // Awaiting status line
+    HTTP_RESPONSE_HEADER_LINE,      // Reading header fields
+    HTTP_RESPONSE_BODY,             // Content-Length or close-delimited body
+    HTTP_RESPONSE_CHUNK_SIZE,       // Awaiting chunk-size line
+    HTTP_RESPONSE_CHUNK_DATA,       // Inside chunk data
+    HTTP_RESPONSE_CHUNK_END,        // Awaiting CRLF after chunk data
+    HTTP_RESPONSE_TRAILER,          // Reading trailer fields after last chunk
+    HTTP_RESPONSE_DONE
+};
+
+
+/* Functions ******************************************************************/
+
+static bool is_space(char c){
+    return c == ' ' || c == '\t';
+}
+
+// Strip surrounding spaces and tabs in place, returns the new start
+static char* trim(char* str){
+    while(is_space(*str)) str++;
+    char* end = str + strlen(str);
+    while(end > str && is_space(end[-1])) *--end = '\0';
+    return str;
+}
+
+// Whether the last transfer coding in a Transfer-Encoding value is chunked
+static bool ends_chunked(const char* value){
+    const char* last = strrchr(value, ',');
+    last = last ? last + 1 : value;
+    while(is_space(*last)) last++;
+    return !strcasecmp(last, "chunked");
+}
+
+static void finish(http_response_parser_t* parser){
+    parser->state = HTTP_RESPONSE_DONE;
+    parser->complete = true;
+}
+
+// Status line, e.g. "HTTP/1.1 200 OK"
+static void handle_status_line(http_response_parser_t* parser, char* line){
+    if(!line[0]) return;                            // Stray CRLF between responses
+    if(strncmp(line, "HTTP/1.", 7) || !line[7] || line[8] != ' '){
+        parser->error = true;
+        return;
+    }
+    const char* code = line + 9;
+    if(
+        code[0] < '1' || code[0] > '5'
+        || code[1] < '0' || code[1] > '9'
+        || code[2] < '0' || code[2] > '9'
+        || (code[3] && code[3] != ' ')
+    ){
+        parser->error = true;
+        return;
+    }
+    parser->status = (code[0] - '0') * 100 + (code[1] - '0') * 10 + (code[2] - '0');
+    parser->framing = HTTP_RESPONSE_FRAMING_CLOSE;
+    parser->content_length = -1;
+    parser->state = HTTP_RESPONSE_HEADER_LINE;
+}
+
+// Blank line ending the header; work out the body framing
+static void end_header(http_response_parser_t* parser){
+
+    // Interim response, the real one follows
+    if(parser->status < 200){
+        parser->status = 0;
+        parser->state = HTTP_RESPONSE_STATUS_LINE;
+        return;
+    }
+
+    parser->headers_done = true;
+    if(parser->status == 204 || parser->status == 304){
+        parser->framing = HTTP_RESPONSE_FRAMING_NONE;
+        finish(parser);
+    } else if(parser->framing == HTTP_RESPONSE_FRAMING_CHUNKED){
+        parser->content_length = -1;                // Ignored alongside chunked
+        parser->state = HTTP_RESPONSE_CHUNK_SIZE;
+    } else if(parser->content_length >= 0){
+        parser->framing = HTTP_RESPONSE_FRAMING_LENGTH;
+        parser->remaining = parser->content_length;
+        parser->state = HTTP_RESPONSE_BODY;
+        if(!parser->remaining) finish(parser);
+    } else {
+        parser->state = HTTP_RESPONSE_BODY;         // Close-delimited
+    }
+
+}
+
+// Header field, "Name: value"
+static void handle_header_line(http_response_parser_t* parser, char* line){
+    if(!line[0]){
+        end_header(parser);
+        return;
+    }
+
+    char* value = strchr(line, ':');
+    if(!value){
+        parser->error = true;
+        return;
+    }
+    *value++ = '\0';
+    char* name = trim(line);
+    value = trim(value);
+
+    if(!strcasecmp(name, "Content-Length")){
+        int64_t length = 0;
+        size_t digits = strlen(value);
+        if(!digits || digits > 18) parser->error = true;    // Empty or absurd
+        for(const char* digit = value; *digit && !parser->error; digit++){
+            if(*digit < '0' || *digit > '9') parser->error = true;
+            length = length * 10 + (*digit - '0');
+        }
+        if(parser->content_length >= 0 && parser->content_length != length)
+            parser->error = true;                   // Conflicting lengths
+        parser->content_length = length;
+    } else if(!strcasecmp(name, "Transfer-Encoding") && ends_chunked(value)){
+        parser->framing = HTTP_RESPONSE_FRAMING_CHUNKED;
+    }
+
+    if(!parser->error && parser->status >= 200 && parser->on_header)
+        parser->on_header(name, value, parser->arg);
+}
+
+// Chunk-size line, hex size optionally followed by ";extensions"
+static void handle_chunk_size(http_response_parser_t* parser, const char* line){
+    uint64_t size = 0;
+    int digits = 0;
+    for(; *line && *line != ';' && !is_space(*line); line++, digits++){
+        char c = *line;
+        int value;
+        if(c >= '0' && c <= '9') value = c - '0';
+        else if(c >= 'a' && c <= 'f') value = c - 'a' + 10;
+        else if(c >= 'A' && c <= 'F') value = c - 'A' + 10;
+        else break;
+        if(digits == 15){                           // Absurdly large
+            parser->error = true;
+            return;
+        }
+        size = (size << 4) | value;
+    }
+    if(!digits || (*line && *line != ';' && !is_space(*line))){
+        parser->error = true;
+        return;
+    }
+    if(size){
+        parser->remaining = size;
+        parser->state = HTTP_RESPONSE_CHUNK_DATA;
+    } else {
+        parser->state = HTTP_RESPONSE_TRAILER;     // Last chunk
+    }
+}
+
+// Complete line in one of the line-oriented states
+static void handle_line(http_response_parser_t* parser){
+    parser->line[parser->line_length] = '\0';
+    parser->line_length = 0;
+    switch(parser->state){
+        case HTTP_RESPONSE_STATUS_LINE:
+            handle_status_line(parser, parser->line);
+            break;
+        case HTTP_RESPONSE_HEADER_LINE:
+            handle_header_line(parser, parser->line);
+            break;
+        case HTTP_RESPONSE_CHUNK_SIZE:
+            handle_chunk_size(parser, parser->line);
+            break;
+        case HTTP_RESPONSE_CHUNK_END:
+            if(parser->line[0]) parser->error = true;
+            else parser->state = HTTP_RESPONSE_CHUNK_SIZE;
+            break;
+        case HTTP_RESPONSE_TRAILER:
+            if(!parser->line[0]) finish(parser);   // Trailer fields ignored
+            break;
+    }
+}
+
+// Initialise (or reset) parser
+void http_response_init(
+    http_response_parser_t* parser,
+    http_response_header_callback on_header,
+    http_response_body_callback on_body,
+    void* arg
+){
+    memset(parser, 0, sizeof(*parser));
+    parser->content_length = -1;
+    parser->framing = HTTP_RESPONSE_FRAMING_CLOSE;
+    parser->state = HTTP_RESPONSE_STATUS_LINE;
+    parser->on_header = on_header;
+    parser->on_body = on_body;
+    parser->arg = arg;
+}
+
+// Feed received bytes to parser
+size_t http_response_feed(
+    http_response_parser_t* parser,
+    const char* data,
+    size_t len
+){
+    size_t i = 0;
+    while(i < len && !parser->complete && !parser->error){
+
+        // Body bytes; passed on in runs
+        if(
+            parser->state == HTTP_RESPONSE_BODY
+            || parser->state == HTTP_RESPONSE_CHUNK_DATA
+        ){
+            size_t run = len - i;
+            bool bounded = parser->framing != HTTP_RESPONSE_FRAMING_CLOSE;
+            if(bounded && run > parser->remaining) run = parser->remaining;
+            if(parser->on_body) parser->on_body(data + i, run, parser->arg);
+            parser->body_received += run;
+            i += run;
+            if(bounded){
+                parser->remaining -= run;
+                if(!parser->remaining){
+                    if(parser->state == HTTP_RESPONSE_BODY) finish(parser);
+                    else parser->state = HTTP_RESPONSE_CHUNK_END;
+                }
+            }
+            continue;
+        }
+
+        // Line-oriented states
+        char c = data[i++];
+        if(c == '\n') handle_line(parser);
+        else if(c != '\r' && parser->line_length < HTTP_RESPONSE_LINE_SIZE - 1)
+            parser->line[parser->line_length++] = c;
+
+    }
+    return i;
+}
+
+// Signal connection closed by server
+bool http_response_close(http_response_parser_t* parser){
+    if(
+        !parser->error
+        && parser->state == HTTP_RESPONSE_BODY
+        && parser->framing == HTTP_RESPONSE_FRAMING_CLOSE
+    ) finish(parser);
+    return parser->complete;
+}
@@ -0,0 +1,139 @@
+/* HTTP/1.1 response parser ***************************************************
+ *                                                                            *
+ *  Incremental parser for a single HTTP/1.1 response. Input may be fed in    *
+ *  arbitrarily sized pieces as it arrives; the status line and header fields *
+ *  are reported as they complete, and the body is de-framed (Content-Length, *
+ *  chunked or close-delimited) so that only body bytes reach the consumer.   *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef HTTP_RESPONSE_H
+#define HTTP_RESPONSE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+/* Options ********************************************************************/
+
+// Header line buffer size
+//
+//  Longer status, header, chunk-size and trailer lines are truncated.
+//
+#ifndef HTTP_RESPONSE_LINE_SIZE
+#define HTTP_RESPONSE_LINE_SIZE                     256             // bytes
+#endif //HTTP_RESPONSE_LINE_SIZE
+
+
+/* Data structures ************************************************************/
+
+// Header field callback
+//
+//  Fired once per header field of the final response (not of 1xx interim
+//  responses), with the name and the value stripped of surrounding
+//  whitespace. Strings are only valid for the duration of the call.
+//
+typedef void (*http_response_header_callback)(
+    const char* name,
+    const char* value,
+    void* arg
+);
+
+// Body callback
+//
+//  Fired with each run of de-framed body bytes.
+//
+typedef void (*http_response_body_callback)(
+    const char* data,
+    size_t len,
+    void* arg
+);
+
+// Body framing
+typedef enum{
+    HTTP_RESPONSE_FRAMING_NONE,     // No body (e.g. 204, 304)
+    HTTP_RESPONSE_FRAMING_LENGTH,   // Content-Length
+    HTTP_RESPONSE_FRAMING_CHUNKED,  // Transfer-Encoding: chunked
+    HTTP_RESPONSE_FRAMING_CLOSE     // Ends when the server closes
+} http_response_framing_t;
+
+// Parser state
+//
+//  Fields other than those documented are private; initialise with
+//  http_response_init().
+//
+typedef struct http_response_parser{
+
+    // Status code of the final response, 0 until the status line is in
+    int status;
+
+    // Body framing, known once `headers_done`
+    http_response_framing_t framing;
+
+    // Content-Length if given (and not chunked), otherwise -1
+    int64_t content_length;
+
+    // Body bytes passed to the body callback so far
+    uint64_t body_received;
+
+    bool headers_done;              // Header of final response complete
+    bool complete;                  // Whole response parsed
+    bool error;                     // Malformed response; further input ignored
+
+    uint8_t state;
+    uint64_t remaining;             // Bytes left in body or current chunk
+    http_response_header_callback on_header;
+    http_response_body_callback on_body;
+    void* arg;
+    size_t line_length;
+    char line[HTTP_RESPONSE_LINE_SIZE];
+
+} http_response_parser_t;
+
+
+/* Functions ******************************************************************/
+
+// Initialise (or reset) parser
+//
+//  @param parser   Parser to initialise
+//  @param on_header
+//                  Header field callback, or NULL
+//  @param on_body  Body callback, or NULL
+//  @param arg      Argument passed through to both callbacks
+//
+void http_response_init(
+    http_response_parser_t* parser,
+    http_response_header_callback on_header,
+    http_response_body_callback on_body,
+    void* arg
+);
+
+// Feed received bytes to parser
+//
+//  Parsing stops once the response is complete or found to be malformed.
+//
+//  @param parser   Parser
+//  @param data     Next piece of the response
+//  @param len      Length of `data`
+//
+//  @return         Bytes consumed; less than `len` only if parsing stopped
+//
+size_t http_response_feed(
+    http_response_parser_t* parser,
+    const char* data,
+    size_t len
+);
+
+// Signal connection closed by server
+//
+//  Completes a close-delimited body.
+//
+//  @param parser   Parser
+//
+//  @return         `true` if the whole response had been received
+//
+bool http_response_close(http_response_parser_t* parser);
+
+
+#endif //HTTP_RESPONSE_H
@@ -27,99 +27,201 @@
 #endif //MBEDTLS_DEBUG_C
 #include "mbedtls/check_config.h"
 
+// C standard library
+#include <string.h>                 // Header values
+#include <strings.h>                // strcasecmp
+
 // Pico HTTPS request example
 #include "picohttps.h"              // Options, macros, forward declarations
+#include "http_response.h"          // Response status, headers and framing
+#if PICOHTTPS_INFLATE
+#include "http_inflate.h"           // gzip/deflate Content-Encoding
+#endif //PICOHTTPS_INFLATE
 
 
-#define MAX_RESPONSE_SIZE 16384  // 16 KB
-char response_buffer[MAX_RESPONSE_SIZE];
-size_t response_offset = 0;
+size_t response_length = 0;
 bool response_complete = false;
-size_t expected_content_length = 0;  // 0 means unknown
+int response_status = 0;
+int64_t response_content_length = -1;
+
+// Response body consumer, set by picohttps_start()
+static picohttps_body_callback body_callback = NULL;
+static void* body_callback_arg = NULL;
+
+// Response parser
+//
+//  Fed from callback_altcp_recv; strips the status line, header and any
+//  chunked framing so that only body bytes reach `body_callback`.
+//
+static http_response_parser_t response_parser;
+static picohttps_validators_t* received_validators = NULL;
+static void handle_header(const char* name, const char* value, void* arg);
+static void handle_body(const char* data, size_t len, void* arg);
+
+// Response Content-Encoding
+//
+//  Compressed bodies are inflated on the way to `body_callback`; an encoding
+//  that cannot be undone fails the fetch rather than passing on gibberish.
+//
+static enum{
+    ENCODING_IDENTITY,
+    ENCODING_INFLATE,
+    ENCODING_UNSUPPORTED
+} response_encoding = ENCODING_IDENTITY;
+#if PICOHTTPS_INFLATE
+static http_inflate_t inflater;
+#endif //PICOHTTPS_INFLATE
+
+picohttps_timing_t picohttps_timing;
+
+// TCP + TLS connection configuration
+//
+//  Created (CA certificate parsed) by the first connection and shared by
+//  every connection after it; never freed.
+//
+static struct altcp_tls_config* tls_config = NULL;
+
+// TLS session of the last completed handshake
+//
+//  Offered to the server on the next connection, which then skips the key
+//  exchange and certificate chain verification if it still holds the session
+//  (session ID) or can decrypt our ticket (session ticket). If not, the
+//  server simply answers with a full handshake.
+//
+#if PICOHTTPS_TLS_SESSION_RESUMPTION
+static mbedtls_ssl_session tls_session;
+static bool tls_session_valid = false;
+static void save_tls_session(struct altcp_pcb* pcb);
+#endif //PICOHTTPS_TLS_SESSION_RESUMPTION
+
+// Request in progress
+//
+//  `state` is advanced by the lwIP callbacks and by picohttps_poll(); both
+//  run with the lwIP lock held, so neither sees the other half way through a
+//  transition.
+//
+static volatile picohttps_state_t state = PICOHTTPS_IDLE;
+static uint32_t phase_started;          // ms since boot the state was entered
+static uint32_t phase_deadline;         // ms since boot the state times out
+static bool join_requested;             // Asynchronous network join started
+static ip_addr_t server_ipaddr;
+static struct altcp_pcb* connection = NULL;
+static char request[PICOHTTPS_REQUEST_SIZE];
+static int request_length;
+static u16_t acknowledged;              // Request bytes acknowledged by server
+static bool request_failed;             // Request could not be sent
+
+// Milliseconds since boot
+static uint32_t now_ms(void){
+    return to_ms_since_boot(get_absolute_time());
+}
 
+// Wrap-safe "is `time` at or after `deadline`"
+static bool time_reached(uint32_t time, uint32_t deadline){
+    return (int32_t)(time - deadline) >= 0;
+}
 
-/* Main Function ***********************************************************************/
+// Enter state, starting its timeout
+static void enter(picohttps_state_t next, uint32_t timeout){
+    state = next;
+    phase_started = now_ms();
+    phase_deadline = phase_started + timeout;
+}
 
-bool fetch_csv() {
 
-    // Initialise standard I/O over USB
-    if(!init_stdio()) return false;
+/* Main Function ***********************************************************************/
 
-    // Initialise Pico W wireless hardware
-    printf("Initializing CYW43\n");
-    if(!init_cyw43()){
-        printf("Failed to initialize CYW43\n");
-        return false;
-    }
-    printf("Initialized CYW43\n");
+bool fetch_csv(
+    const picohttps_validators_t* cached,
+    picohttps_validators_t* received,
+    picohttps_body_callback on_body,
+    void* arg
+) {
 
-    // Connect to wireless network
-    printf("Connecting to %s\n", PICOHTTPS_WIFI_SSID);
-    if(!connect_to_network()){
-        printf("Failed to connect to %s\n", PICOHTTPS_WIFI_SSID);
-        cyw43_arch_deinit();            // Deinit Pico W wireless hardware
-        return false;
-    }
-    printf("Connected to %s\n", PICOHTTPS_WIFI_SSID);
+    if(!picohttps_start(cached, received, on_body, arg)) return false;
 
-    // Resolve server hostname
-    ip_addr_t ipaddr;
-    char* char_ipaddr;
-    printf("Resolving %s\n", PICOHTTPS_HOSTNAME);
-    if(!resolve_hostname(&ipaddr)){
-        printf("Failed to resolve %s\n", PICOHTTPS_HOSTNAME);
-                                        // TODO: Disconnect from network
-        cyw43_arch_deinit();            // Deinit Pico W wireless hardware
-        return false;
-    }
-    cyw43_arch_lwip_begin();
-    char_ipaddr = ipaddr_ntoa(&ipaddr);
-    cyw43_arch_lwip_end();
-    printf("Resolved %s (%s)\n", PICOHTTPS_HOSTNAME, char_ipaddr);
+    // Pump until done
+    picohttps_state_t progress;
+    while(
+        (progress = picohttps_poll()) != PICOHTTPS_DONE
+        && progress != PICOHTTPS_FAILED
+    ) sleep_ms(PICOHTTPS_POLL_INTERVAL);
 
+    return progress == PICOHTTPS_DONE;
+}
 
-    // Establish TCP + TLS connection with server
-#ifdef MBEDTLS_DEBUG_C
-    mbedtls_debug_set_threshold(PICOHTTPS_MBEDTLS_DEBUG_LEVEL);
-#endif //MBEDTLS_DEBUG_C
-    struct altcp_pcb* pcb = NULL;
-    printf("Connecting to https://%s:%d\n", char_ipaddr, LWIP_IANA_PORT_HTTPS);
-    if(!connect_to_host(&ipaddr, &pcb)){
-        printf("Failed to connect to https://%s:%d\n", char_ipaddr, LWIP_IANA_PORT_HTTPS);
-                                        // TODO: Disconnect from network
-        cyw43_arch_deinit();            // Deinit Pico W wireless hardware
-        return false;
-    }
-    printf("Connected to https://%s:%d\n", char_ipaddr, LWIP_IANA_PORT_HTTPS);
+// Start fetching CSV file from server
+bool picohttps_start(
+    const picohttps_validators_t* cached,
+    picohttps_validators_t* received,
+    picohttps_body_callback on_body,
+    void* arg
+){
+    static bool cyw43_initialised = false;
 
-    // Send HTTP request to server
-    printf("Sending request\n");
-    if(!send_request(pcb)){
-        printf("Failed to send request\n");
-        altcp_free_config(              // Free connection configuration
-            ((struct altcp_callback_arg*)(pcb->arg))->config
-        );
-        altcp_free_arg(                 // Free connection callback argument
-            (struct altcp_callback_arg*)(pcb->arg)
-        );
-        altcp_free_pcb(pcb);            // Free connection PCB
-                                        // TODO: Disconnect from network
-        cyw43_arch_deinit();            // Deinit Pico W wireless hardware
-        return false;
-    }
-    printf("Request sent. Waiting for response...\n");
+    if(picohttps_busy()) return false;
 
-    while (!response_complete) {
-        sleep_ms(100);
+    // Initialise standard I/O and Pico W wireless hardware, once
+    if(!cyw43_initialised){
+        if(!init_stdio()) return false;
+        printf("Initializing CYW43\n");
+        if(!init_cyw43()){
+            printf("Failed to initialize CYW43\n");
+            return false;
+        }
+        printf("Initialized CYW43\n");
+        cyw43_arch_enable_sta_mode();
+        cyw43_initialised = true;
     }
 
-    printf("HTTPS response received (%zu bytes)\n", response_offset);
+    // Build request
+    //
+    //  Headers are only added for validators we have; with neither the
+    //  request is unconditional.
+    //
+    request_length = snprintf(
+        request,
+        sizeof(request),
+        PICOHTTPS_REQUEST "%s%s%s%s%s%s\r\n",
+        (cached && cached->etag[0]) ? "If-None-Match: " : "",
+        (cached && cached->etag[0]) ? cached->etag : "",
+        (cached && cached->etag[0]) ? "\r\n" : "",
+        (cached && cached->last_modified[0]) ? "If-Modified-Since: " : "",
+        (cached && cached->last_modified[0]) ? cached->last_modified : "",
+        (cached && cached->last_modified[0]) ? "\r\n" : ""
+    );
+    if(request_length < 0 || request_length >= (int)sizeof(request)) return false;
 
-    response_buffer[response_offset] = '\0'; // Null-terminate the response buffer (makes everything before this character a string)
+#ifdef MBEDTLS_DEBUG_C
+    mbedtls_debug_set_threshold(PICOHTTPS_MBEDTLS_DEBUG_LEVEL);
+#endif //MBEDTLS_DEBUG_C
 
+    cyw43_arch_lwip_begin();
+    body_callback = on_body;
+    body_callback_arg = arg;
+    received_validators = received;
+    if(received) memset(received, 0, sizeof(*received));
+    response_length = 0;
+    response_complete = false;
+    response_status = 0;
+    response_content_length = -1;
+    response_encoding = ENCODING_IDENTITY;
+    request_failed = false;
+    http_response_init(&response_parser, handle_header, handle_body, NULL);
+    memset(&picohttps_timing, 0, sizeof(picohttps_timing));
+    join_requested = false;
+    enter(PICOHTTPS_JOINING, PICOHTTPS_WIFI_TIMEOUT);
+    cyw43_arch_lwip_end();
     return true;
 }
 
+// Whether a request is in progress
+bool picohttps_busy(void){
+    return state != PICOHTTPS_IDLE
+        && state != PICOHTTPS_DONE
+        && state != PICOHTTPS_FAILED;
+}
+
 
 
 /* Functions ******************************************************************/
@@ -136,91 +238,86 @@ bool init_cyw43(void){
     return !((bool)cyw43_arch_init_with_country(PICOHTTPS_INIT_CYW43_COUNTRY));
 }
 
-// Connect to wireless network
-bool connect_to_network(void){
-    cyw43_arch_enable_sta_mode();
-    return !(
-        (bool)cyw43_arch_wifi_connect_timeout_ms(
-            PICOHTTPS_WIFI_SSID,
-            PICOHTTPS_WIFI_PASSWORD,
-            CYW43_AUTH_WPA2_AES_PSK,
-            PICOHTTPS_WIFI_TIMEOUT
-        )
-    );
+// Close connection
+//
+//  Detaches the callbacks first so nothing fires into a finished request; a
+//  connection that cannot be closed gracefully (out of memory) is aborted.
+//
+static void close_connection(void){
+    if(!connection) return;
+    altcp_arg(connection, NULL);
+    altcp_recv(connection, NULL);
+    altcp_sent(connection, NULL);
+    altcp_err(connection, NULL);
+    altcp_poll(connection, NULL, 0);
+    if(altcp_close(connection) != ERR_OK) altcp_abort(connection);
+    connection = NULL;
 }
 
-// Resolve hostname
-bool resolve_hostname(ip_addr_t* ipaddr){
-
-    // Zero address
-    ipaddr->addr = IPADDR_ANY;
+// Finish request, successfully or not
+//
+//  Not from within a connection callback, as the connection is closed.
+//
+static void finish(bool ok){
+    close_connection();
+    state = ok ? PICOHTTPS_DONE : PICOHTTPS_FAILED;
+}
 
-    // Attempt resolution
-    cyw43_arch_lwip_begin();
-    lwip_err_t lwip_err = dns_gethostbyname(
-        PICOHTTPS_HOSTNAME,
-        ipaddr,
-        callback_gethostbyname,
-        ipaddr
-    );
-    cyw43_arch_lwip_end();
-    if(lwip_err == ERR_INPROGRESS){
-
-        // Await resolution
-        //
-        //  IP address will be made available shortly (by callback) upon DNS
-        //  query response.
-        //
-        while(ipaddr->addr == IPADDR_ANY)
-            sleep_ms(PICOHTTPS_RESOLVE_POLL_INTERVAL);
-        if(ipaddr->addr != IPADDR_NONE)
-            lwip_err = ERR_OK;
+// Wrap up a request whose response is in (or whose connection is gone)
+static void finish_response(void){
+    picohttps_timing.transfer_ms = now_ms() - phase_started;
 
+    bool whole = response_parser.complete && !response_parser.error;
+    if(request_failed){
+        printf("Failed to send request\n");
+        whole = false;
     }
+    if(response_status == 200 && response_encoding == ENCODING_UNSUPPORTED){
+        printf("Unsupported Content-Encoding\n");
+        whole = false;
+    }
+#if PICOHTTPS_INFLATE
+    if(response_status == 200 && response_encoding == ENCODING_INFLATE){
+        printf(
+            "Inflated %llu bytes to %llu\n",
+            (unsigned long long)inflater.compressed,
+            (unsigned long long)inflater.inflated
+        );
+        whole = whole && inflater.complete;
+    }
+#endif //PICOHTTPS_INFLATE
+    printf(
+        "HTTPS response %s (%zu bytes, status %d, %lu ms)\n",
+        whole ? "received" : "incomplete",
+        response_length,
+        response_status,
+        (unsigned long)picohttps_timing.transfer_ms
+    );
 
-    // Return
-    return !((bool)lwip_err);
-
-}
-
-// Free TCP + TLS protocol control block
-void altcp_free_pcb(struct altcp_pcb* pcb){
-    cyw43_arch_lwip_begin();
-    lwip_err_t lwip_err = altcp_close(pcb);         // Frees PCB
-    cyw43_arch_lwip_end();
-    while(lwip_err != ERR_OK)
-        sleep_ms(PICOHTTPS_ALTCP_CONNECT_POLL_INTERVAL);
-        cyw43_arch_lwip_begin();
-        lwip_err = altcp_close(pcb);                // Frees PCB
-        cyw43_arch_lwip_end();
-}
-
-// Free TCP + TLS connection configuration
-void altcp_free_config(struct altcp_tls_config* config){
-    cyw43_arch_lwip_begin();
-    altcp_tls_free_config(config);
-    cyw43_arch_lwip_end();
+    finish(whole);
 }
 
-// Free TCP + TLS connection callback argument
-void altcp_free_arg(struct altcp_callback_arg* arg){
-    if(arg){
-        free(arg);
+// Open TCP + TLS connection with server
+//
+//  Called with the lwIP lock held. The handshake completes in
+//  callback_altcp_connect, which then sends the request.
+//
+static void connect_to_host(void){
+    printf("Resolved %s (%s)\n", PICOHTTPS_HOSTNAME, ipaddr_ntoa(&server_ipaddr));
+    enter(PICOHTTPS_CONNECTING, PICOHTTPS_TIMEOUT);
+
+    // Instantiate connection configuration, once
+    if(!tls_config){
+        u8_t ca_cert[] = PICOHTTPS_CA_ROOT_CERT;
+        tls_config = altcp_tls_create_config_client(
+            ca_cert,
+            LEN(ca_cert)
+        );
+        if(!tls_config){
+            finish(false);
+            return;
+        }
     }
-}
-
-// Establish TCP + TLS connection with server
-bool connect_to_host(ip_addr_t* ipaddr, struct altcp_pcb** pcb){
-
-    // Instantiate connection configuration
-    u8_t ca_cert[] = PICOHTTPS_CA_ROOT_CERT;
-    cyw43_arch_lwip_begin();
-    struct altcp_tls_config* config = altcp_tls_create_config_client(
-        ca_cert,
-        LEN(ca_cert)
-    );
-    cyw43_arch_lwip_end();
-    if(!config) return false;
 
     // Instantiate connection PCB
     //
@@ -235,12 +332,10 @@ bool connect_to_host(ip_addr_t* ipaddr, struct altcp_pcb** pcb){
     //  No benefit in doing this though; altcp_tls_alloc calls altcp_tls_new
     //  under the hood anyway.
     //
-    cyw43_arch_lwip_begin();
-    *pcb = altcp_tls_new(config, IPADDR_TYPE_V4);
-    cyw43_arch_lwip_end();
-    if(!(*pcb)){
-        altcp_free_config(config);
-        return false;
+    connection = altcp_tls_new(tls_config, IPADDR_TYPE_V4);
+    if(!connection){
+        finish(false);
+        return;
     }
 
     // Configure hostname for Server Name Indication extension
@@ -267,104 +362,141 @@ bool connect_to_host(ip_addr_t* ipaddr, struct altcp_pcb** pcb){
     //  [wiki-sni]: https://en.wikipedia.org/wiki/Server_Name_Indication
     //  [gh-lwip-pr]: https://github.com/lwip-tcpip/lwip/pull/47/commits/c53c9d02036be24a461d2998053a52991e65b78e
     //
-    cyw43_arch_lwip_begin();
-    mbedtls_err_t mbedtls_err = mbedtls_ssl_set_hostname(
-        &(
-            (
-                (altcp_mbedtls_state_t*)((*pcb)->state)
-            )->ssl_context
-        ),
-        PICOHTTPS_HOSTNAME
-    );
-    cyw43_arch_lwip_end();
-    if(mbedtls_err){
-        altcp_free_pcb(*pcb);
-        altcp_free_config(config);
-        return false;
+    mbedtls_ssl_context* ssl =
+        &(((altcp_mbedtls_state_t*)(connection->state))->ssl_context);
+    if(mbedtls_ssl_set_hostname(ssl, PICOHTTPS_HOSTNAME)){
+        finish(false);
+        return;
     }
 
-    // Configure common argument for connection callbacks
+    // Offer the previous session for resumption
     //
-    //  N.b. callback argument must be in scope in callbacks. As callbacks may
-    //  fire after current function returns, cannot declare argument locally,
-    //  but rather should allocate on the heap. Must then ensure allocated
-    //  memory is subsequently freed.
+    //  Must be set before the handshake starts, i.e. before connecting. A
+    //  session that cannot be set just means a full handshake.
     //
-    struct altcp_callback_arg* arg = malloc(sizeof(*arg));
-    if(!arg){
-        altcp_free_pcb(*pcb);
-        altcp_free_config(config);
-        return false;
-    }
-    arg->config = config;
-    arg->connected = false;
-    cyw43_arch_lwip_begin();
-    altcp_arg(*pcb, (void*)arg);
-    cyw43_arch_lwip_end();
-
-    // Configure connection fatal error callback
-    cyw43_arch_lwip_begin();
-    altcp_err(*pcb, callback_altcp_err);
-    cyw43_arch_lwip_end();
+#if PICOHTTPS_TLS_SESSION_RESUMPTION
+    if(tls_session_valid) mbedtls_ssl_set_session(ssl, &tls_session);
+#endif //PICOHTTPS_TLS_SESSION_RESUMPTION
 
-    // Configure idle connection callback (and interval)
-    cyw43_arch_lwip_begin();
+    // Configure connection callbacks
+    //
+    //  Request state is module-wide, so there is no common argument.
+    //
+    altcp_arg(connection, NULL);
+    altcp_err(connection, callback_altcp_err);
     altcp_poll(
-        *pcb,
+        connection,
         callback_altcp_poll,
         PICOHTTPS_ALTCP_IDLE_POLL_INTERVAL
     );
-    cyw43_arch_lwip_end();
-
-    // Configure data acknowledge callback
-    cyw43_arch_lwip_begin();
-    altcp_sent(*pcb, callback_altcp_sent);
-    cyw43_arch_lwip_end();
-
-    // Configure data reception callback
-    cyw43_arch_lwip_begin();
-    altcp_recv(*pcb, callback_altcp_recv);
-    cyw43_arch_lwip_end();
+    altcp_sent(connection, callback_altcp_sent);
+    altcp_recv(connection, callback_altcp_recv);
 
     // Send connection request (SYN)
-    cyw43_arch_lwip_begin();
-    lwip_err_t lwip_err = altcp_connect(
-        *pcb,
-        ipaddr,
+    printf("Connecting to https://%s:%d\n", ipaddr_ntoa(&server_ipaddr), LWIP_IANA_PORT_HTTPS);
+    if(altcp_connect(
+        connection,
+        &server_ipaddr,
         LWIP_IANA_PORT_HTTPS,
         callback_altcp_connect
-    );
-    cyw43_arch_lwip_end();
+    ) != ERR_OK) finish(false);
+}
 
-    // Connection request sent
+// Resolve hostname
+//
+//  Called with the lwIP lock held. A cached address connects straight away,
+//  otherwise callback_gethostbyname does once the query is answered.
+//
+static void resolve_hostname(void){
+    printf("Resolving %s\n", PICOHTTPS_HOSTNAME);
+    enter(PICOHTTPS_RESOLVING, PICOHTTPS_TIMEOUT);
+    lwip_err_t lwip_err = dns_gethostbyname(
+        PICOHTTPS_HOSTNAME,
+        &server_ipaddr,
+        callback_gethostbyname,
+        NULL
+    );
     if(lwip_err == ERR_OK){
+        picohttps_timing.resolve_ms = 0;
+        connect_to_host();
+    } else if(lwip_err != ERR_INPROGRESS){
+        printf("Failed to resolve %s\n", PICOHTTPS_HOSTNAME);
+        finish(false);
+    }
+}
 
-        // Await connection
-        //
-        //  Sucessful connection will be confirmed shortly in
-        //  callback_altcp_connect.
-        //
-        while(!(arg->connected))
-            sleep_ms(PICOHTTPS_ALTCP_CONNECT_POLL_INTERVAL);
+// Advance request
+picohttps_state_t picohttps_poll(void){
+    cyw43_arch_lwip_begin();
+    uint32_t now = now_ms();
+    switch(state){
+
+        // Join wireless network, unless still joined from last time
+        case PICOHTTPS_JOINING: {
+            int link = cyw43_tcpip_link_status(&cyw43_state, CYW43_ITF_STA);
+            if(link == CYW43_LINK_UP){
+                if(join_requested) printf("Connected to %s\n", PICOHTTPS_WIFI_SSID);
+                picohttps_timing.join_ms = now - phase_started;
+                resolve_hostname();
+            } else if(!join_requested){
+                printf("Connecting to %s\n", PICOHTTPS_WIFI_SSID);
+                join_requested = true;
+                if(cyw43_arch_wifi_connect_async(
+                    PICOHTTPS_WIFI_SSID,
+                    PICOHTTPS_WIFI_PASSWORD,
+                    CYW43_AUTH_WPA2_AES_PSK
+                )){
+                    printf("Failed to connect to %s\n", PICOHTTPS_WIFI_SSID);
+                    finish(false);
+                }
+            } else if(link < 0 || time_reached(now, phase_deadline)){
+                printf("Failed to connect to %s (%d)\n", PICOHTTPS_WIFI_SSID, link);
+                finish(false);
+            }
+            break;
+        }
 
-    } else {
+        case PICOHTTPS_RESOLVING:
+            if(time_reached(now, phase_deadline)){
+                printf("Timed out resolving %s\n", PICOHTTPS_HOSTNAME);
+                finish(false);
+            }
+            break;
+
+        case PICOHTTPS_CONNECTING:
+            if(response_complete){      // Connection error
+                printf("Failed to connect to %s\n", PICOHTTPS_HOSTNAME);
+                finish(false);
+            } else if(time_reached(now, phase_deadline)){
+                printf("Timed out connecting to %s\n", PICOHTTPS_HOSTNAME);
+                finish(false);
+            }
+            break;
+
+        case PICOHTTPS_SENDING:
+        case PICOHTTPS_RECEIVING:
+            if(response_complete){
+                finish_response();
+            } else if(time_reached(now, phase_deadline)){
+                printf("Timed out awaiting response\n");     // Nothing received for a while
+                finish(false);
+            }
+            break;
 
-        // Free allocated resources
-        altcp_free_pcb(*pcb);
-        altcp_free_config(config);
-        altcp_free_arg(arg);
+        default:
+            break;
 
     }
-
-    // Return
-    return !((bool)lwip_err);
-
+    picohttps_state_t current = state;
+    cyw43_arch_lwip_end();
+    return current;
 }
 
 // Send HTTP request
-bool send_request(struct altcp_pcb* pcb){
-
-    const char request[] = PICOHTTPS_REQUEST;
+//
+//  In lwIP context, once the handshake is complete.
+//
+static bool send_request(struct altcp_pcb* pcb){
 
     // Check send buffer and queue length
     //
@@ -373,53 +505,97 @@ bool send_request(struct altcp_pcb* pcb){
     //  altcp_write, or just handle returned ERR_MEM — which is preferable?
     //
     //if(
-    //  altcp_sndbuf(pcb) < (LEN(request) - 1)
+    //  altcp_sndbuf(pcb) < request_length
     //  || altcp_sndqueuelen(pcb) > TCP_SND_QUEUELEN
     //) return -1;
 
-    // Write to send buffer
-    cyw43_arch_lwip_begin();
-    lwip_err_t lwip_err = altcp_write(pcb, request, LEN(request) -1, 0);
-    cyw43_arch_lwip_end();
-
-    // Written to send buffer
-    if(lwip_err == ERR_OK){
-
-        // Output send buffer
-        ((struct altcp_callback_arg*)(pcb->arg))->acknowledged = 0;
-        cyw43_arch_lwip_begin();
-        lwip_err = altcp_output(pcb);
-        cyw43_arch_lwip_end();
-
-        // Send buffer output
-        if(lwip_err == ERR_OK){
-
-            // Await acknowledgement
-            while(
-                !((struct altcp_callback_arg*)(pcb->arg))->acknowledged
-            ) sleep_ms(PICOHTTPS_HTTP_RESPONSE_POLL_INTERVAL);
-            if(
-                ((struct altcp_callback_arg*)(pcb->arg))->acknowledged
-                != (LEN(request) - 1)
-            ) lwip_err = -1;
+    // Write to send buffer, then output it
+    //
+    //  Acknowledgements are summed by callback_altcp_sent, as a longer
+    //  (conditional) request may be acknowledged piecewise.
+    //
+    acknowledged = 0;
+    if(altcp_write(pcb, request, request_length, TCP_WRITE_FLAG_COPY) != ERR_OK)
+        return false;
+    return altcp_output(pcb) == ERR_OK;
 
-        }
+}
 
+#if PICOHTTPS_TLS_SESSION_RESUMPTION
+
+// Keep the session of a completed handshake
+//
+//  In lwIP context. A resumed handshake reuses the master secret of the
+//  offered session, so matching secrets tell the two kinds of handshake
+//  apart.
+//
+static void save_tls_session(struct altcp_pcb* pcb){
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    mbedtls_err_t mbedtls_err = mbedtls_ssl_get_session(
+        &(((altcp_mbedtls_state_t*)(pcb->state))->ssl_context),
+        &session
+    );
+    if(mbedtls_err){
+        mbedtls_ssl_session_free(&session);
+        return;
     }
+    picohttps_timing.resumed = tls_session_valid && !memcmp(
+        session.master,
+        tls_session.master,
+        sizeof(session.master)
+    );
+    if(tls_session_valid) mbedtls_ssl_session_free(&tls_session);
+    tls_session = session;              // Takes over allocations
+    tls_session_valid = true;
+}
 
-    // Return
-    return !((bool)lwip_err);
+// Serialise cached TLS session
+size_t picohttps_tls_session_save(uint8_t* buf, size_t size){
+    size_t len = 0;
+    cyw43_arch_lwip_begin();
+    if(!tls_session_valid || mbedtls_ssl_session_save(&tls_session, buf, size, &len))
+        len = 0;
+    cyw43_arch_lwip_end();
+    return len;
+}
+
+// Restore cached TLS session
+bool picohttps_tls_session_load(const uint8_t* buf, size_t len){
+    picohttps_tls_session_clear();
+    cyw43_arch_lwip_begin();
+    mbedtls_ssl_session_init(&tls_session);
+    tls_session_valid = !mbedtls_ssl_session_load(&tls_session, buf, len);
+    if(!tls_session_valid) mbedtls_ssl_session_free(&tls_session);
+    cyw43_arch_lwip_end();
+    return tls_session_valid;
+}
 
+// Forget cached TLS session
+void picohttps_tls_session_clear(void){
+    cyw43_arch_lwip_begin();
+    if(tls_session_valid) mbedtls_ssl_session_free(&tls_session);
+    tls_session_valid = false;
+    cyw43_arch_lwip_end();
 }
 
+#endif //PICOHTTPS_TLS_SESSION_RESUMPTION
+
 // DNS response callback
 void callback_gethostbyname(
     const char* name,
     const ip_addr_t* resolved,
-    void* ipaddr
+    void* arg
 ){
-    if(resolved) *((ip_addr_t*)ipaddr) = *resolved;         // Successful resolution
-    else ((ip_addr_t*)ipaddr)->addr = IPADDR_NONE;          // Failed resolution
+    if(state != PICOHTTPS_RESOLVING) return;                // Timed out
+    picohttps_timing.resolve_ms = now_ms() - phase_started;
+    if(resolved){                                           // Successful resolution
+        server_ipaddr = *resolved;
+        connect_to_host();
+    } else {                                                // Failed resolution
+        printf("Failed to resolve %s\n", PICOHTTPS_HOSTNAME);
+        finish(false);
+    }
 }
 
 // TCP + TLS connection error callback
@@ -428,12 +604,9 @@ void callback_altcp_err(void* arg, lwip_err_t err){
     // Print error code
     printf("Connection error [lwip_err_t err == %d]\n", err);
 
-    // Free ALTCP TLS config
-    if( ((struct altcp_callback_arg*)arg)->config )
-        altcp_free_config( ((struct altcp_callback_arg*)arg)->config );
-
-    // Free ALTCP callback argument
-    altcp_free_arg((struct altcp_callback_arg*)arg);
+    // PCB already freed by lwIP; picohttps_poll() wraps up
+    connection = NULL;
+    response_complete = true;
 
 }
 
@@ -445,10 +618,87 @@ lwip_err_t callback_altcp_poll(void* arg, struct altcp_pcb* pcb){
 
 // TCP + TLS data acknowledgement callback
 lwip_err_t callback_altcp_sent(void* arg, struct altcp_pcb* pcb, u16_t len){
-    ((struct altcp_callback_arg*)arg)->acknowledged = len;
+    acknowledged += len;
+    if(state == PICOHTTPS_SENDING && acknowledged >= request_length){
+        printf("Request sent. Waiting for response...\n");
+        state = PICOHTTPS_RECEIVING;            // Same phase; timing carries on
+    }
     return ERR_OK;
 }
 
+// Copy header value if it fits, otherwise leave empty
+static void copy_header_value(char* dest, size_t size, const char* value){
+    size_t len = strlen(value);
+    if(len < size) memcpy(dest, value, len + 1);
+    else dest[0] = '\0';
+}
+
+// Content-Encoding header value
+static void handle_content_encoding(const char* value){
+    if(!strcasecmp(value, "identity")) return;
+#if PICOHTTPS_INFLATE
+    if(!strcasecmp(value, "gzip") || !strcasecmp(value, "x-gzip")){
+        http_inflate_init(&inflater, HTTP_INFLATE_GZIP, body_callback, body_callback_arg);
+        response_encoding = ENCODING_INFLATE;
+        return;
+    }
+    if(!strcasecmp(value, "deflate")){
+        http_inflate_init(&inflater, HTTP_INFLATE_ZLIB, body_callback, body_callback_arg);
+        response_encoding = ENCODING_INFLATE;
+        return;
+    }
+#endif //PICOHTTPS_INFLATE
+    response_encoding = ENCODING_UNSUPPORTED;       // Incl. stacked encodings
+}
+
+// Response header field
+static void handle_header(const char* name, const char* value, void* arg){
+    if(!strcasecmp(name, "Content-Encoding"))
+        handle_content_encoding(value);
+    if(!received_validators) return;
+    if(!strcasecmp(name, "ETag"))
+        copy_header_value(received_validators->etag, PICOHTTPS_ETAG_SIZE, value);
+    else if(!strcasecmp(name, "Last-Modified"))
+        copy_header_value(received_validators->last_modified, PICOHTTPS_LAST_MODIFIED_SIZE, value);
+}
+
+// Response body bytes; only a 200 OK body is the file asked for
+static void handle_body(const char* data, size_t len, void* arg){
+    if(response_parser.status != 200 || !body_callback) return;
+    switch(response_encoding){
+        case ENCODING_IDENTITY:
+            body_callback(data, len, body_callback_arg);
+            break;
+#if PICOHTTPS_INFLATE
+        case ENCODING_INFLATE:
+            http_inflate_feed(&inflater, (const uint8_t*)data, len);
+            break;
+#endif //PICOHTTPS_INFLATE
+        default:
+            break;
+    }
+}
+
+// Whether the body can no longer be passed on intact
+static bool body_failed(void){
+    if(response_parser.status != 200) return false;
+#if PICOHTTPS_INFLATE
+    if(response_encoding == ENCODING_INFLATE) return inflater.error;
+#endif //PICOHTTPS_INFLATE
+    return response_encoding == ENCODING_UNSUPPORTED;
+}
+
+// Pass received data through the response parser
+static void handle_response_data(const char* data, size_t len){
+    response_length += len;
+    http_response_feed(&response_parser, data, len);
+    response_status = response_parser.status;
+    if(response_parser.headers_done)
+        response_content_length = response_parser.content_length;
+    if(response_parser.complete || response_parser.error || body_failed())
+        response_complete = true;
+}
+
 // TCP + TLS data reception callback
 lwip_err_t callback_altcp_recv(
     void* arg,
@@ -459,6 +709,7 @@ lwip_err_t callback_altcp_recv(
 
     if (buf == NULL) {
         printf("Connection closed by server. Marking response complete.\r\n");
+        http_response_close(&response_parser);
         response_complete = true;
         return ERR_OK;
     }
@@ -468,7 +719,7 @@ lwip_err_t callback_altcp_recv(
     //  Required to free entire packet buffer chain after processing.
     //
     struct pbuf* head = buf;
-    printf("Received %zu bytes\n", buf->tot_len);
+    phase_deadline = now_ms() + PICOHTTPS_TIMEOUT;     // Still making progress
     switch(err){
 
         // No error receiving
@@ -498,31 +749,23 @@ lwip_err_t callback_altcp_recv(
 
             }
             */
-           
+
            //My modified version of the code
-           printf("ERR Code OK\n");
-            if (buf) {
+            //
+            //  Body bytes are handed on as they arrive rather than collected,
+            //  so the response size is not bounded by a buffer here.
+            //
             while (buf) {
-                if (response_offset + buf->len < MAX_RESPONSE_SIZE) { 
-                    printf("Adding to response buffer\n");
-                    memcpy(response_buffer + response_offset, buf->payload, buf->len); //memcpy copies ttakes buf->len bytes from buf->payload (incoming network data), and writes them into response_buffer, starting at the current offset,
-                    printf("Add successful!");  
-
-                    response_offset += buf->len;
-                }
+                handle_response_data((const char*)buf->payload, buf->len);
                 buf = buf->next;
             }
-        
             altcp_recved(pcb, head->tot_len);
-            printf("ACK Received");
-            }
 
             //Back to the original code
 
             // …fall-through…
 
         case ERR_ABRT:
-            printf("ERR Code ABRT\n");
             // Free buf
             pbuf_free(head);        // Free entire pbuf chain
 
@@ -537,13 +780,36 @@ lwip_err_t callback_altcp_recv(
 }
 
 // TCP + TLS connection establishment callback
+//
+//  Fired once the TLS handshake is complete; sends the request.
+//
 lwip_err_t callback_altcp_connect(
     void* arg,
     struct altcp_pcb* pcb,
     lwip_err_t err
 ){
-    ((struct altcp_callback_arg*)arg)->connected = true;
-    return ERR_OK;
-}
+    if(state != PICOHTTPS_CONNECTING) return ERR_OK;
+    picohttps_timing.handshake_ms = now_ms() - phase_started;
+
+    // Keep session for the next connection
+#if PICOHTTPS_TLS_SESSION_RESUMPTION
+    save_tls_session(pcb);
+#endif //PICOHTTPS_TLS_SESSION_RESUMPTION
 
+    printf(
+        "Connected to https://%s:%d (%s handshake, %lu ms)\n",
+        ipaddr_ntoa(&server_ipaddr),
+        LWIP_IANA_PORT_HTTPS,
+        picohttps_timing.resumed ? "resumed" : "full",
+        (unsigned long)picohttps_timing.handshake_ms
+    );
 
+    // Send HTTP request to server
+    printf("Sending request\n");
+    enter(PICOHTTPS_SENDING, PICOHTTPS_TIMEOUT);
+    if(!send_request(pcb)){
+        request_failed = true;                  // picohttps_poll() closes
+        response_complete = true;
+    }
+    return ERR_OK;
+}
@@ -47,11 +47,13 @@
  // HTTP server hostname
  #define PICOHTTPS_HOSTNAME                          "username.github.io"
  
- // DNS response polling interval
+ // Network timeout
  //
- //  Interval with which to poll for responses to DNS queries.
+ //  A request fails if DNS resolution, connection (incl. TLS handshake) or
+ //  sending the request take longer than this, or if nothing is received for
+ //  this long while awaiting the response.
  //
- #define PICOHTTPS_RESOLVE_POLL_INTERVAL             100             // ms
+ #define PICOHTTPS_TIMEOUT                           15000           // ms
  
  // Certificate authority root certificate
  //
@@ -105,7 +107,6 @@
 "jjxDah2nGN59PRbxYvnKkKj9\n" \
 "-----END CERTIFICATE-----\n"
 
- #define PICOHTTPS_ALTCP_CONNECT_POLL_INTERVAL       100             // ms
  
  // TCP + TLS idle connection polling interval
  //
@@ -120,22 +121,73 @@
  //
  #define PICOHTTPS_ALTCP_IDLE_POLL_INTERVAL          2               // shots
  
+ // TLS session resumption
+ //
+ //  When 1, the TLS session of the last connection is kept in RAM and offered
+ //  on the next one. A server that still knows the session (or accepts its
+ //  session ticket) then answers with an abbreviated handshake, skipping the
+ //  key exchange and certificate chain verification that dominate connection
+ //  time on the RP2040. Costs the session (and its ticket) in heap.
+ //
+ //  The session can be serialised with picohttps_tls_session_save() to keep it
+ //  across reboots.
+ //
+ #ifndef PICOHTTPS_TLS_SESSION_RESUMPTION
+ #define PICOHTTPS_TLS_SESSION_RESUMPTION            1
+ #endif //PICOHTTPS_TLS_SESSION_RESUMPTION
+
+ // Compressed transfer
+ //
+ //  When 1, the request offers gzip and deflate content codings and a
+ //  compressed response body is inflated (http_inflate.c) before it reaches
+ //  the body callback. CSV decks compress several times over, cutting download
+ //  and radio-on time to match, at the cost of the inflate window
+ //  (HTTP_INFLATE_WINDOW_SIZE) in RAM.
+ //
+ #ifndef PICOHTTPS_INFLATE
+ #define PICOHTTPS_INFLATE                           1
+ #endif //PICOHTTPS_INFLATE
+
+ #if PICOHTTPS_INFLATE
+ #define PICOHTTPS_ACCEPT_ENCODING                   "Accept-Encoding: gzip, deflate\r\n"
+ #else
+ #define PICOHTTPS_ACCEPT_ENCODING                   ""
+ #endif //PICOHTTPS_INFLATE
+
  // HTTP request
  //
  //  Plain-text HTTP request to send to server
  //
+ //  Request line and fixed headers only; send_request() appends the
+ //  conditional headers (If-None-Match, If-Modified-Since) for the cached deck
+ //  and the terminating blank line.
+ //
  #define PICOHTTPS_REQUEST\
     "GET /anki-csv-decks/cards.csv HTTP/1.1\r\n"\
     "Host: " PICOHTTPS_HOSTNAME "\r\n"\
     "Connection: close\r\n"\
-    "\r\n"
- 
+    PICOHTTPS_ACCEPT_ENCODING
+
+ // HTTP request buffer size
+ //
+ //  Must hold PICOHTTPS_REQUEST plus both conditional headers.
+ //
+ #define PICOHTTPS_REQUEST_SIZE                      512             // bytes
+
+ // Cache validator sizes
+ //
+ //  Size of the buffers (including terminator) holding the ETag and
+ //  Last-Modified response header values. Longer values are not kept.
+ //
+ #define PICOHTTPS_ETAG_SIZE                         128             // bytes
+ #define PICOHTTPS_LAST_MODIFIED_SIZE                32              // bytes
+
  
- // HTTP response polling interval
+ // Request polling interval
  //
- //  Interval with which to poll for HTTP response from server.
+ //  Interval with which fetch_csv() pumps picohttps_poll().
  //
- #define PICOHTTPS_HTTP_RESPONSE_POLL_INTERVAL       100             // ms
+ #define PICOHTTPS_POLL_INTERVAL                     20              // ms
  
  // Mbed TLS debug levels
  //
@@ -153,10 +205,11 @@
  
  
  /* My additions ***************************************************************/
-#define MAX_RESPONSE_SIZE 16384
-extern char response_buffer[MAX_RESPONSE_SIZE];
-extern size_t response_offset;
+extern size_t response_length;     // Bytes received so far, header included
 extern bool response_complete;
+extern int response_status;        // HTTP status code, 0 until the status line is in
+extern int64_t response_content_length;    // Content-Length once the header is in, otherwise -1
+extern struct picohttps_timing picohttps_timing;   // Phases of the last request
  
  
  
@@ -174,51 +227,56 @@ extern bool response_complete;
  //
  typedef int mbedtls_err_t;
  
- // TCP connection callback argument
+ // HTTP response body callback
  //
- //  All callbacks associated with lwIP TCP (+ TLS) connections can be passed a
- //  common argument. This is intended to allow application state to be accessed
- //  from within the callback context. The argument should be registered with
- //  altcp_arg().
+ //  Fired from the TCP + TLS data reception callback (callback_altcp_recv),
+ //  i.e. in lwIP context, with each piece of the response body as it arrives.
+ //  Chunked framing has already been removed and a compressed body inflated.
+ //  Pieces follow packet buffer, chunk and inflate window boundaries, so may
+ //  split the body at any point.
  //
- //  The following structure is used for this argument in order to supply all
- //  the relevant application state required by the various callbacks.
+ typedef void (*picohttps_body_callback)(const char* data, size_t len, void* arg);
+
+ // Fetch timing
+ //
+ //  Wall-clock duration of each phase of the last request, zero for phases
+ //  not reached.
+ //
+ typedef struct picohttps_timing{
+     uint32_t join_ms;               // Wireless network join, 0 if still joined
+     uint32_t resolve_ms;            // DNS query
+     uint32_t handshake_ms;          // TCP connect and TLS handshake
+     uint32_t transfer_ms;           // Request sent to response complete
+     bool resumed;                   // Handshake resumed a cached TLS session
+ } picohttps_timing_t;
+
+ // Request state
+ //
+ //  Progress of the request started by picohttps_start(). DONE and FAILED
+ //  are final; the next request can then be started.
+ //
+ typedef enum{
+     PICOHTTPS_IDLE,                 // No request started yet
+     PICOHTTPS_JOINING,              // Joining wireless network
+     PICOHTTPS_RESOLVING,            // DNS query sent
+     PICOHTTPS_CONNECTING,           // TCP connect and TLS handshake
+     PICOHTTPS_SENDING,              // Request sent, awaiting acknowledgement
+     PICOHTTPS_RECEIVING,            // Awaiting rest of response
+     PICOHTTPS_DONE,                 // Response complete and intact
+     PICOHTTPS_FAILED                // Request failed; see stdio log
+ } picohttps_state_t;
+
+ // Cache validators
  //
- //  https://www.nongnu.org/lwip/2_1_x/group__altcp.html
+ //  ETag and Last-Modified of a previously downloaded response, sent back as
+ //  If-None-Match and If-Modified-Since so that an unchanged file is answered
+ //  with 304 Not Modified and no body. Empty strings when unknown.
  //
- struct altcp_callback_arg{
- 
-     // TCP + TLS connection configurtaion
-     //
-     //  Memory allocated to the connection configuration structure needs to be
-     //  freed (with altcp_tls_free_config) in the connection error callback
-     //  (callback_altcp_err).
-     //
-     //  https://www.nongnu.org/lwip/2_1_x/group__altcp.html
-     //  https://www.nongnu.org/lwip/2_1_x/group__altcp__tls.html
-     //
-     struct altcp_tls_config* config;
- 
-     // TCP + TLS connection state
-     //
-     //  Successful establishment of a connection needs to be signaled to the
-     //  application from the connection connect callback
-     //  (callback_altcp_connect).
-     //
-     //  https://www.nongnu.org/lwip/2_1_x/group__altcp.html
-     //
-     bool connected;
- 
-     // Data reception acknowledgement
-     //
-     //  The amount of data acknowledged as received by the server needs to be
-     //  communicated to the application from the connection sent callback
-     //  (callback_altcp_sent) for validatation of successful transmission.
-     //
-     u16_t acknowledged;
- 
- };
-
+ typedef struct picohttps_validators{
+     char etag[PICOHTTPS_ETAG_SIZE];
+     char last_modified[PICOHTTPS_LAST_MODIFIED_SIZE];
+ } picohttps_validators_t;
+ 
  
  
  
@@ -226,12 +284,62 @@ extern bool response_complete;
  /* Functions ******************************************************************/
  
 
-// Fetch CSV file from server
-// @ return         `true` on success
-// @ return         `false` on failure
-// The main function  of the program. It initializes the standard I/O over USB, the CYW43 wireless hardware, connects to the network, resolves the server hostname.
-// Establishes a TCP + TLS connection with the server, sends an HTTP request, and waits for a response. 
- bool fetch_csv(void);
+// Fetch CSV file from server, blocking
+//
+//  picohttps_start() then picohttps_poll() until the request is done.
+//
+// @param cached    Validators of the copy already held, or NULL
+// @param received  Filled in with the validators of the response, or NULL
+// @param on_body   Called with each piece of the response body as it arrives,
+//                  de-chunked; only 200 OK response bodies are passed on
+// @param arg       Argument passed through to `on_body`
+// @ return         `true` on success; check `response_status` for 200 (new
+//                  body) or 304 (`cached` still current)
+// @ return         `false` on failure, including a malformed response or one
+//                  whose body ended before its framing said it would
+ bool fetch_csv(
+     const picohttps_validators_t* cached,
+     picohttps_validators_t* received,
+     picohttps_body_callback on_body,
+     void* arg
+ );
+
+ // Start fetching CSV file from server
+ //
+ //  Initialises the wireless hardware on first use, then queues the request;
+ //  picohttps_poll() and the lwIP callbacks carry it through joining the
+ //  network (unless still joined), resolving, connecting, sending and
+ //  receiving without blocking.
+ //
+ //  @param cached   Validators of the copy already held, or NULL; copied
+ //  @param received Filled in with the validators of the response, or NULL;
+ //                  must stay valid until the request is done
+ //  @param on_body  As fetch_csv()
+ //  @param arg      Argument passed through to `on_body`
+ //
+ //  @return         `true` if the request was started; `false` if one is
+ //                  already in progress or the hardware failed to initialise
+ //
+ bool picohttps_start(
+     const picohttps_validators_t* cached,
+     picohttps_validators_t* received,
+     picohttps_body_callback on_body,
+     void* arg
+ );
+
+ // Advance request
+ //
+ //  Handles the steps not driven by lwIP callbacks (network join, timeouts,
+ //  closing the connection). Call regularly, e.g. from the main loop, until
+ //  it returns PICOHTTPS_DONE or PICOHTTPS_FAILED; then check
+ //  `response_status` as for fetch_csv().
+ //
+ //  @return         Request state
+ //
+ picohttps_state_t picohttps_poll(void);
+
+ // Whether a request is in progress
+ bool picohttps_busy(void);
 
  // Initialise standard I/O over USB
  //
@@ -245,75 +353,36 @@ extern bool response_complete;
  //
  bool init_cyw43(void);
  
- // Connect to wireless network
- //
- //  @return         `true` on success
- //
- bool connect_to_network(void);
- 
- // Resolve hostname
- //
- //  @param ipaddr   Pointer to an `ip_addr_t` where the resolved IP address
- //                  should be stored.
- //
- //  @return         `true` on success
+ #if PICOHTTPS_TLS_SESSION_RESUMPTION
+
+ // Serialise cached TLS session
  //
- bool resolve_hostname(ip_addr_t* ipaddr);
- 
- // Free TCP + TLS protocol control block
+ //  For persisting the session, e.g. to flash. N.b. the output holds the
+ //  session's master secret.
  //
- //  Memory allocated for a protocol control block (with altcp_tls_new) needs to
- //  be freed (with altcp_close).
+ //  @param buf      Buffer to serialise to
+ //  @param size     Size of `buf`
  //
- //  @param pcb      Pointer to a `altcp_pcb` structure to be freed
+ //  @return         Length written; 0 if no session is cached or it does not
+ //                  fit
  //
- void altcp_free_pcb(struct altcp_pcb* pcb);
- 
- // Free TCP + TLS connection configuration
+ size_t picohttps_tls_session_save(uint8_t* buf, size_t size);
+
+ // Restore cached TLS session
  //
- //  Memory allocated for TCP + TLS connection configuration (with
- //  altcp_tls_create_config_client) needs to be freed (with
- //  altcp_tls_free_config).
+ //  @param buf      Session serialised by picohttps_tls_session_save()
+ //  @param len      Length of `buf`
  //
- //  @param config   Pointer to a `altcp_tls_config` structure to be freed
+ //  @return         `true` if the session will be offered on the next
+ //                  connection
  //
- void altcp_free_config(struct altcp_tls_config* config);
+ bool picohttps_tls_session_load(const uint8_t* buf, size_t len);
 
+ // Forget cached TLS session
+ void picohttps_tls_session_clear(void);
+
+ #endif //PICOHTTPS_TLS_SESSION_RESUMPTION
 
- 
- // Free TCP + TLS connection callback argument
- //
- //  The common argument passed to lwIP connection callbacks must remain in
- //  scope for the duration of all callback contexts (i.e. connection lifetime).
- //  As such, it cannot be declared with function scope when registering the
- //  callback, but rather should be allocated on the heap. This implies the
- //  allocated memory must be freed on connection close.
- //
- //  @param arg      Pointer to a `altcp_callback_arg` structure to be freed
- //
- void altcp_free_arg(struct altcp_callback_arg* arg);
- 
- // Establish TCP + TLS connection with server
- //
- //  @param ipaddr   Pointer to an `ip_addr_t` containing the server's IP
- //                  address
- //  @param pcb      Double pointer to a `altcp_pcb` structure where the
- //                  protocol control block for the established connection
- //                  should be stored.
- //
- //  @return         `true` on success
- //
- bool connect_to_host(ip_addr_t* ipaddr, struct altcp_pcb** pcb);
- 
- // Send HTTP request
- //
- //  @param pcb      Pointer to a `altcp_pcb` structure containing the TCP + TLS
- //                  connection PCB to the server.
- //
- //  @return         `true` on success
- //
- bool send_request(struct altcp_pcb* pcb);
- 
  // DNS response callback
  //
  //  Callback function fired on DNS query response.
@@ -325,7 +394,7 @@ extern bool response_complete;
  void callback_gethostbyname(
      const char* name,
      const ip_addr_t* resolved,
-     void* ipaddr
+     void* arg
  );
  
  // TCP + TLS connection error callback
@@ -377,7 +446,8 @@ extern bool response_complete;
  
  // TCP + TLS connection establishment callback
  //
- //  Callback function fired on successful establishment of TCP + TLS connection.
+ //  Callback function fired on successful establishment of TCP + TLS connection,
+ //  i.e. once the TLS handshake is complete. Sends the request.
  //
  //  Registered with altcp_connect().
  //
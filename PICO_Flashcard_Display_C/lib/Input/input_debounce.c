@@ -0,0 +1,79 @@
+/* Key debouncer **************************************************************
+ *                                                                            *
+ *  A reported change starts the lockout and, for a press, the long-press     *
+ *  wait; a release ends the wait, so a long press is only ever reported      *
+ *  between a press and its release.                                          *
+ *                                                                            *
+ ******************************************************************************/
+
+
+/* Includes *******************************************************************/
+
+#include "input_debounce.h"
+
+
+/* Functions ******************************************************************/
+
+// Whether time `at` has come by `now`, modulo 2^32
+static bool due(uint32_t at, uint32_t now){
+    return (int32_t)(now - at) >= 0;
+}
+
+static void emit(const input_debounce_t* state, input_type_t type, uint32_t now, input_queue_t* queue){
+    input_queue_push(queue, (input_event_t){
+        .key = state->key,
+        .type = type,
+        .time = now
+    });
+}
+
+// Report the level if it differs from the last one reported
+//
+//  @return         `true` if it did
+//
+static bool report(input_debounce_t* state, bool pressed, uint32_t now, input_queue_t* queue){
+    if(pressed == state->pressed) return false;
+    state->pressed = pressed;
+    emit(state, pressed ? INPUT_PRESS : INPUT_RELEASE, now, queue);
+    state->settling = true;
+    state->settle_end = now + INPUT_DEBOUNCE_US;
+    state->holding = pressed;
+    state->hold_end = now + INPUT_LONG_PRESS_MS * 1000u;
+    return true;
+}
+
+void input_debounce_init(input_debounce_t* state, input_key_t key, bool pressed){
+    *state = (input_debounce_t){
+        .key = key,
+        .pressed = pressed
+    };
+}
+
+bool input_debounce_edge(input_debounce_t* state, bool pressed, uint32_t now, input_queue_t* queue){
+    if(state->settling) return false;       // Bounce
+    return report(state, pressed, now, queue);
+}
+
+void input_debounce_timer(input_debounce_t* state, bool pressed, uint32_t now, input_queue_t* queue){
+    if(state->holding && due(state->hold_end, now)){
+        state->holding = false;
+        emit(state, INPUT_LONG_PRESS, now, queue);
+    }
+
+    // End of the lockout: catch a change it hid
+    if(state->settling && due(state->settle_end, now)){
+        state->settling = false;
+        report(state, pressed, now, queue);
+    }
+}
+
+bool input_debounce_deadline(const input_debounce_t* state, uint32_t* when){
+    if(state->settling && (!state->holding || due(state->settle_end, state->hold_end))){
+        *when = state->settle_end;
+    } else if(state->holding){
+        *when = state->hold_end;
+    } else {
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,79 @@
+/* Key debouncer **************************************************************
+ *                                                                            *
+ *  One key's debounce and long-press state machine, apart from the GPIO and  *
+ *  timers that drive it (input_keys.c). The first edge of a change is        *
+ *  reported straight away; further edges are ignored as contact bounce for   *
+ *  INPUT_DEBOUNCE_US, and the level is checked again when that ends, which   *
+ *  reports a change the lockout hid and locks out again. A press still       *
+ *  held INPUT_LONG_PRESS_MS later is reported as a long press.               *
+ *                                                                            *
+ *  Times are time_us_32() values, so compared modulo 2^32.                   *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef INPUT_DEBOUNCE_H
+#define INPUT_DEBOUNCE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "input_keys.h"
+#include "input_queue.h"
+
+
+/* Data structures ************************************************************/
+
+// Key state
+typedef struct{
+    uint8_t key;                    // input_key_t, for the events
+    bool pressed;                   // Last level reported
+    bool settling;                  // Bounce lockout running
+    bool holding;                   // Long press not yet reported
+    uint32_t settle_end;            // When the lockout ends (us)
+    uint32_t hold_end;              // When the long press is due (us)
+} input_debounce_t;
+
+
+/* Functions ******************************************************************/
+
+// Start a key off
+//
+//  @param state    Key state
+//  @param key      Key, for its events
+//  @param pressed  Level at start; not reported
+//
+void input_debounce_init(input_debounce_t* state, input_key_t key, bool pressed);
+
+// Edge on the key's pin
+//
+//  @param state    Key state
+//  @param pressed  Level read after the edge
+//  @param now      Time (us)
+//  @param queue    Takes the events
+//
+//  @return         `true` if the deadline changed
+//
+bool input_debounce_edge(input_debounce_t* state, bool pressed, uint32_t now, input_queue_t* queue);
+
+// Timer expiry
+//
+//  Handles whatever is due by `now`; call at the deadline.
+//
+//  @param state    Key state
+//  @param pressed  Level now
+//  @param now      Time (us)
+//  @param queue    Takes the events
+//
+void input_debounce_timer(input_debounce_t* state, bool pressed, uint32_t now, input_queue_t* queue);
+
+// When the timer is next needed
+//
+//  @param state    Key state
+//  @param when     Set to the time (us)
+//
+//  @return         `false` if it is not
+//
+bool input_debounce_deadline(const input_debounce_t* state, uint32_t* when);
+
+
+#endif //INPUT_DEBOUNCE_H
@@ -0,0 +1,100 @@
+/* Key input ******************************************************************
+ *                                                                            *
+ *  Wires the debouncer (input_debounce.c) and event queue (input_queue.c) to *
+ *  the hardware: edges come from the GPIO interrupt, and each key has one    *
+ *  alarm, set for the debouncer's next deadline.                             *
+ *                                                                            *
+ *  The GPIO interrupt and the timer alarms run at the same priority on the   *
+ *  same core, so they never preempt one another; together they are the       *
+ *  queue's single producer. The main loop is its single consumer.            *
+ *                                                                            *
+ ******************************************************************************/
+
+
+/* Includes *******************************************************************/
+
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+
+#include "input_debounce.h"
+#include "input_keys.h"
+#include "input_queue.h"
+
+
+/* Options ********************************************************************/
+
+#define INPUT_EDGES                                 (GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE)
+
+
+/* Data ***********************************************************************/
+
+static const uint pins[INPUT_KEYS] = {INPUT_KEY0_PIN, INPUT_KEY1_PIN};
+static input_debounce_t keys[INPUT_KEYS];
+static alarm_id_t alarms[INPUT_KEYS];       // 0 if none
+static input_queue_t queue;
+
+
+/* Functions ******************************************************************/
+
+static int64_t alarm_elapsed(alarm_id_t id, void* arg);
+
+// Set the key's alarm for the debouncer's next deadline; interrupt context
+static void schedule(uint32_t key){
+    if(alarms[key]){
+        cancel_alarm(alarms[key]);
+        alarms[key] = 0;
+    }
+    uint32_t when;
+    if(!input_debounce_deadline(&keys[key], &when)) return;
+    int32_t delay = when - time_us_32();
+    alarm_id_t alarm = add_alarm_in_us(delay > 0 ? delay : 1, alarm_elapsed, (void*)(uintptr_t)key, true);
+    alarms[key] = alarm > 0 ? alarm : 0;
+}
+
+static int64_t alarm_elapsed(alarm_id_t id, void* arg){
+    (void)id;
+    uint32_t key = (uintptr_t)arg;
+    alarms[key] = 0;
+    input_debounce_timer(&keys[key], !gpio_get(pins[key]), time_us_32(), &queue);
+    schedule(key);
+    return 0;
+}
+
+static void gpio_irq(void){
+    for(uint32_t key = 0; key < INPUT_KEYS; key++){
+        uint32_t events = gpio_get_irq_event_mask(pins[key]) & INPUT_EDGES;
+        if(!events) continue;
+        gpio_acknowledge_irq(pins[key], events);
+        if(input_debounce_edge(&keys[key], !gpio_get(pins[key]), time_us_32(), &queue)) schedule(key);
+    }
+}
+
+void input_init(void){
+    uint32_t mask = 0;
+    for(uint32_t key = 0; key < INPUT_KEYS; key++){
+        uint pin = pins[key];
+        gpio_init(pin);
+        gpio_set_dir(pin, GPIO_IN);
+        gpio_pull_up(pin);
+        input_debounce_init(&keys[key], key, !gpio_get(pin));
+        mask |= 1u << pin;
+    }
+    gpio_add_raw_irq_handler_masked(mask, gpio_irq);
+    for(uint32_t key = 0; key < INPUT_KEYS; key++){
+        gpio_set_irq_enabled(pins[key], INPUT_EDGES, true);
+    }
+    irq_set_enabled(IO_IRQ_BANK0, true);
+}
+
+bool input_next(input_event_t* event){
+    return input_queue_pop(&queue, event);
+}
+
+bool input_pending(void){
+    return input_queue_pending(&queue);
+}
+
+uint32_t input_dropped(void){
+    return queue.dropped;
+}
@@ -0,0 +1,102 @@
+/* Key input ******************************************************************
+ *                                                                            *
+ *  Turns the display's two keys into press, release and long-press events.   *
+ *  Edges are taken in the GPIO interrupt: the first edge of a change is      *
+ *  reported straight away, then further edges are ignored as contact bounce  *
+ *  until a timer confirms the level. Events wait in a single-producer,       *
+ *  single-consumer ring buffer until the main loop drains it.                *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef INPUT_KEYS_H
+#define INPUT_KEYS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/* Options ********************************************************************/
+
+// Key pins (active low)
+#ifndef INPUT_KEY0_PIN
+#define INPUT_KEY0_PIN                              15
+#endif //INPUT_KEY0_PIN
+#ifndef INPUT_KEY1_PIN
+#define INPUT_KEY1_PIN                              17
+#endif //INPUT_KEY1_PIN
+
+// Bounce lockout
+//
+//  Edges within this long of a reported change are taken as bounce. A
+//  change hidden by the lockout is reported when it ends.
+//
+#ifndef INPUT_DEBOUNCE_US
+#define INPUT_DEBOUNCE_US                           20000           // us
+#endif //INPUT_DEBOUNCE_US
+
+// Hold time for a long press
+#ifndef INPUT_LONG_PRESS_MS
+#define INPUT_LONG_PRESS_MS                         800             // ms
+#endif //INPUT_LONG_PRESS_MS
+
+// Queued events
+//
+//  Power of two. Events arriving with the queue full are dropped.
+//
+#ifndef INPUT_QUEUE_SIZE
+#define INPUT_QUEUE_SIZE                            16
+#endif //INPUT_QUEUE_SIZE
+
+
+/* Data structures ************************************************************/
+
+// Keys
+typedef enum{
+    INPUT_KEY0,
+    INPUT_KEY1,
+    INPUT_KEYS                      // Number of keys
+} input_key_t;
+
+// Event types
+typedef enum{
+    INPUT_PRESS,
+    INPUT_RELEASE,
+    INPUT_LONG_PRESS                // Still held INPUT_LONG_PRESS_MS after
+                                    // the press; the release follows later
+} input_type_t;
+
+// Event
+typedef struct{
+    uint8_t key;                    // input_key_t
+    uint8_t type;                   // input_type_t
+    uint32_t time;                  // time_us_32() when it happened
+} input_event_t;
+
+
+/* Functions ******************************************************************/
+
+// Set up the key pins and their interrupt
+//
+//  Shares the GPIO interrupt with other users (the wireless chip's host
+//  wake line) through a raw handler for the key pins only.
+//
+void input_init(void);
+
+// Take the oldest event
+//
+//  Main loop only.
+//
+//  @param event    Set to the event
+//
+//  @return         `true` if there was one
+//
+bool input_next(input_event_t* event);
+
+// Whether an event is waiting
+bool input_pending(void);
+
+// Events dropped with the queue full, since boot
+uint32_t input_dropped(void);
+
+
+#endif //INPUT_KEYS_H
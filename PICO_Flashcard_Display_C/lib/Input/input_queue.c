@@ -0,0 +1,49 @@
+/* Key event queue ************************************************************
+ *                                                                            *
+ *  The producer signals an event (__sev()) after publishing it, so a         *
+ *  consumer waiting in __wfe() wakes up for it.                              *
+ *                                                                            *
+ ******************************************************************************/
+
+
+/* Includes *******************************************************************/
+
+#include "hardware/sync.h"
+
+#include "input_queue.h"
+
+
+/* Options ********************************************************************/
+
+_Static_assert((INPUT_QUEUE_SIZE & (INPUT_QUEUE_SIZE - 1)) == 0, "queue size must be a power of two");
+
+
+/* Functions ******************************************************************/
+
+bool input_queue_push(input_queue_t* queue, input_event_t event){
+    uint32_t next = queue->head;
+    if(next - queue->tail == INPUT_QUEUE_SIZE){
+        queue->dropped++;
+        return false;
+    }
+    queue->events[next % INPUT_QUEUE_SIZE] = event;
+    __dmb();                                // Event before the index
+    queue->head = next + 1;
+    __sev();                                // Wake a consumer in __wfe()
+    return true;
+}
+
+bool input_queue_pop(input_queue_t* queue, input_event_t* event){
+    uint32_t next = queue->tail;
+    if(next == queue->head) return false;
+    __dmb();                                // Index before the event
+    *event = queue->events[next % INPUT_QUEUE_SIZE];
+    __dmb();                                // Event read before the slot is
+                                            // handed back
+    queue->tail = next + 1;
+    return true;
+}
+
+bool input_queue_pending(const input_queue_t* queue){
+    return queue->tail != queue->head;
+}
@@ -0,0 +1,55 @@
+/* Key event queue ************************************************************
+ *                                                                            *
+ *  Single-producer, single-consumer ring buffer of key events. Each side     *
+ *  only ever writes its own index, so no locks are needed, just barriers to  *
+ *  order the event data against the index that publishes it.                 *
+ *                                                                            *
+ *  The indices run freely and wrap at 2^32; a slot is the index modulo       *
+ *  INPUT_QUEUE_SIZE, which is a power of two so the wrap is seamless.        *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "input_keys.h"
+
+
+/* Data structures ************************************************************/
+
+// Queue
+//
+//  Zero-initialise before first use.
+//
+typedef struct{
+    input_event_t events[INPUT_QUEUE_SIZE];
+    volatile uint32_t head;         // Written by the producer only
+    volatile uint32_t tail;         // Written by the consumer only
+    volatile uint32_t dropped;      // Events pushed with the queue full
+} input_queue_t;
+
+
+/* Functions ******************************************************************/
+
+// Add an event; producer only
+//
+//  @return         `false` if the queue was full and the event dropped
+//
+bool input_queue_push(input_queue_t* queue, input_event_t event);
+
+// Take the oldest event; consumer only
+//
+//  @param event    Set to the event
+//
+//  @return         `true` if there was one
+//
+bool input_queue_pop(input_queue_t* queue, input_event_t* event);
+
+// Whether an event is waiting
+bool input_queue_pending(const input_queue_t* queue);
+
+
+#endif //INPUT_QUEUE_H
@@ -30,6 +30,26 @@
 #include "OLED_1in3_c.h"
 #include "stdio.h"
 
+/*******************************************************************************
+Front buffer and asynchronous flush state
+    OLED_Frame is the bit-reversed copy of what the panel shows once the
+    current flush has finished. Frames are staged into it before sending,
+    so the caller's buffer is free to be repainted as soon as a flush
+    starts, and it is what new frames are diffed against.
+    OLED_Run_Start/OLED_Run_Len give, per image row (panel column), the
+    byte run still to be sent; a zero length skips the column.
+*******************************************************************************/
+static UBYTE OLED_Frame[OLED_1in3_C_ROW_BYTES * OLED_1in3_C_HEIGHT];
+static bool OLED_Frame_Valid = false;
+static UBYTE OLED_Run_Start[OLED_1in3_C_HEIGHT];
+static UBYTE OLED_Run_Len[OLED_1in3_C_HEIGHT];
+static volatile UWORD OLED_Flush_Row;
+static volatile bool OLED_Flush_Busy = false;
+static OLED_1in3_C_Callback OLED_Flush_Done = NULL;
+
+//SPI bytes (commands + data) sent since the current frame started
+static volatile UDOUBLE OLED_Frame_Bytes = 0;
+
 /*******************************************************************************
 function:
 			Hardware reset
@@ -51,10 +71,11 @@ static void OLED_Reset(void)
 
 /*******************************************************************************
 function:
-			Write register address and data
+			Write register address
 *******************************************************************************/
 static void OLED_WriteReg(uint8_t Reg)
 {
+    OLED_Frame_Bytes++;
 #if USE_SPI
     OLED_DC_0;
     OLED_CS_0;
@@ -65,15 +86,37 @@ static void OLED_WriteReg(uint8_t Reg)
 #endif
 }
 
-static void OLED_WriteData(uint8_t Data)
-{	
+/*******************************************************************************
+function:
+			Write a run of register or data bytes under a single CS/DC
+			assertion, so the SPI peripheral sees one transfer per run
+			instead of one per byte
+*******************************************************************************/
+static void OLED_WriteReg_nByte(uint8_t *pReg, uint32_t Len)
+{
+    OLED_Frame_Bytes += Len;
+#if USE_SPI
+    OLED_DC_0;
+    OLED_CS_0;
+    DEV_SPI_Write_nByte(pReg, Len);
+    OLED_CS_1;
+#elif USE_IIC
+    for (uint32_t i = 0; i < Len; i++)
+        I2C_Write_Byte(pReg[i],IIC_CMD);
+#endif
+}
+
+static void OLED_WriteData_nByte(uint8_t *pData, uint32_t Len)
+{
+    OLED_Frame_Bytes += Len;
 #if USE_SPI
     OLED_DC_1;
     OLED_CS_0;
-    DEV_SPI_WriteByte(Data);
+    DEV_SPI_Write_nByte(pData, Len);
     OLED_CS_1;
 #elif USE_IIC
-    I2C_Write_Byte(Data,IIC_RAM);
+    for (uint32_t i = 0; i < Len; i++)
+        I2C_Write_Byte(pData[i],IIC_RAM);
 #endif
 }
 
@@ -129,6 +172,8 @@ function:
 ********************************************************************************/
 void OLED_1in3_C_Init()
 {
+    OLED_1in3_C_Display_Wait();
+    OLED_Frame_Valid = false;
     //Hardware reset
     OLED_Reset();
     printf("OLED Reset\r\n");
@@ -143,26 +188,6 @@ void OLED_1in3_C_Init()
 }
 
 
-/********************************************************************************
-function:
-			Clear screen
-********************************************************************************/
-void OLED_1in3_C_Clear()
-{
-	UWORD Width, Height, column;
-	Width = (OLED_1in3_C_WIDTH % 8 == 0)? (OLED_1in3_C_WIDTH / 8 ): (OLED_1in3_C_WIDTH / 8 + 1);
-	Height = OLED_1in3_C_HEIGHT;  
-	OLED_WriteReg(0xb0); 	//Set the row  start address
-	for (UWORD j = 0; j < Height; j++) {
-		column = 63 - j;
-		OLED_WriteReg(0x00 + (column & 0x0f));  //Set column low start address
-		OLED_WriteReg(0x10 + (column >> 4));  //Set column higt start address
-		for (UWORD i = 0; i < Width; i++) {
-			OLED_WriteData(0x00);
-		 }
-	}
-}
-
 /********************************************************************************
 function:   
             reverse a byte data
@@ -175,27 +200,248 @@ static UBYTE reverse(UBYTE temp)
     return temp;
 }
 
+/********************************************************************************
+function:
+			Address the first byte of a run: page (byte within the column)
+			and column, sent as one command burst
+********************************************************************************/
+static void OLED_SetRunAddress(UWORD Row, UBYTE Start)
+{
+    UWORD column = 63 - Row;
+    UBYTE Reg[3];
+    Reg[0] = 0xb0 + Start;                //Set the page start address
+    Reg[1] = 0x00 + (column & 0x0f);      //Set column low start address
+    Reg[2] = 0x10 + (column >> 4);        //Set column higt start address
+    OLED_WriteReg_nByte(Reg, 3);
+}
+
+/********************************************************************************
+function:
+			Send every pending run synchronously
+********************************************************************************/
+static void OLED_SendRuns(void)
+{
+    UWORD Width = OLED_1in3_C_ROW_BYTES;
+    OLED_Frame_Bytes = 0;
+    for (UWORD j = 0; j < OLED_1in3_C_HEIGHT; j++) {
+        if (OLED_Run_Len[j] == 0)
+            continue;
+        OLED_SetRunAddress(j, OLED_Run_Start[j]);
+        OLED_WriteData_nByte(&OLED_Frame[OLED_Run_Start[j] + j * Width], OLED_Run_Len[j]);
+    }
+}
+
+/********************************************************************************
+function:
+			Clear screen
+********************************************************************************/
+void OLED_1in3_C_Clear()
+{
+	UWORD Width = OLED_1in3_C_ROW_BYTES;
+	OLED_1in3_C_Display_Wait();
+	for (UWORD j = 0; j < OLED_1in3_C_HEIGHT; j++) {
+		for (UWORD i = 0; i < Width; i++) {
+			OLED_Frame[i + j * Width] = 0x00;
+		}
+		OLED_Run_Start[j] = 0;
+		OLED_Run_Len[j] = Width;
+	}
+	OLED_SendRuns();
+	OLED_Frame_Valid = true;
+}
+
 /********************************************************************************
 function:	
 			Update all memory to OLED
 ********************************************************************************/
 void OLED_1in3_C_Display(const UBYTE *Image)
 {		
-    UWORD Width, Height, column, temp;
-    Width = (OLED_1in3_C_WIDTH % 8 == 0)? (OLED_1in3_C_WIDTH / 8 ): (OLED_1in3_C_WIDTH / 8 + 1);
-    Height = OLED_1in3_C_HEIGHT;   
-    OLED_WriteReg(0xb0); 	//Set the row  start address
-    for (UWORD j = 0; j < Height; j++) {
-        column = 63 - j;
-        OLED_WriteReg(0x00 + (column & 0x0f));  //Set column low start address
-        OLED_WriteReg(0x10 + (column >> 4));  //Set column higt start address
+    UWORD Width = OLED_1in3_C_ROW_BYTES;
+    OLED_1in3_C_Display_Wait();
+    for (UWORD j = 0; j < OLED_1in3_C_HEIGHT; j++) {
+        // Stage the whole column reversed so it goes out in one SPI burst
         for (UWORD i = 0; i < Width; i++) {
-            temp = Image[i + j * Width];
-            // printf("0x%x \r\n",temp);
-            temp = reverse(temp);	//reverse the buffer
-            OLED_WriteData(temp);
-         }
-    }   
+            OLED_Frame[i + j * Width] = reverse(Image[i + j * Width]);	//reverse the buffer
+        }
+        OLED_Run_Start[j] = 0;
+        OLED_Run_Len[j] = Width;
+    }
+    OLED_SendRuns();
+    OLED_Frame_Valid = true;
 }
 
+/********************************************************************************
+function:	
+			Advance the asynchronous flush to the next pending run.
+			Runs from the flush start for the first run and from the
+			SPI DMA completion interrupt for every run after that.
+********************************************************************************/
+static void OLED_Flush_Next(void)
+{
+    UWORD Width = OLED_1in3_C_ROW_BYTES;
+    UWORD j = OLED_Flush_Row;
+
+    // The previous data run must have left the shifter before DC drops
+    DEV_SPI_Wait_Idle();
+    OLED_CS_1;
 
+    while (j < OLED_1in3_C_HEIGHT && OLED_Run_Len[j] == 0)
+        j++;
+
+    if (j == OLED_1in3_C_HEIGHT) {
+        OLED_1in3_C_Callback Done = OLED_Flush_Done;
+        OLED_Flush_Busy = false;
+        if (Done)
+            Done();
+        return;
+    }
+
+    OLED_SetRunAddress(j, OLED_Run_Start[j]);
+    OLED_Flush_Row = j + 1;
+    OLED_Frame_Bytes += OLED_Run_Len[j];
+    OLED_DC_1;
+    OLED_CS_0;
+    DEV_SPI_DMA_Write_nByte(&OLED_Frame[OLED_Run_Start[j] + j * Width], OLED_Run_Len[j], OLED_Flush_Next);
+}
+
+/********************************************************************************
+function:	
+			Kick off the pending runs in the background, or finish
+			straight away if there is nothing to send
+********************************************************************************/
+static void OLED_Flush_Begin(OLED_1in3_C_Callback Done)
+{
+    OLED_Frame_Bytes = 0;
+    OLED_Flush_Done = Done;
+    OLED_Flush_Row = 0;
+    OLED_Flush_Busy = true;
+    OLED_Flush_Next();
+}
+
+/********************************************************************************
+function:	
+			Start sending image rows to the OLED in the background.
+parameter:
+    Image : image to send; the requested rows are copied before returning,
+            so it may be redrawn straight away
+    Rows  : bitmap of image rows (panel columns) to send, one bit per row,
+            LSB first; NULL sends the whole frame
+    Done  : called from interrupt context once the panel is up to date,
+            may be NULL
+********************************************************************************/
+void OLED_1in3_C_Display_Rows(const UBYTE *Image, const UBYTE *Rows, OLED_1in3_C_Callback Done)
+{
+    UWORD Width = OLED_1in3_C_ROW_BYTES;
+    OLED_1in3_C_Display_Wait();
+
+    for (UWORD j = 0; j < OLED_1in3_C_HEIGHT; j++) {
+        OLED_Run_Start[j] = 0;
+        OLED_Run_Len[j] = 0;
+        if (Rows != NULL && !(Rows[j >> 3] & (1 << (j & 7))))
+            continue;
+        for (UWORD i = 0; i < Width; i++) {
+            OLED_Frame[i + j * Width] = reverse(Image[i + j * Width]);
+        }
+        OLED_Run_Len[j] = Width;
+    }
+    if (Rows == NULL)
+        OLED_Frame_Valid = true;
+
+#if USE_SPI
+    OLED_Flush_Begin(Done);
+#elif USE_IIC
+    OLED_SendRuns();
+    if (Done)
+        Done();
+#endif
+}
+
+/********************************************************************************
+function:	
+			Start sending a whole image to the OLED in the background
+********************************************************************************/
+void OLED_1in3_C_Display_Start(const UBYTE *Image, OLED_1in3_C_Callback Done)
+{
+    OLED_1in3_C_Display_Rows(Image, NULL, Done);
+}
+
+/********************************************************************************
+function:	
+			Diff an image against the front buffer (what the panel shows)
+			and send, in the background, only the changed bytes of each
+			column, as one run from the first to the last changed byte.
+parameter:
+    Image : new frame; copied before returning
+    Rows  : bitmap of image rows that may have changed, one bit per row,
+            LSB first; NULL compares every row
+    Done  : called from interrupt context once the panel is up to date,
+            may be NULL
+********************************************************************************/
+void OLED_1in3_C_Display_Diff(const UBYTE *Image, const UBYTE *Rows, OLED_1in3_C_Callback Done)
+{
+    UWORD Width = OLED_1in3_C_ROW_BYTES;
+
+    // Before the first full frame the panel contents are unknown
+    if (!OLED_Frame_Valid) {
+        OLED_1in3_C_Display_Start(Image, Done);
+        return;
+    }
+    OLED_1in3_C_Display_Wait();
+
+    for (UWORD j = 0; j < OLED_1in3_C_HEIGHT; j++) {
+        int First = -1, Last = -1;
+        OLED_Run_Start[j] = 0;
+        OLED_Run_Len[j] = 0;
+        if (Rows != NULL && !(Rows[j >> 3] & (1 << (j & 7))))
+            continue;
+        for (UWORD i = 0; i < Width; i++) {
+            UBYTE temp = reverse(Image[i + j * Width]);
+            if (temp != OLED_Frame[i + j * Width]) {
+                OLED_Frame[i + j * Width] = temp;
+                if (First < 0)
+                    First = i;
+                Last = i;
+            }
+        }
+        if (First >= 0) {
+            OLED_Run_Start[j] = First;
+            OLED_Run_Len[j] = Last - First + 1;
+        }
+    }
+
+#if USE_SPI
+    OLED_Flush_Begin(Done);
+#elif USE_IIC
+    OLED_SendRuns();
+    if (Done)
+        Done();
+#endif
+}
+
+/********************************************************************************
+function:	
+			Check whether a background flush is still running
+********************************************************************************/
+bool OLED_1in3_C_Display_Poll(void)
+{
+    return OLED_Flush_Busy;
+}
+
+/********************************************************************************
+function:	
+			Block until any background flush has finished
+********************************************************************************/
+void OLED_1in3_C_Display_Wait(void)
+{
+    while (OLED_Flush_Busy)
+        tight_loop_contents();
+}
+
+/********************************************************************************
+function:	
+			SPI bytes (commands and data) sent for the most recent frame
+********************************************************************************/
+UDOUBLE OLED_1in3_C_Frame_Bytes(void)
+{
+    return OLED_Frame_Bytes;
+}
@@ -46,6 +46,8 @@ function:
 #define OLED_1in3_C_WIDTH  128//OLED width
 #define OLED_1in3_C_HEIGHT 64 //OLED height
 
+#define OLED_1in3_C_ROW_BYTES ((OLED_1in3_C_WIDTH % 8 == 0)? (OLED_1in3_C_WIDTH / 8 ): (OLED_1in3_C_WIDTH / 8 + 1))
+
 #define OLED_CS_0      DEV_Digital_Write(LCD_CS_PIN,0)
 #define OLED_CS_1      DEV_Digital_Write(LCD_CS_PIN,1)
 
@@ -56,9 +58,18 @@ function:
 #define OLED_DC_1       DEV_Digital_Write(LCD_DC_PIN,1)
 
 
+typedef void (*OLED_1in3_C_Callback)(void);
+
 void OLED_1in3_C_Init(void);
 void OLED_1in3_C_Clear(void);
 void OLED_1in3_C_Display(const UBYTE *Image);
 
+void OLED_1in3_C_Display_Start(const UBYTE *Image, OLED_1in3_C_Callback Done);
+void OLED_1in3_C_Display_Rows(const UBYTE *Image, const UBYTE *Rows, OLED_1in3_C_Callback Done);
+void OLED_1in3_C_Display_Diff(const UBYTE *Image, const UBYTE *Rows, OLED_1in3_C_Callback Done);
+bool OLED_1in3_C_Display_Poll(void);
+void OLED_1in3_C_Display_Wait(void);
+UDOUBLE OLED_1in3_C_Frame_Bytes(void);
+
 #endif  
 	 
@@ -0,0 +1,148 @@
+/* Weighted card sampler ******************************************************
+ *                                                                            *
+ *  Vose's method: weights are scaled so they average REVIEW_ALIAS_ONE. Each  *
+ *  step pairs a card below the average with one above it. The small card's   *
+ *  entry keeps its own weight and takes the large card for the rest, and the *
+ *  large card gives up that much. The scaled weights are rounded so they add *
+ *  up to exactly count * REVIEW_ALIAS_ONE, so whatever is left at the end is *
+ *  exactly at the average and always keeps its own card.                     *
+ *                                                                            *
+ *  Scaled weights are kept in the table itself until an entry is final, so   *
+ *  the only extra RAM is the small/large worklist: one card index per card,  *
+ *  small cards stacked from the front and large ones from the back.          *
+ *                                                                            *
+ ******************************************************************************/
+
+
+/* Includes *******************************************************************/
+
+#include <stdlib.h>
+
+#include "review_alias.h"
+#include "review_random.h"
+
+
+/* Options ********************************************************************/
+
+// Scaled average weight
+#define REVIEW_ALIAS_ONE                            (1u << 16)
+
+
+/* Data structures ************************************************************/
+
+// Scaled weight: at most count * REVIEW_ALIAS_ONE
+#if REVIEW_ALIAS_INDEX_BITS == 16
+typedef uint32_t review_alias_scaled_t;     // Clamped, see review_alias_build()
+#else
+typedef uint64_t review_alias_scaled_t;
+#endif //REVIEW_ALIAS_INDEX_BITS
+
+// Table entry while building: scaled weight until final
+typedef union{
+    review_alias_scaled_t scaled;
+    review_alias_entry_t entry;
+} review_alias_slot_t;
+
+_Static_assert(sizeof(review_alias_slot_t) == sizeof(review_alias_entry_t), "slot must overlay entry");
+
+
+/* Functions ******************************************************************/
+
+bool review_alias_build(review_alias_t* alias, uint32_t count, review_alias_weight weight, void* arg, uint32_t seed){
+    if(count == 0 || count > REVIEW_ALIAS_MAX_CARDS) return false;
+
+    uint64_t total = 0;
+    uint32_t heaviest = 0;
+    for(uint32_t i = 0; i < count; i++){
+        uint32_t w = weight(i, arg);
+        total += w;
+        if(w > heaviest) heaviest = w;
+    }
+    if(total == 0) return false;
+
+    // Shift the weights down until weight * count * REVIEW_ALIAS_ONE fits in
+    // 64 bits for every card; never needed with 16 bit indices
+    uint64_t limit = UINT64_MAX / ((uint64_t)count * REVIEW_ALIAS_ONE);
+    int shift = 0;
+    while((heaviest >> shift) > limit) shift++;
+    if(shift){
+        total = 0;
+        for(uint32_t i = 0; i < count; i++) total += (uint64_t)weight(i, arg) >> shift;
+    }
+
+    review_alias_slot_t* slots = alias->count == count
+        ? (review_alias_slot_t*)alias->table
+        : malloc(count * sizeof(review_alias_slot_t));
+    review_alias_index_t* work = malloc(count * sizeof(review_alias_index_t));
+    if(!slots || !work){
+        if(slots != (review_alias_slot_t*)alias->table) free(slots);
+        free(work);
+        return false;
+    }
+
+    // Scale and sort into small and large. Each card's share is rounded down
+    // and the remainders carried on, so a card gets one more whenever they
+    // add up to a whole unit: the scaled weights then sum to exactly
+    // count * REVIEW_ALIAS_ONE, and a card of weight 0 scales to 0. Rounding
+    // each on its own falls short by up to `count`, which past 65536 cards
+    // empties the large stack while cards of weight 0 are still small.
+    //
+    // Only a card with all the weight reaches count * REVIEW_ALIAS_ONE, which
+    // at 65536 cards is one more than 32 bits hold; one less makes no
+    // difference.
+    uint32_t small = 0, large = 0;
+    uint64_t carried = 0;                   // Remainders so far, below total
+    for(uint32_t i = 0; i < count; i++){
+        uint64_t share = ((uint64_t)weight(i, arg) >> shift) * count * REVIEW_ALIAS_ONE;
+        uint64_t scaled = share / total;
+        carried += share % total;
+        if(carried >= total){
+            carried -= total;
+            scaled++;
+        }
+        slots[i].scaled = scaled > (review_alias_scaled_t)-1 ? (review_alias_scaled_t)-1 : scaled;
+        if(slots[i].scaled < REVIEW_ALIAS_ONE) work[small++] = i;
+        else work[count - ++large] = i;
+    }
+
+    // Pair them off
+    while(small > 0 && large > 0){
+        uint32_t s = work[--small];
+        uint32_t l = work[count - large];
+        uint32_t keep = slots[s].scaled;
+        slots[s].entry = (review_alias_entry_t){.keep = keep, .alias = l};
+        slots[l].scaled -= REVIEW_ALIAS_ONE - keep;
+        if(slots[l].scaled < REVIEW_ALIAS_ONE){
+            large--;
+            work[small++] = l;
+        }
+    }
+
+    // Leftovers: exactly at the average, bar the clamped card above
+    while(small > 0){
+        uint32_t i = work[--small];
+        slots[i].entry = (review_alias_entry_t){.keep = UINT16_MAX, .alias = i};
+    }
+    while(large > 0){
+        uint32_t i = work[count - large--];
+        slots[i].entry = (review_alias_entry_t){.keep = UINT16_MAX, .alias = i};
+    }
+    free(work);
+
+    alias->table = (review_alias_entry_t*)slots;
+    alias->count = count;
+    alias->random = review_random_seed(seed);
+    return true;
+}
+
+void review_alias_free(review_alias_t* alias){
+    free(alias->table);
+    *alias = (review_alias_t){0};
+}
+
+uint32_t review_alias_draw(review_alias_t* alias){
+    uint32_t i = review_random_below(&alias->random, alias->count);
+    const review_alias_entry_t* entry = &alias->table[i];
+    uint16_t r = review_random_next(&alias->random);
+    return entry->keep == UINT16_MAX || r < entry->keep ? i : entry->alias;
+}
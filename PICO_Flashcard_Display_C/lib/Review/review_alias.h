@@ -0,0 +1,98 @@
+/* Weighted card sampler ******************************************************
+ *                                                                            *
+ *  Draws card indices with probability proportional to a per-card weight,    *
+ *  in O(1) per draw, using Vose's alias method. Each table entry holds the   *
+ *  chance of keeping its own card and the card to take otherwise.            *
+ *                                                                            *
+ *  Weights are read once per build; to follow changing weights, build the    *
+ *  table again every so often. A build is O(n).                              *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef REVIEW_ALIAS_H
+#define REVIEW_ALIAS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/* Options ********************************************************************/
+
+// Card index width
+//
+//  16 bits covers decks of up to 65536 cards, in 4 bytes per table entry;
+//  32 bits larger ones, in 8.
+//
+#ifndef REVIEW_ALIAS_INDEX_BITS
+#define REVIEW_ALIAS_INDEX_BITS                     16
+#endif //REVIEW_ALIAS_INDEX_BITS
+
+#if REVIEW_ALIAS_INDEX_BITS == 16
+typedef uint16_t review_alias_index_t;
+#define REVIEW_ALIAS_MAX_CARDS                      (UINT16_MAX + 1u)
+#else
+typedef uint32_t review_alias_index_t;
+#define REVIEW_ALIAS_MAX_CARDS                      (1u << 24)
+#endif //REVIEW_ALIAS_INDEX_BITS
+
+
+/* Data structures ************************************************************/
+
+// Table entry
+typedef struct{
+    uint16_t keep;                  // Chance of this entry's own card, in
+                                    // 1/65536ths; UINT16_MAX for always
+    review_alias_index_t alias;     // Card taken otherwise
+} review_alias_entry_t;
+
+// Sampler
+//
+//  Zero-initialise before first use.
+//
+typedef struct{
+    review_alias_entry_t* table;    // Entry per card
+    uint32_t count;                 // Number of cards
+    uint32_t random;                // PRNG state
+} review_alias_t;
+
+// Card weight
+//
+//  @param index    Card index
+//  @param arg      As passed to review_alias_build()
+//
+//  @return         Relative weight; 0 never draws the card
+//
+typedef uint32_t (*review_alias_weight)(uint32_t index, void* arg);
+
+
+/* Functions ******************************************************************/
+
+// Build the table
+//
+//  Needs a table entry of RAM per card, plus a card index per card while
+//  building. The table is reused if the count is unchanged. On failure the
+//  sampler is left as it was.
+//
+//  With 32 bit indices, weights large enough to overflow the arithmetic
+//  are scaled down first; a card whose weight is then rounded to 0 (less
+//  than 2^-23 of the total) is never drawn.
+//
+//  @param alias    Sampler
+//  @param count    Number of cards, 1 to REVIEW_ALIAS_MAX_CARDS
+//  @param weight   Returns the weight of each card; not all 0
+//  @param arg      Passed to `weight`
+//  @param seed     Random seed
+//
+//  @return         `true` on success
+//
+bool review_alias_build(review_alias_t* alias, uint32_t count,
+                        review_alias_weight weight, void* arg, uint32_t seed);
+
+// Release the table
+void review_alias_free(review_alias_t* alias);
+
+// Draw a card index
+uint32_t review_alias_draw(review_alias_t* alias);
+
+
+#endif //REVIEW_ALIAS_H
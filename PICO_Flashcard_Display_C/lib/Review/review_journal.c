@@ -0,0 +1,391 @@
+/* Review journal *************************************************************
+ *                                                                            *
+ *  Log sector s lives in slot s % REVIEW_JOURNAL_LOG_SECTORS. A sector is    *
+ *  only reused once a snapshot covers it, so the log never wraps onto        *
+ *  records nothing else holds.                                               *
+ *                                                                            *
+ *  Records are programmed a page at a time with everything but the new       *
+ *  records left erased (0xff), which leaves bytes already programmed on the  *
+ *  page as they are. A page is therefore written once per batch instead of   *
+ *  once per record, and nothing is erased until a whole sector is used.      *
+ *                                                                            *
+ *  Recovery never writes over a non-erased record slot, so a torn record is  *
+ *  just skipped from then on.                                                *
+ *                                                                            *
+ ******************************************************************************/
+
+
+/* Includes *******************************************************************/
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico/flash.h"
+#include "pico/time.h"
+#include "hardware/flash.h"
+#include "hardware/regs/addressmap.h"
+
+#include "deck_flash.h"
+#include "review_journal.h"
+#include "review_sched.h"
+
+
+/* Options ********************************************************************/
+
+// Region offset of the first log sector
+#define REVIEW_JOURNAL_LOG                          (2 * REVIEW_JOURNAL_SNAPSHOT_SIZE)
+
+// Card states a snapshot area holds
+#define REVIEW_JOURNAL_SNAPSHOT_CARDS               ((REVIEW_JOURNAL_SNAPSHOT_SIZE - FLASH_PAGE_SIZE) / sizeof(review_card_t))
+
+_Static_assert(FLASH_PAGE_SIZE % sizeof(review_journal_record_t) == 0, "records must not straddle pages");
+_Static_assert(sizeof(review_journal_snapshot_t) <= FLASH_PAGE_SIZE, "snapshot header overlaps states");
+
+
+/* Data structures ************************************************************/
+
+// Argument for the operations run under flash_safe_execute()
+typedef struct{
+    uint32_t offset;                // From the start of flash
+    const uint8_t* data;
+    uint32_t len;
+} review_journal_op_t;
+
+// End of the program image, from the SDK linker script
+extern char __flash_binary_end;
+
+
+/* Data ***********************************************************************/
+
+static bool ready = false;
+static bool replayed = false;
+static int snapshot_area = -1;              // Area of the newest snapshot
+static uint32_t covered = 0;                // Last sequence in that snapshot
+static uint32_t sequence = 0;               // Newest log sector
+static bool sector_open = false;            // Sector `sequence` takes records
+static uint32_t write_offset = 0;           // Region offset of next record
+static uint32_t page_offset = 0;            // Region offset of `page`
+static uint8_t page[FLASH_PAGE_SIZE];       // Records not yet programmed,
+                                            // erased elsewhere
+static uint32_t pending = 0;                // Records in `page`
+static uint32_t last_time = 0;              // Clock (s) of the last record
+static uint32_t clock_base = 0;             // Clock (s) at boot
+static const review_card_t* sort_states;    // For compare_seen()
+
+
+/* Functions ******************************************************************/
+
+static void do_erase(void* arg){
+    review_journal_op_t* op = arg;
+    flash_range_erase(op->offset, op->len);
+}
+
+static void do_program(void* arg){
+    review_journal_op_t* op = arg;
+    flash_range_program(op->offset, op->data, op->len);
+}
+
+static bool erase(uint32_t offset, uint32_t len){
+    review_journal_op_t op = {REVIEW_JOURNAL_OFFSET + offset, NULL, len};
+    return flash_safe_execute(do_erase, &op, UINT32_MAX) == PICO_OK;
+}
+
+static bool program(uint32_t offset, const uint8_t* data, uint32_t len){
+    review_journal_op_t op = {REVIEW_JOURNAL_OFFSET + offset, data, len};
+    return flash_safe_execute(do_program, &op, UINT32_MAX) == PICO_OK;
+}
+
+// Memory-mapped (XIP) address within the region
+static const void* region(uint32_t offset){
+    return (const void*)(XIP_BASE + REVIEW_JOURNAL_OFFSET + offset);
+}
+
+static uint32_t sector_offset(uint32_t seq){
+    return REVIEW_JOURNAL_LOG + seq % REVIEW_JOURNAL_LOG_SECTORS * FLASH_SECTOR_SIZE;
+}
+
+static uint8_t record_check(const review_journal_record_t* record){
+    return deck_flash_crc32(0, record, offsetof(review_journal_record_t, check));
+}
+
+static bool record_erased(const review_journal_record_t* record){
+    const uint8_t* bytes = (const uint8_t*)record;
+    for(uint32_t i = 0; i < sizeof(review_journal_record_t); i++){
+        if(bytes[i] != 0xff) return false;
+    }
+    return true;
+}
+
+// Snapshot in an area, if it checks out
+static const review_journal_snapshot_t* valid_snapshot(uint32_t area){
+    const review_journal_snapshot_t* header = region(area * REVIEW_JOURNAL_SNAPSHOT_SIZE);
+    if(header->magic != REVIEW_JOURNAL_SNAPSHOT_MAGIC) return NULL;
+    if(header->version != REVIEW_JOURNAL_VERSION) return NULL;
+    if(header->header_crc != deck_flash_crc32(0, header, offsetof(review_journal_snapshot_t, header_crc))) return NULL;
+    if(header->cards > REVIEW_JOURNAL_SNAPSHOT_CARDS) return NULL;
+    const void* cards = region(area * REVIEW_JOURNAL_SNAPSHOT_SIZE + FLASH_PAGE_SIZE);
+    if(header->cards_crc != deck_flash_crc32(0, cards, header->cards * sizeof(review_card_t))) return NULL;
+    return header;
+}
+
+// Log sector header at a region offset, if it checks out
+static const review_journal_sector_t* valid_sector(uint32_t offset){
+    const review_journal_sector_t* header = region(offset);
+    if(header->magic != REVIEW_JOURNAL_SECTOR_MAGIC) return NULL;
+    if(header->crc != deck_flash_crc32(0, header, offsetof(review_journal_sector_t, crc))) return NULL;
+    return header;
+}
+
+// Walk the records of a log sector
+//
+//  Replays them if asked, and sets `end` past the last slot in use, torn
+//  or not.
+//
+//  @return         Clock (s) of the last record
+//
+static uint32_t scan_sector(uint32_t offset, bool replay, uint32_t* end){
+    const review_journal_sector_t* header = region(offset);
+    uint32_t time = header->time;
+    *end = offset + sizeof(review_journal_sector_t);
+    for(uint32_t at = *end; at < offset + FLASH_SECTOR_SIZE; at += sizeof(review_journal_record_t)){
+        const review_journal_record_t* record = region(at);
+        if(record_erased(record)) continue;
+        *end = at + sizeof(review_journal_record_t);
+        if(record->check != record_check(record) || record->grade > REVIEW_GRADE_EASY) continue;
+        time += record->delta;
+        if(replay) review_sched_replay(record->hash, record->grade, time);
+    }
+    return time;
+}
+
+// Program the records buffered
+static bool flush(void){
+    if(pending == 0) return true;
+    bool ok = program(page_offset, page, FLASH_PAGE_SIZE);
+    memset(page, 0xff, sizeof(page));
+    pending = 0;
+    return ok;
+}
+
+// Order card indices by hash, for the snapshot
+static int compare_seen(const void* a, const void* b){
+    uint32_t hash_a = sort_states[*(const uint16_t*)a].hash;
+    uint32_t hash_b = sort_states[*(const uint16_t*)b].hash;
+    return (hash_a > hash_b) - (hash_a < hash_b);
+}
+
+// Snapshot the schedule into the other area
+//
+//  Covers every log sector up to `sequence`. Cards never seen are left out;
+//  review_sched_load() treats missing cards as new anyway.
+//
+static bool compact(uint32_t now){
+    uint32_t count;
+    const review_card_t* states = review_sched_cards(&count);
+    if(!states) return false;
+    uint16_t* order = malloc(count * sizeof(uint16_t));
+    if(!order){
+        printf("No RAM to snapshot review schedule\n");
+        return false;
+    }
+    uint32_t seen = 0;
+    for(uint32_t i = 0; i < count; i++){
+        if(states[i].due != REVIEW_SCHED_NEW) order[seen++] = i;
+    }
+    sort_states = states;
+    qsort(order, seen, sizeof(uint16_t), compare_seen);
+    if(seen > REVIEW_JOURNAL_SNAPSHOT_CARDS){
+        printf("Review snapshot keeps %u of %lu cards seen\n", (unsigned)REVIEW_JOURNAL_SNAPSHOT_CARDS, (unsigned long)seen);
+        seen = REVIEW_JOURNAL_SNAPSHOT_CARDS;
+    }
+
+    // States after the header page, packed across page boundaries
+    uint32_t area = snapshot_area == 0 ? 1 : 0;
+    uint32_t base = area * REVIEW_JOURNAL_SNAPSHOT_SIZE;
+    uint32_t offset = base + FLASH_PAGE_SIZE;
+    uint32_t fill = 0;
+    uint32_t crc = 0;
+    bool ok = erase(base, REVIEW_JOURNAL_SNAPSHOT_SIZE);
+    for(uint32_t i = 0; i < seen && ok; i++){
+        const uint8_t* bytes = (const uint8_t*)&states[order[i]];
+        crc = deck_flash_crc32(crc, bytes, sizeof(review_card_t));
+        for(uint32_t b = 0; b < sizeof(review_card_t) && ok; b++){
+            page[fill++] = bytes[b];
+            if(fill == FLASH_PAGE_SIZE){
+                ok = program(offset, page, FLASH_PAGE_SIZE);
+                offset += FLASH_PAGE_SIZE;
+                fill = 0;
+            }
+        }
+    }
+    free(order);
+    if(ok && fill > 0){
+        memset(page + fill, 0xff, FLASH_PAGE_SIZE - fill);
+        ok = program(offset, page, FLASH_PAGE_SIZE);
+    }
+
+    // Header last
+    review_journal_snapshot_t header = {
+        .magic = REVIEW_JOURNAL_SNAPSHOT_MAGIC,
+        .version = REVIEW_JOURNAL_VERSION,
+        .covered = sequence,
+        .time = now,
+        .cards = seen,
+        .cards_crc = crc
+    };
+    header.header_crc = deck_flash_crc32(0, &header, offsetof(review_journal_snapshot_t, header_crc));
+    memset(page, 0xff, sizeof(page));
+    memcpy(page, &header, sizeof(header));
+    if(ok) ok = program(base, page, FLASH_PAGE_SIZE);
+    memset(page, 0xff, sizeof(page));
+
+    if(!ok || !valid_snapshot(area)){
+        printf("Failed to write review snapshot\n");
+        return false;
+    }
+    snapshot_area = area;
+    covered = sequence;
+    return true;
+}
+
+// Start the next log sector
+//
+//  A sector left out of a failed snapshot is picked up by the next one,
+//  which covers every sector up to its own; until then the ring has to
+//  hold it. With the ring full, a snapshot is tried again instead, once the
+//  schedule has every logged grade in it; the grade just given is in the
+//  snapshot then, so is not logged.
+//
+//  @return         `true` if the grade is to be logged
+//
+static bool open_sector(uint32_t now){
+    uint32_t next = sequence + 1;
+    uint32_t offset = sector_offset(next);
+    const review_journal_sector_t* old = valid_sector(offset);
+    if(old && old->sequence > covered){
+        if(replayed && compact(now)) return false;
+        printf("Review journal full\n");
+        ready = false;
+        return false;
+    }
+
+    review_journal_sector_t header = {
+        .magic = REVIEW_JOURNAL_SECTOR_MAGIC,
+        .sequence = next,
+        .time = now
+    };
+    header.crc = deck_flash_crc32(0, &header, offsetof(review_journal_sector_t, crc));
+    memcpy(page, &header, sizeof(header));
+    page_offset = offset;
+    pending = 1;
+    if(!erase(offset, FLASH_SECTOR_SIZE) || !flush()){
+        printf("Failed to start review journal sector\n");
+        ready = false;
+        return false;
+    }
+    sequence = next;
+    sector_open = true;
+    write_offset = offset + sizeof(header);
+    last_time = now;
+    return true;
+}
+
+bool review_journal_init(void){
+    if((uintptr_t)&__flash_binary_end > XIP_BASE + REVIEW_JOURNAL_OFFSET){
+        printf("Program image overlaps review journal\n");
+        return false;
+    }
+
+    // Nothing carried over from before, as after a reset
+    ready = false;
+    replayed = false;
+    snapshot_area = -1;
+    covered = 0;
+    sector_open = false;
+    pending = 0;
+    memset(page, 0xff, sizeof(page));
+
+    // Newest snapshot
+    const review_journal_snapshot_t* snapshot = NULL;
+    for(uint32_t area = 0; area < 2; area++){
+        const review_journal_snapshot_t* header = valid_snapshot(area);
+        if(header && (!snapshot || header->covered > snapshot->covered)){
+            snapshot = header;
+            snapshot_area = area;
+        }
+    }
+    uint32_t now = 0;
+    if(snapshot){
+        covered = snapshot->covered;
+        now = snapshot->time;
+        review_sched_restore(region(snapshot_area * REVIEW_JOURNAL_SNAPSHOT_SIZE + FLASH_PAGE_SIZE), snapshot->cards);
+    }
+
+    // Newest log sector, and where its records end
+    sequence = covered;
+    for(uint32_t slot = 0; slot < REVIEW_JOURNAL_LOG_SECTORS; slot++){
+        const review_journal_sector_t* header = valid_sector(REVIEW_JOURNAL_LOG + slot * FLASH_SECTOR_SIZE);
+        if(header && header->sequence > sequence && sector_offset(header->sequence) == REVIEW_JOURNAL_LOG + slot * FLASH_SECTOR_SIZE){
+            sequence = header->sequence;
+        }
+    }
+    if(sequence > covered){
+        uint32_t offset = sector_offset(sequence);
+        now = scan_sector(offset, false, &write_offset);
+        sector_open = write_offset < offset + FLASH_SECTOR_SIZE;
+    }
+
+    last_time = now;
+    clock_base = now - to_us_since_boot(get_absolute_time()) / 1000000;
+    ready = true;
+    printf("Review journal: snapshot to sector %lu, log to %lu\n", (unsigned long)covered, (unsigned long)sequence);
+    return true;
+}
+
+void review_journal_replay(void){
+    if(!ready || replayed) return;
+    replayed = true;
+
+    // Sectors after the snapshot, oldest first
+    uint32_t first = covered + 1;
+    if(sequence >= REVIEW_JOURNAL_LOG_SECTORS && first < sequence - REVIEW_JOURNAL_LOG_SECTORS + 1){
+        first = sequence - REVIEW_JOURNAL_LOG_SECTORS + 1;
+    }
+    for(uint32_t seq = first; seq <= sequence; seq++){
+        const review_journal_sector_t* header = valid_sector(sector_offset(seq));
+        uint32_t end;
+        if(header && header->sequence == seq) scan_sector(sector_offset(seq), true, &end);
+    }
+}
+
+void review_journal_record(uint32_t hash, review_grade_t grade, uint32_t now){
+    if(!ready) return;
+    if(!sector_open && !open_sector(now)) return;
+
+    review_journal_record_t record = {
+        .hash = hash,
+        .delta = now - last_time > UINT16_MAX ? UINT16_MAX : now - last_time,
+        .grade = grade
+    };
+    record.check = record_check(&record);
+    page_offset = write_offset & ~(FLASH_PAGE_SIZE - 1);
+    memcpy(page + (write_offset - page_offset), &record, sizeof(record));
+    write_offset += sizeof(record);
+    last_time = now;
+
+    // Write out a batch, or a page full
+    if(++pending < REVIEW_JOURNAL_BATCH && write_offset % FLASH_PAGE_SIZE != 0) return;
+    if(!flush()) printf("Failed to write review journal\n");
+
+    // Sector full: fold it into a snapshot, then move on
+    if(write_offset % FLASH_SECTOR_SIZE == 0){
+        sector_open = false;
+        compact(now);
+    }
+}
+
+uint32_t review_journal_clock(void){
+    return clock_base + to_us_since_boot(get_absolute_time()) / 1000000;
+}
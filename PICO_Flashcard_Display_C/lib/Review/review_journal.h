@@ -0,0 +1,163 @@
+/* Review journal *************************************************************
+ *                                                                            *
+ *  Keeps the review schedule across reboots. Every grade is appended to a    *
+ *  log in flash as a fixed-width record; when a log sector fills, the whole *
+ *  schedule is written out as a snapshot and the log starts afresh. On boot  *
+ *  the newest snapshot is restored and the log since replayed on top.        *
+ *                                                                            *
+ *  The journal also keeps the scheduler clock: seconds the Pico has been on, *
+ *  summed over boots, so due times stay meaningful after a restart.          *
+ *                                                                            *
+ *  The region sits just below the deck flash region (see deck_flash.h):     *
+ *                                                                            *
+ *    0                             snapshot area 0                           *
+ *    REVIEW_JOURNAL_SNAPSHOT_SIZE  snapshot area 1                           *
+ *    2 x that                      REVIEW_JOURNAL_LOG_SECTORS log sectors    *
+ *                                                                            *
+ *  Snapshots alternate between the two areas, so the previous one survives   *
+ *  a snapshot cut short. Log sectors are used in turn, spreading the wear.   *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef REVIEW_JOURNAL_H
+#define REVIEW_JOURNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "hardware/flash.h"
+
+#include "deck_flash.h"
+#include "review_sched.h"
+
+
+/* Options ********************************************************************/
+
+// Snapshot area size
+//
+//  Bounds the cards whose state is kept: one page of header, then 12 bytes
+//  per card seen, i.e. 5440 cards. Multiple of FLASH_SECTOR_SIZE.
+//
+#ifndef REVIEW_JOURNAL_SNAPSHOT_SIZE
+#define REVIEW_JOURNAL_SNAPSHOT_SIZE                (64 * 1024)     // bytes
+#endif //REVIEW_JOURNAL_SNAPSHOT_SIZE
+
+// Log sectors
+//
+//  A sector holds 510 records. At least 2.
+//
+#ifndef REVIEW_JOURNAL_LOG_SECTORS
+#define REVIEW_JOURNAL_LOG_SECTORS                  8
+#endif //REVIEW_JOURNAL_LOG_SECTORS
+
+// Records per flash write
+//
+//  Records are buffered in RAM and programmed a batch at a time. Up to this
+//  many less one are lost if power goes.
+//
+#ifndef REVIEW_JOURNAL_BATCH
+#define REVIEW_JOURNAL_BATCH                        8
+#endif //REVIEW_JOURNAL_BATCH
+
+// Region placement
+#define REVIEW_JOURNAL_SIZE                         \
+    (2 * REVIEW_JOURNAL_SNAPSHOT_SIZE +             \
+     REVIEW_JOURNAL_LOG_SECTORS * FLASH_SECTOR_SIZE)
+#define REVIEW_JOURNAL_OFFSET                       \
+    (DECK_FLASH_OFFSET - REVIEW_JOURNAL_SIZE)
+
+// Header identification
+#define REVIEW_JOURNAL_SNAPSHOT_MAGIC               0x53564552      // "REVS"
+#define REVIEW_JOURNAL_SECTOR_MAGIC                 0x4c564552      // "REVL"
+#define REVIEW_JOURNAL_VERSION                      1
+
+
+/* Data structures ************************************************************/
+
+// Snapshot header
+//
+//  First page of a snapshot area; the card states, in ascending hash
+//  order, start on the next page. Written last.
+//
+typedef struct{
+    uint32_t magic;                 // REVIEW_JOURNAL_SNAPSHOT_MAGIC
+    uint32_t version;               // REVIEW_JOURNAL_VERSION
+    uint32_t covered;               // Log sectors up to this sequence are in
+                                    // the snapshot
+    uint32_t time;                  // Clock (s) when taken
+    uint32_t cards;                 // Number of card states
+    uint32_t cards_crc;             // CRC-32 of the card states
+    uint32_t header_crc;            // CRC-32 of the fields above
+} review_journal_snapshot_t;
+
+// Log sector header
+//
+//  Start of each log sector, followed by records.
+//
+typedef struct{
+    uint32_t magic;                 // REVIEW_JOURNAL_SECTOR_MAGIC
+    uint32_t sequence;              // One more than the previous sector's
+    uint32_t time;                  // Clock (s) the first record counts from
+    uint32_t crc;                   // CRC-32 of the fields above
+} review_journal_sector_t;
+
+// Log record
+//
+//  A record is never rewritten, so one cut short by power loss fails its
+//  check and is skipped.
+//
+typedef struct{
+    uint32_t hash;                  // Card content hash
+    uint16_t delta;                 // Seconds since the previous record
+                                    // (saturating)
+    uint8_t grade;                  // review_grade_t
+    uint8_t check;                  // Low byte of CRC-32 of the fields above
+} review_journal_record_t;
+
+_Static_assert(sizeof(review_journal_record_t) == 8, "records are fixed width");
+_Static_assert(sizeof(review_journal_sector_t) % sizeof(review_journal_record_t)
+               == 0, "records must align");
+_Static_assert(REVIEW_JOURNAL_SNAPSHOT_SIZE % FLASH_SECTOR_SIZE == 0,
+               "snapshot areas must be whole sectors");
+_Static_assert(REVIEW_JOURNAL_LOG_SECTORS >= 2,
+               "log needs a sector to move on to");
+
+
+/* Functions ******************************************************************/
+
+// Recover the journal
+//
+//  Hands the newest snapshot to review_sched_restore() and sets the clock
+//  from the last record. Call before the first review_sched_load().
+//
+//  @return         `true` if the journal can be used
+//
+bool review_journal_init(void);
+
+// Replay the log
+//
+//  Applies the grades logged since the snapshot through
+//  review_sched_replay(). Call after the first successful
+//  review_sched_load(); later calls do nothing.
+//
+void review_journal_replay(void);
+
+// Log a grade
+//
+//  Called after review_sched_grade(). Filling a log sector snapshots the
+//  schedule, which takes a few flash erases.
+//
+//  @param hash     Card content hash
+//  @param grade    Grade given
+//  @param now      Clock (s) as given to review_sched_grade()
+//
+void review_journal_record(uint32_t hash, review_grade_t grade, uint32_t now);
+
+// Scheduler clock
+//
+//  @return         Seconds on, over all boots
+//
+uint32_t review_journal_clock(void);
+
+
+#endif //REVIEW_JOURNAL_H
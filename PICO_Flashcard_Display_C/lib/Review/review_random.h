@@ -0,0 +1,39 @@
+/* Review randomness **********************************************************
+ *                                                                            *
+ *  Small PRNG shared by the card pickers: xorshift32, plus unbiased ranges.  *
+ *  Not for anything security related.                                        *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef REVIEW_RANDOM_H
+#define REVIEW_RANDOM_H
+
+#include <stdint.h>
+
+
+/* Functions ******************************************************************/
+
+// Usable state from any seed; xorshift sticks at 0
+static inline uint32_t review_random_seed(uint32_t seed){
+    return seed ? seed : 0x9e3779b9;
+}
+
+// Next value, never 0
+static inline uint32_t review_random_next(uint32_t* state){
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+// Uniform in [0, bound), rejecting the values that would bias a modulo
+static inline uint32_t review_random_below(uint32_t* state, uint32_t bound){
+    uint32_t limit = UINT32_MAX - UINT32_MAX % bound;
+    uint32_t r;
+    do r = review_random_next(state); while(r >= limit);
+    return r % bound;
+}
+
+
+#endif //REVIEW_RANDOM_H
@@ -0,0 +1,366 @@
+/* Review scheduler ***********************************************************
+ *                                                                            *
+ *  SM-2 with intervals in minutes:                                           *
+ *                                                                            *
+ *    AGAIN   ease -0.20, back in REVIEW_SCHED_RELEARN, passes reset          *
+ *    HARD    ease -0.15, interval x1.2                                       *
+ *    GOOD    first pass 1 day, second 6 days, then interval x ease           *
+ *    EASY    ease +0.15, as GOOD x1.3                                        *
+ *                                                                            *
+ *  The heap holds the index of every card that has been seen and is not in   *
+ *  hand, ordered by the due time in its state. Cards not yet seen are        *
+ *  introduced in shuffled order; the shuffle visits every card once per      *
+ *  epoch, so finding each of them costs O(1) amortised.                      *
+ *                                                                            *
+ *  With nothing due and every card seen, cards are reviewed ahead of time,   *
+ *  drawn from an alias table weighted towards cards with a low ease factor.  *
+ *  The drawn card is taken out of the middle of the heap, which is what the  *
+ *  heap position per card is for.                                            *
+ *                                                                            *
+ *  Grades replayed from the journal only update card state; the heap is      *
+ *  rebuilt once, on the next review_sched_next().                            *
+ *                                                                            *
+ ******************************************************************************/
+
+
+/* Includes *******************************************************************/
+
+#include <stdlib.h>
+
+#include "review_alias.h"
+#include "review_random.h"
+#include "review_sched.h"
+#include "review_shuffle.h"
+
+
+/* Options ********************************************************************/
+
+// No card in hand
+#define REVIEW_SCHED_NONE                           UINT32_MAX
+
+
+/* Data ***********************************************************************/
+
+static review_card_t* cards = NULL;         // State per card index
+static uint16_t* heap = NULL;               // Card indices, min-heap on due
+static uint16_t* position = NULL;           // Heap node per card index
+static uint32_t card_count = 0;
+static uint32_t heap_size = 0;
+static review_shuffle_t new_order;          // Order cards are first shown in
+static uint32_t unseen = 0;                 // Cards still REVIEW_SCHED_NEW
+static uint32_t in_hand = REVIEW_SCHED_NONE;
+static uint32_t last_taken = REVIEW_SCHED_NONE;
+static review_alias_t ahead;                // Review-ahead sampler
+static uint32_t graded_since_build = 0;     // Grades the sampler has not seen
+static uint32_t random_state;
+
+static const review_card_t* restored = NULL;// Sorted state for the next load
+static uint32_t restored_count = 0;
+static bool heap_stale = false;             // Card state changed under the heap
+static uint16_t* by_hash = NULL;            // Card indices sorted by hash,
+                                            // while replaying
+
+
+/* Functions ******************************************************************/
+
+// Heap ordering
+static bool due_before(uint32_t a, uint32_t b){
+    return cards[heap[a]].due < cards[heap[b]].due;
+}
+
+static void place(uint32_t node, uint32_t index){
+    heap[node] = index;
+    position[index] = node;
+}
+
+static void swap(uint32_t a, uint32_t b){
+    uint16_t card = heap[a];
+    place(a, heap[b]);
+    place(b, card);
+}
+
+static void sift_up(uint32_t node){
+    while(node > 0){
+        uint32_t parent = (node - 1) / 2;
+        if(!due_before(node, parent)) break;
+        swap(node, parent);
+        node = parent;
+    }
+}
+
+static void sift_down(uint32_t node){
+    while(true){
+        uint32_t first = node;
+        uint32_t left = 2 * node + 1;
+        uint32_t right = left + 1;
+        if(left < heap_size && due_before(left, first)) first = left;
+        if(right < heap_size && due_before(right, first)) first = right;
+        if(first == node) break;
+        swap(node, first);
+        node = first;
+    }
+}
+
+static void push(uint32_t index){
+    place(heap_size, index);
+    sift_up(heap_size++);
+}
+
+// Take the card at any node, O(log n)
+static uint32_t remove_node(uint32_t node){
+    uint32_t index = heap[node];
+    if(node < --heap_size){
+        place(node, heap[heap_size]);
+        sift_down(node);
+        sift_up(node);
+    }
+    return index;
+}
+
+static uint32_t pop(void){
+    return remove_node(0);
+}
+
+// Rebuild the heap from card state: every card seen and not in hand
+static void build_heap(void){
+    heap_size = 0;
+    unseen = 0;
+    for(uint32_t i = 0; i < card_count; i++){
+        if(i == in_hand) continue;
+        if(cards[i].due != REVIEW_SCHED_NEW){
+            position[i] = heap_size;
+            heap[heap_size++] = i;
+        } else {
+            unseen++;
+        }
+    }
+
+    // Heapify bottom-up, O(n)
+    for(uint32_t node = heap_size / 2; node-- > 0;) sift_down(node);
+    heap_stale = false;
+}
+
+// Review-ahead weight: ease drops with every hard or forgotten review, so
+// weigh by how low it is, squared. A card at the lowest ease comes up about
+// 3.5 times as often as a new one, and one at the highest hardly ever.
+static uint32_t ahead_weight(uint32_t index, void* arg){
+    (void)arg;
+    uint32_t weight = UINT8_MAX + 1 - cards[index].ease;
+    return weight * weight;
+}
+
+// Card to review ahead of time, every card being in the heap
+static uint32_t take_ahead(void){
+    if(graded_since_build >= REVIEW_SCHED_REWEIGHT || ahead.count != card_count){
+        if(review_alias_build(&ahead, card_count, ahead_weight, NULL, review_random_next(&random_state))){
+            graded_since_build = 0;
+        }
+    }
+    if(ahead.count != card_count) return pop();  // No RAM for the sampler
+
+    uint32_t card;
+    do card = review_alias_draw(&ahead); while(card == last_taken && card_count > 1);
+    return remove_node(position[card]);
+}
+
+// Order states by hash, for the lookup in review_sched_load()
+static int compare_hash(const void* a, const void* b){
+    uint32_t hash_a = ((const review_card_t*)a)->hash;
+    uint32_t hash_b = ((const review_card_t*)b)->hash;
+    return (hash_a > hash_b) - (hash_a < hash_b);
+}
+
+// Scale minutes, saturating at the interval limit
+static uint16_t scale(uint32_t minutes, uint32_t percent){
+    minutes = minutes * percent / 100;
+    return minutes > UINT16_MAX ? UINT16_MAX : minutes;
+}
+
+bool review_sched_load(uint32_t count, uint32_t (*hash)(uint32_t index), uint32_t seed){
+    if(count == 0 || count > UINT16_MAX) return false;
+    review_card_t* new_cards = malloc(count * sizeof(review_card_t));
+    uint16_t* new_heap = malloc(count * sizeof(uint16_t));
+    uint16_t* new_position = malloc(count * sizeof(uint16_t));
+    if(!new_cards || !new_heap || !new_position || !review_shuffle_init(&new_order, count, seed)){
+        free(new_cards);
+        free(new_heap);
+        free(new_position);
+        return false;
+    }
+
+    // Sort the old states so each new card's state is a binary search away
+    // (restored state comes sorted)
+    uint32_t hand_hash = in_hand != REVIEW_SCHED_NONE ? cards[in_hand].hash : 0;
+    bool hand_valid = in_hand != REVIEW_SCHED_NONE;
+    const review_card_t* old = restored;
+    uint32_t old_count = restored_count;
+    if(!old){
+        if(cards) qsort(cards, card_count, sizeof(review_card_t), compare_hash);
+        old = cards;
+        old_count = card_count;
+    }
+
+    in_hand = REVIEW_SCHED_NONE;
+    for(uint32_t i = 0; i < count; i++){
+        review_card_t key = {.hash = hash(i)};
+        const review_card_t* known = old
+            ? bsearch(&key, old, old_count, sizeof(review_card_t), compare_hash)
+            : NULL;
+        if(known){
+            new_cards[i] = *known;
+        } else {
+            new_cards[i] = (review_card_t){
+                .hash = key.hash,
+                .due = REVIEW_SCHED_NEW,
+                .ease = REVIEW_SCHED_EASE_START - REVIEW_SCHED_EASE_MIN
+            };
+        }
+        if(hand_valid && in_hand == REVIEW_SCHED_NONE && key.hash == hand_hash) in_hand = i;
+    }
+    free(cards);
+    free(heap);
+    free(position);
+    cards = new_cards;
+    heap = new_heap;
+    position = new_position;
+    card_count = count;
+    last_taken = REVIEW_SCHED_NONE;
+    random_state = review_random_seed(seed);
+    restored = NULL;
+    free(by_hash);
+    by_hash = NULL;
+
+    // The old sampler is the wrong size, or weighted for the wrong cards
+    if(ahead.count != count) review_alias_free(&ahead);
+    graded_since_build = REVIEW_SCHED_REWEIGHT;
+
+    build_heap();
+    return true;
+}
+
+void review_sched_restore(const review_card_t* sorted, uint32_t count){
+    restored = count ? sorted : NULL;
+    restored_count = count;
+}
+
+bool review_sched_next(uint32_t now, uint32_t* index){
+    if(card_count == 0) return false;
+    if(heap_stale){
+        free(by_hash);
+        by_hash = NULL;
+        build_heap();
+    }
+
+    // Put back a card that was never graded
+    if(in_hand != REVIEW_SCHED_NONE){
+        if(cards[in_hand].due == REVIEW_SCHED_NEW) cards[in_hand].due = now;
+        push(in_hand);
+        in_hand = REVIEW_SCHED_NONE;
+    }
+
+    if(heap_size > 0 && cards[heap[0]].due <= now){
+        in_hand = pop();
+    } else if(unseen > 0){
+        uint32_t card;
+        do card = review_shuffle_next(&new_order); while(cards[card].due != REVIEW_SCHED_NEW);
+        in_hand = card;
+        unseen--;
+    } else {
+        in_hand = take_ahead();             // Nothing due: review ahead
+    }
+    last_taken = in_hand;
+    *index = in_hand;
+    return true;
+}
+
+// Apply a grade to a card's state, SM-2
+static void update(review_card_t* card, review_grade_t grade, uint32_t now){
+    int ease = card->ease;
+    uint32_t due_in;                        // s
+
+    switch(grade){
+        case REVIEW_GRADE_AGAIN:
+            ease -= 20;
+            card->reps = 0;
+            card->interval = 0;
+            due_in = REVIEW_SCHED_RELEARN * 60;
+            break;
+
+        case REVIEW_GRADE_HARD:
+        case REVIEW_GRADE_GOOD:
+        case REVIEW_GRADE_EASY:
+            if(grade == REVIEW_GRADE_HARD){
+                ease -= 15;
+                card->interval = card->reps == 0
+                    ? REVIEW_SCHED_RELEARN
+                    : scale(card->interval, 120);
+            } else {
+                if(grade == REVIEW_GRADE_EASY) ease += 15;
+                if(card->reps == 0) card->interval = REVIEW_SCHED_FIRST_INTERVAL;
+                else if(card->reps == 1) card->interval = REVIEW_SCHED_SECOND_INTERVAL;
+                else card->interval = scale(card->interval, REVIEW_SCHED_EASE_MIN + card->ease);
+                if(grade == REVIEW_GRADE_EASY) card->interval = scale(card->interval, 130);
+            }
+            if(card->reps < UINT8_MAX) card->reps++;
+            due_in = card->interval * 60;
+            break;
+
+        case REVIEW_GRADE_NONE:
+        default:
+            due_in = REVIEW_SCHED_DEFER;
+            break;
+    }
+    card->ease = ease < 0 ? 0 : ease > UINT8_MAX ? UINT8_MAX : ease;
+
+    // Saturate below REVIEW_SCHED_NEW
+    card->due = now < REVIEW_SCHED_NEW - 1 - due_in ? now + due_in : REVIEW_SCHED_NEW - 1;
+}
+
+void review_sched_grade(review_grade_t grade, uint32_t now){
+    if(in_hand == REVIEW_SCHED_NONE) return;
+    update(&cards[in_hand], grade, now);
+    push(in_hand);
+    in_hand = REVIEW_SCHED_NONE;
+    graded_since_build++;
+}
+
+// Order card indices by hash, for review_sched_replay()
+static int compare_index_hash(const void* a, const void* b){
+    return compare_hash(&cards[*(const uint16_t*)a], &cards[*(const uint16_t*)b]);
+}
+
+void review_sched_replay(uint32_t hash, review_grade_t grade, uint32_t time){
+    if(card_count == 0) return;
+
+    // Index the cards by hash on the first replay after a load; without the
+    // RAM for it, search linearly
+    if(!heap_stale){
+        heap_stale = true;
+        by_hash = malloc(card_count * sizeof(uint16_t));
+        if(by_hash){
+            for(uint32_t i = 0; i < card_count; i++) by_hash[i] = i;
+            qsort(by_hash, card_count, sizeof(uint16_t), compare_index_hash);
+        }
+    }
+
+    review_card_t* card = NULL;
+    if(by_hash){
+        uint32_t low = 0, high = card_count;
+        while(low < high){
+            uint32_t middle = (low + high) / 2;
+            if(cards[by_hash[middle]].hash < hash) low = middle + 1;
+            else high = middle;
+        }
+        if(low < card_count && cards[by_hash[low]].hash == hash) card = &cards[by_hash[low]];
+    } else {
+        for(uint32_t i = 0; i < card_count && !card; i++){
+            if(cards[i].hash == hash) card = &cards[i];
+        }
+    }
+    if(card) update(card, grade, time);     // Cards no longer in the deck are dropped
+}
+
+const review_card_t* review_sched_cards(uint32_t* count){
+    *count = card_count;
+    return cards;
+}
@@ -0,0 +1,168 @@
+/* Review scheduler ***********************************************************
+ *                                                                            *
+ *  Picks the next card to show using SM-2 style spaced repetition. Each card *
+ *  has an ease factor and interval; passing a card pushes its due time out   *
+ *  by the interval, failing it brings the card back within minutes.          *
+ *                                                                            *
+ *  Cards that have been seen are kept in a min-heap keyed by due time, so    *
+ *  picking and re-scheduling a card is O(log n). Cards not yet seen are      *
+ *  introduced once nothing is due, in random order (see review_shuffle.h).   *
+ *  Once every card has been seen, cards are reviewed ahead of time while     *
+ *  nothing is due, the harder ones more often (see review_alias.h).          *
+ *                                                                            *
+ *  Card state is keyed by content hash (deck_hash()), so it carries over to  *
+ *  a new deck for every card whose text is unchanged.                        *
+ *                                                                            *
+ *  Time is the caller's clock in seconds; it only needs to be monotonic.    *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef REVIEW_SCHED_H
+#define REVIEW_SCHED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/* Options ********************************************************************/
+
+// Ease factor
+//
+//  Stored in hundredths above REVIEW_SCHED_EASE_MIN, so 1.30 to 3.85.
+//
+#ifndef REVIEW_SCHED_EASE_MIN
+#define REVIEW_SCHED_EASE_MIN                       130
+#endif //REVIEW_SCHED_EASE_MIN
+#ifndef REVIEW_SCHED_EASE_START
+#define REVIEW_SCHED_EASE_START                     250
+#endif //REVIEW_SCHED_EASE_START
+
+// Intervals
+//
+//  In minutes. Intervals are capped at UINT16_MAX minutes (about 45 days).
+//
+#ifndef REVIEW_SCHED_RELEARN
+#define REVIEW_SCHED_RELEARN                        10              // minutes
+#endif //REVIEW_SCHED_RELEARN
+#ifndef REVIEW_SCHED_FIRST_INTERVAL
+#define REVIEW_SCHED_FIRST_INTERVAL                 (24 * 60)       // minutes
+#endif //REVIEW_SCHED_FIRST_INTERVAL
+#ifndef REVIEW_SCHED_SECOND_INTERVAL
+#define REVIEW_SCHED_SECOND_INTERVAL                (6 * 24 * 60)   // minutes
+#endif //REVIEW_SCHED_SECOND_INTERVAL
+
+// Delay for a card shown with nobody looking
+//
+//  Its schedule is left alone; it is just put back a little.
+//
+#ifndef REVIEW_SCHED_DEFER
+#define REVIEW_SCHED_DEFER                          (30 * 60)       // s
+#endif //REVIEW_SCHED_DEFER
+
+// Grades between rebuilds of the review-ahead weights
+#ifndef REVIEW_SCHED_REWEIGHT
+#define REVIEW_SCHED_REWEIGHT                       32
+#endif //REVIEW_SCHED_REWEIGHT
+
+// Due time of a card not yet seen
+#define REVIEW_SCHED_NEW                            UINT32_MAX
+
+
+/* Data structures ************************************************************/
+
+// How well the card in hand was recalled
+typedef enum{
+    REVIEW_GRADE_NONE,              // Not reviewed (nobody interacted)
+    REVIEW_GRADE_AGAIN,             // Forgotten
+    REVIEW_GRADE_HARD,              // Recalled with effort
+    REVIEW_GRADE_GOOD,              // Recalled
+    REVIEW_GRADE_EASY               // Recalled without needing the back
+} review_grade_t;
+
+// Per-card state
+//
+//  12 bytes, plus 2 bytes each of heap, heap position and shuffle per card.
+//  Reviewing ahead adds a 4 byte alias table entry per card.
+//
+typedef struct{
+    uint32_t hash;                  // Card content hash
+    uint32_t due;                   // Clock (s) when next due, or
+                                    // REVIEW_SCHED_NEW
+    uint16_t interval;              // Last interval (minutes), 0 until passed
+    uint8_t ease;                   // Ease factor above REVIEW_SCHED_EASE_MIN
+    uint8_t reps;                   // Passes in a row (saturating)
+} review_card_t;
+
+_Static_assert(sizeof(review_card_t) == 12, "card state is stored in flash");
+
+
+/* Functions ******************************************************************/
+
+// Load deck
+//
+//  (Re)builds the schedule for a deck of `cards` cards, keeping the state
+//  of cards already known by hash, including the card in hand. State
+//  handed to review_sched_restore() is used instead, if any. RAM is
+//  allocated per card; on failure the previous schedule is kept.
+//
+//  @param cards    Number of cards, at most UINT16_MAX
+//  @param hash     Returns the content hash of a card by index
+//  @param seed     Random seed for the order new cards are shown in
+//
+//  @return         `true` on success
+//
+bool review_sched_load(uint32_t cards, uint32_t (*hash)(uint32_t index),
+                       uint32_t seed);
+
+// Take the next card
+//
+//  The earliest card due by `now`, else a card not seen yet, else any card
+//  weighted by difficulty (but not the previous one). The card becomes the
+//  card in hand until graded; a card in hand that was never graded is put
+//  back as it was.
+//
+//  @param now      Clock (s)
+//  @param index    Set to the card's index
+//
+//  @return         `true` unless no deck is loaded
+//
+bool review_sched_next(uint32_t now, uint32_t* index);
+
+// Grade the card in hand and schedule it
+//
+//  @param grade    How well it was recalled
+//  @param now      Clock (s)
+//
+void review_sched_grade(review_grade_t grade, uint32_t now);
+
+// Restore saved state
+//
+//  The next review_sched_load() takes card state from `sorted` rather than
+//  from the current schedule, so it must stay readable until then.
+//
+//  @param sorted   Card states in ascending hash order
+//  @param count    Number of states
+//
+void review_sched_restore(const review_card_t* sorted, uint32_t count);
+
+// Replay a grade
+//
+//  Applies a grade given earlier to the card with that hash, if the deck
+//  has it. Call between review_sched_load() and review_sched_next().
+//
+//  @param hash     Card content hash
+//  @param grade    Grade given
+//  @param time     Clock (s) it was given at
+//
+void review_sched_replay(uint32_t hash, review_grade_t grade, uint32_t time);
+
+// Card state, for saving
+//
+//  @param count    Set to the number of cards
+//
+//  @return         State by card index, NULL if no deck is loaded
+//
+const review_card_t* review_sched_cards(uint32_t* count);
+
+
+#endif //REVIEW_SCHED_H
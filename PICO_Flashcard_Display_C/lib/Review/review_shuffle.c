@@ -0,0 +1,62 @@
+/* Shuffled deck iterator *****************************************************
+ *                                                                            *
+ *  Draw i of an epoch swaps a uniformly chosen entry from order[i..n) into   *
+ *  order[i] and returns it, which is exactly one step of Fisher-Yates. At    *
+ *  the end of an epoch the array is still a permutation, so the next epoch   *
+ *  just shuffles it again from the start.                                   *
+ *                                                                            *
+ *  The first draw of an epoch leaves out the last card of the previous one.  *
+ *                                                                            *
+ ******************************************************************************/
+
+
+/* Includes *******************************************************************/
+
+#include <stdlib.h>
+
+#include "review_random.h"
+#include "review_shuffle.h"
+
+
+/* Functions ******************************************************************/
+
+bool review_shuffle_init(review_shuffle_t* shuffle, uint32_t count, uint32_t seed){
+    if(count == 0 || count > UINT16_MAX + 1) return false;
+    uint16_t* order = malloc(count * sizeof(uint16_t));
+    if(!order) return false;
+    for(uint32_t i = 0; i < count; i++) order[i] = i;
+
+    free(shuffle->order);
+    shuffle->order = order;
+    shuffle->count = count;
+    shuffle->position = 0;
+    shuffle->epoch = 0;
+    shuffle->random = review_random_seed(seed);
+    return true;
+}
+
+void review_shuffle_free(review_shuffle_t* shuffle){
+    free(shuffle->order);
+    *shuffle = (review_shuffle_t){0};
+}
+
+uint32_t review_shuffle_next(review_shuffle_t* shuffle){
+    uint32_t n = shuffle->count;
+    uint32_t i = shuffle->position;
+
+    // Keep the previous epoch's last card, at order[n - 1], out of the first
+    // draw; on the very first epoch there is nothing to avoid
+    uint32_t pool = n - i;
+    if(i == 0 && shuffle->epoch > 0 && n > 1) pool--;
+
+    uint32_t j = i + review_random_below(&shuffle->random, pool);
+    uint16_t card = shuffle->order[j];
+    shuffle->order[j] = shuffle->order[i];
+    shuffle->order[i] = card;
+
+    if(++shuffle->position == n){
+        shuffle->position = 0;
+        shuffle->epoch++;
+    }
+    return card;
+}
@@ -0,0 +1,57 @@
+/* Shuffled deck iterator *****************************************************
+ *                                                                            *
+ *  Draws card indices without replacement: every card once per epoch, in a   *
+ *  fresh random order each epoch, and never the same card twice in a row.    *
+ *                                                                            *
+ *  The order is a uint16_t permutation shuffled in place by Fisher-Yates,    *
+ *  one step per draw, so each draw is O(1) and an epoch starts without a    *
+ *  pass over the deck.                                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef REVIEW_SHUFFLE_H
+#define REVIEW_SHUFFLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/* Data structures ************************************************************/
+
+// Iterator
+//
+//  Zero-initialise before first use.
+//
+typedef struct{
+    uint16_t* order;                // Permutation of card indices
+    uint32_t count;                 // Number of cards
+    uint32_t position;              // Draws made this epoch
+    uint32_t epoch;                 // Completed epochs
+    uint32_t random;                // PRNG state
+} review_shuffle_t;
+
+
+/* Functions ******************************************************************/
+
+// Start over on a deck
+//
+//  RAM is allocated at 2 bytes per card; on failure the iterator is left
+//  as it was.
+//
+//  @param shuffle  Iterator
+//  @param count    Number of cards, 1 to UINT16_MAX + 1
+//  @param seed     Random seed
+//
+//  @return         `true` on success
+//
+bool review_shuffle_init(review_shuffle_t* shuffle, uint32_t count,
+                         uint32_t seed);
+
+// Release the permutation
+void review_shuffle_free(review_shuffle_t* shuffle);
+
+// Draw the next card index
+uint32_t review_shuffle_next(review_shuffle_t* shuffle);
+
+
+#endif //REVIEW_SHUFFLE_H
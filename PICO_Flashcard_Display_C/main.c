@@ -9,148 +9,67 @@
     #include "pico/cyw43_arch.h"
     #include "time.h"
     #include "picohttps.h"
+    #include "deck_csv.h"
+    #include "deck_store.h"
+    #include "input_keys.h"
+    #include "review_journal.h"
+    #include "review_sched.h"
+    #include "review_shuffle.h"
     #include "hardware/watchdog.h"
 
 
 
-    #define MAX_CARDS 1000
     #define MAX_LINE_LENGTH 256
     #define DISPLAY_INTERVAL_MS 60000 // 1 minute
-    #define MAX_RESPONSE_SIZE 16384 // 16KB response buffer
+
+    // Background deck refresh: every interval plus up to the jitter, so a
+    // room full of displays does not hit the server at the same moment
+    #define REFRESH_INTERVAL_MS (30 * 60 * 1000) // 30 minutes
+    #define REFRESH_JITTER_MS (5 * 60 * 1000)
 
     //Constants for drawing large amounts of text on the OLED across multiple pages
     #define PAGE_DURATION_MS 5000
     #define MAX_LINES 5
     #define MAX_CHARS_PER_LINE 23
 
-    typedef struct {
-        char *front;
-        char *back;
-    } Flashcard;
-
     typedef enum {
         FLASH_NONE,   // timeout or page scroll
         FLASH_FLIP,   // key1 pressed
-        FLASH_SKIP,    // key0 pressed
-        FLASH_TIMEOUT // card lifetime expired
+        FLASH_SKIP,    // key0 clicked
+        FLASH_FORGOT,  // key0 held
+        FLASH_TIMEOUT, // card lifetime expired
+        FLASH_NEW_DECK // background refresh swapped in a new deck
     } FlashAction;
 
 
-    Flashcard flashcards[MAX_CARDS];
-    int flashcard_count = 0;
-
-    // Parse CSV to flashcards and fill the array
-    void trim_whitespace(char *str) {
-        if (!str) return;
-    
-        // Trim leading
-        while (*str == ' ' || *str == '\t' || *str == '\r' || *str == '\n') {
-            str++;
-        }
-    
-        // Trim trailing
-        char *end = str + strlen(str) - 1;
-        while (end > str && (*end == ' ' || *end == '\t' || *end == '\r' || *end == '\n')) {
-            *end-- = '\0';
-        }
-    }
-    
-   
-    /* ----------------------------------------------
-   Very small CSV parser for exactly two columns.
-   Handles:
-     • quoted and un-quoted fields
-     • embedded commas
-     • embedded CR/LF inside quoted fields
-     • escaped quotes  ""  →  "
-   Returns number of flash-cards parsed.
-   ----------------------------------------------*/
-    static int parse_csv(char *csv)
-    {
-        flashcard_count = 0;
-        char *p = csv;
-
-        while (*p && flashcard_count < MAX_CARDS) {
-
-            // ---- Field 0 (front) ----
-            char *front = NULL, *back = NULL;
-            size_t front_len = 0, back_len = 0;
-
-            if (*p == '"') {                         // ► quoted field
-                p++;                                 // skip opening "
-                char *start = p;
-                while (*p) {
-                    if (*p == '"' && p[1] == '"') {  // ""  ->  "
-                        p += 2;
-                    } else if (*p == '"') {          // closing "
-                        break;
-                    } else {
-                        p++;
-                    }
-                }
-                front_len = (size_t)(p - start);
-                front = strndup(start, front_len);
-                if (*p == '"') p++;                  // skip closing "
-            } else {                                // ► un-quoted field
-                char *start = p;
-                while (*p && *p != ',' && *p != '\r' && *p != '\n') p++;
-                front_len = (size_t)(p - start);
-                front = strndup(start, front_len);
-            }
-
-            // expect comma separator
-            if (*p == ',') p++; else break;
-
-            // ---- Field 1 (back) ----
-            if (*p == '"') {
-                p++;
-                char *start = p;
-                while (*p) {
-                    if (*p == '"' && p[1] == '"') {      // escaped quote
-                        p += 2;
-                    } else if (*p == '"') {              // closing quote
-                        break;
-                    } else {
-                        p++;
-                    }
-                }
-                back_len = (size_t)(p - start);
-                back = strndup(start, back_len);
-                if (*p == '"') p++;
-            } else {
-                char *start = p;
-                while (*p && *p != '\r' && *p != '\n') p++;
-                back_len = (size_t)(p - start);
-                back = strndup(start, back_len);
-            }
+    // Frames drawn vs. loop passes that found the page unchanged, reported over stdio
+    typedef struct {
+        uint32_t rendered;
+        uint32_t skipped;
+    } FrameStats;
 
-            // consume end-of-record  (CR? LF?)
-            if (*p == '\r') p++;
-            if (*p == '\n') p++;
 
-            // trim leading/trailing space if you wish
-            trim_whitespace(front);
-            trim_whitespace(back);
+    FrameStats frame_stats = {0};
+    deck_csv_parser_t csv_parser;
 
-            if (front[0] && back[0]) {
-                flashcards[flashcard_count].front = front;
-                flashcards[flashcard_count].back  = back;
-                flashcard_count++;
-            } else {        // bad record: release memory
-                free(front);  free(back);
-            }
+    // Parsed card: append to the deck in flash. Once the slot fills up, the
+    // cards that no longer fit are dropped; report that once, not per card.
+    static void store_card(const char *front, const char *back, void *arg) {
+        (void)arg;
+        if (!deck_store_add(front, back) && deck_store_dropped() == 1) {
+            printf("Deck store full at card %lu, dropping cards that do not fit\n",
+                   (unsigned long)(deck_store_staged() + 1));
         }
-
-        return flashcard_count;
     }
-    
 
+    // Response body, straight from the receive callback: feed the CSV parser
+    static void parse_csv_chunk(const char *data, size_t len, void *arg) {
+        deck_csv_feed((deck_csv_parser_t *)arg, data, len);
+    }
 
-        
-            
-    
-
-    void show_text_on_oled(const char *text) {
+    // Back buffer shared by everything drawn on the OLED. The driver keeps the
+    // front copy (what the panel currently shows) and diffs new frames against it.
+    UBYTE *get_display_image(void) {
         static UBYTE *BlackImage = NULL;
         if (BlackImage == NULL) {
             UWORD Imagesize = ((OLED_1in3_C_WIDTH % 8 == 0) ? 
@@ -165,33 +84,200 @@
     
             Paint_NewImage(BlackImage, OLED_1in3_C_WIDTH, OLED_1in3_C_HEIGHT, 0, WHITE);
         }
+        return BlackImage;
+    }
+
+    // Send whatever changed in the back buffer since the last flush
+    void flush_display(void) {
+        OLED_1in3_C_Display_Diff(get_display_image(), Paint_GetDirtyRows(), NULL);
+        Paint_ClearDirty();
+    }
+
+    void show_text_on_oled(const char *text) {
+        get_display_image();
     
         Paint_Clear(BLACK);
         Paint_DrawString_EN(10, 17, text, &Font12, WHITE, BLACK);
-        OLED_1in3_C_Display(BlackImage);
+        flush_display();
     }
 
-    
-    
-    FlashAction show_flashcard(const char *text, absolute_time_t card_deadline) {
+    // Draw one page of a card side and send it to the panel
+    void draw_flashcard_page(const char *text, int page) {
+        int text_len = strlen(text);
+        int start_index = page * MAX_LINES * MAX_CHARS_PER_LINE;
 
-        int key0 = 15; 
-        int key1 = 17;
+        get_display_image();
 
+        Paint_Clear(BLACK);
+        for (int i = 0; i < MAX_LINES; i++) {
+            int line_start = start_index + i * MAX_CHARS_PER_LINE;
+            if (line_start >= text_len) break;
 
-        static UBYTE *BlackImage = NULL;
-        if (BlackImage == NULL) {
-            UWORD Imagesize = ((OLED_1in3_C_WIDTH % 8 == 0) ? 
-                               (OLED_1in3_C_WIDTH / 8) : 
-                               (OLED_1in3_C_WIDTH / 8 + 1)) * OLED_1in3_C_HEIGHT;
-            BlackImage = (UBYTE *)malloc(Imagesize);
-            if (BlackImage == NULL) {
-                printf("Failed to allocate display buffer.\n");
-                while (1);
-            }
-            Paint_NewImage(BlackImage, OLED_1in3_C_WIDTH, OLED_1in3_C_HEIGHT, 0, WHITE);
+            char line[MAX_CHARS_PER_LINE + 1] = {0};
+            strncpy(line, text + line_start, MAX_CHARS_PER_LINE);
+            line[MAX_CHARS_PER_LINE] = '\0';
+
+            Paint_DrawString_EN(2, i * 12 + 4, line, &Font8, WHITE, BLACK);
         }
+        // Only bytes that differ from the panel go out, over DMA while we poll the keys
+        flush_display();
+    }
     
+    // Deck refresh state. The new deck is written to the flash slot not in
+    // use, so the current deck stays readable until deck_store_finish()
+    // swaps it out.
+    static picohttps_validators_t refresh_cached, refresh_received;
+    static bool refresh_running = false;
+    static absolute_time_t next_refresh_time;
+
+    static void schedule_refresh(void) {
+        next_refresh_time = make_timeout_time_ms(REFRESH_INTERVAL_MS + rand() % REFRESH_JITTER_MS);
+    }
+
+    // Start downloading the deck into the staging slot. The request is
+    // conditional on the current deck's ETag/Last-Modified, so an unchanged
+    // deck costs a 304 rather than the whole CSV.
+    static bool start_refresh(void) {
+        snprintf(refresh_cached.etag, sizeof(refresh_cached.etag), "%s", deck_etag());
+        snprintf(refresh_cached.last_modified, sizeof(refresh_cached.last_modified), "%s", deck_last_modified());
+
+        // Cards are parsed as the response streams in
+        if (!deck_store_begin()) {
+            printf("Deck flash region unavailable\n");
+            return false;
+        }
+        deck_csv_init(&csv_parser, store_card, NULL);
+        if (!picohttps_start(&refresh_cached, &refresh_received, parse_csv_chunk, &csv_parser)) {
+            deck_store_abort();
+            return false;
+        }
+        return true;
+    }
+
+    // Finish a download: swap the new deck in if it is complete and non-empty.
+    // Sets *swapped when the current deck was replaced.
+    static bool finish_refresh(bool fetched, bool *swapped) {
+        *swapped = false;
+        if (!fetched) {
+            // Includes a body cut short of its Content-Length or last chunk,
+            // so a partial deck never replaces the saved one
+            deck_store_abort();
+            return false;
+        }
+        if (response_status == 304) {
+            printf("Deck not modified, keeping saved deck\n");
+            deck_store_abort();
+            return true;
+        }
+        if (response_status != 200) {
+            printf("Unexpected HTTP status %d, keeping current deck\n", response_status);
+            deck_store_abort();
+            return false;
+        }
+        if (deck_csv_finish(&csv_parser) == 0) {
+            printf("Downloaded deck is empty, keeping current deck\n");
+            deck_store_abort();
+            return false;
+        }
+        if (!deck_store_finish(refresh_received.etag, refresh_received.last_modified)) {
+            printf("Failed to write deck to flash\n");
+            return false;
+        }
+        printf("Parsing finished: %lu cards\n", (unsigned long)deck_count());
+        if (deck_store_dropped()) {
+            // Stored without its ETag/Last-Modified, so the next refresh
+            // fetches the whole deck again rather than getting a 304
+            printf("Deck truncated: %lu cards did not fit in flash\n", (unsigned long)deck_store_dropped());
+        }
+        *swapped = true;
+        return true;
+    }
+
+    // Download the deck, blocking; for when there is nothing to show yet
+    bool refresh_deck(void) {
+        if (!start_refresh()) return false;
+        picohttps_state_t state;
+        while ((state = picohttps_poll()) != PICOHTTPS_DONE && state != PICOHTTPS_FAILED) {
+            sleep_ms(PICOHTTPS_POLL_INTERVAL);
+        }
+        bool swapped;
+        return finish_refresh(state == PICOHTTPS_DONE, &swapped);
+    }
+
+    // Advance the background refresh, starting it when due. Called from the
+    // display loop; the download itself runs in lwIP callbacks.
+    // Returns true when a new deck has just been swapped in.
+    static bool poll_refresh(void) {
+        if (!refresh_running) {
+            if (absolute_time_diff_us(get_absolute_time(), next_refresh_time) > 0) return false;
+            schedule_refresh();
+            refresh_running = start_refresh();
+            return false;
+        }
+        picohttps_state_t state = picohttps_poll();
+        if (state != PICOHTTPS_DONE && state != PICOHTTPS_FAILED) return false;
+        refresh_running = false;
+        bool swapped;
+        finish_refresh(state == PICOHTTPS_DONE, &swapped);
+        return swapped;
+    }
+
+    // Review schedule for the current deck. Without the RAM for it
+    // (18 bytes per card) cards are shuffled instead, each shown once
+    // before any repeats.
+    static bool schedule_ready = false;
+    static review_shuffle_t shuffle;
+
+    // (Re)build the schedule for the current deck; cards it shares with the
+    // previous deck keep their state. The first time, the grades journalled
+    // in flash since the last snapshot are replayed on top.
+    static void load_schedule(void) {
+        schedule_ready = review_sched_load(deck_count(), deck_hash, rand());
+        if (schedule_ready) {
+            review_shuffle_free(&shuffle);
+            review_journal_replay();
+            return;
+        }
+        printf("No RAM to schedule %lu cards, shuffling them instead\n", (unsigned long)deck_count());
+        if (!review_shuffle_init(&shuffle, deck_count(), rand())) {
+            review_shuffle_free(&shuffle);
+        }
+    }
+
+    static uint32_t next_card(void) {
+        uint32_t index;
+        if (schedule_ready && review_sched_next(review_journal_clock(), &index)) return index;
+        if (shuffle.order) return review_shuffle_next(&shuffle);
+        return rand() % deck_count();
+    }
+
+    // Grade how the card went: skipped without flipping means it was known,
+    // one look at the back is a pass, and going back and forth means it was
+    // hard or forgotten. Holding KEY0 marks it forgotten outright. A card
+    // nobody touched is not graded at all.
+    // Grades are journalled so the schedule survives a reboot.
+    static void grade_card(uint32_t card, FlashAction act, int flips) {
+        review_grade_t grade;
+        if (act == FLASH_FORGOT) {
+            grade = REVIEW_GRADE_AGAIN;
+        } else if (flips == 0) {
+            grade = act == FLASH_SKIP ? REVIEW_GRADE_EASY : REVIEW_GRADE_NONE;
+        } else if (act == FLASH_TIMEOUT || flips == 2) {
+            grade = REVIEW_GRADE_HARD;           // lingered on it, or checked the front again
+        } else {
+            grade = flips == 1 ? REVIEW_GRADE_GOOD : REVIEW_GRADE_AGAIN;
+        }
+        if (!schedule_ready) return;
+        uint32_t now = review_journal_clock();
+        review_sched_grade(grade, now);
+        review_journal_record(deck_hash(card), grade, now);
+    }
+
+    // A long press of KEY0 has been acted on, so its release is not a click
+    static bool key0_held = false;
+
+    FlashAction show_flashcard(const char *text, absolute_time_t card_deadline) {
+
         // Split the text into pages
         int text_len = strlen(text);
         int page_size = MAX_LINES * MAX_CHARS_PER_LINE;
@@ -199,107 +285,123 @@
     
         absolute_time_t next_page_time = make_timeout_time_ms(PAGE_DURATION_MS);
         int current_page = 0;
+        int rendered_page = -1; // page currently on the panel (-1: this card side not drawn yet)
     
         while (true) {
-            Paint_Clear(BLACK);
-            int start_index = current_page * page_size;
-            for (int i = 0; i < MAX_LINES; i++) {
-                int line_start = start_index + i * MAX_CHARS_PER_LINE;
-                if (line_start >= text_len) break;
-    
-                char line[MAX_CHARS_PER_LINE + 1] = {0};
-                strncpy(line, text + line_start, MAX_CHARS_PER_LINE);
-                line[MAX_CHARS_PER_LINE] = '\0';
-    
-                Paint_DrawString_EN(2, i * 12 + 4, line, &Font8, WHITE, BLACK);
+            // Only redraw when the page changes; keys are still polled every pass
+            if (current_page != rendered_page) {
+                draw_flashcard_page(text, current_page);
+                rendered_page = current_page;
+                frame_stats.rendered++;
+            } else {
+                frame_stats.skipped++;
             }
-            OLED_1in3_C_Display(BlackImage);
     
-            // Wait for page duration or button interrupt
-            if (DEV_Digital_Read(key1) == 0) {          // flip
-                sleep_ms(100);                          // debounce
-                while (DEV_Digital_Read(key1) == 0);    // wait for release
-                return FLASH_FLIP;
-            }
-            if (DEV_Digital_Read(key0) == 0) {          // skip
-                sleep_ms(100);
-                while (DEV_Digital_Read(key0) == 0);
-                return FLASH_SKIP;
+            // Key events, queued by the GPIO interrupt
+            input_event_t event;
+            while (input_next(&event)) {
+                if (event.key == INPUT_KEY1 && event.type == INPUT_PRESS) {
+                    return FLASH_FLIP;                  // flip on press
+                }
+                if (event.key == INPUT_KEY0 && event.type == INPUT_LONG_PRESS) {
+                    key0_held = true;
+                    return FLASH_FORGOT;
+                }
+                if (event.key == INPUT_KEY0 && event.type == INPUT_RELEASE) {
+                    if (!key0_held) return FLASH_SKIP;  // skip on a click's release
+                    key0_held = false;
+                }
             }
             if (absolute_time_diff_us(get_absolute_time(), card_deadline) < 0) {
                 return FLASH_TIMEOUT;
             }
+            if (poll_refresh()) {
+                return FLASH_NEW_DECK;                  // `text` was in the old deck
+            }
             if (absolute_time_diff_us(get_absolute_time(), next_page_time) < 0) {
                 current_page = (current_page + 1) % num_pages;
                 next_page_time = make_timeout_time_ms(PAGE_DURATION_MS);                                // show next page
             }
             else{
-            sleep_ms(50);
+            // Sleep until the next pass, waking at once for a key event
+            absolute_time_t wake = make_timeout_time_ms(50);
+            while (!input_pending() && !best_effort_wfe_or_timeout(wake));
             }
         }
     }
 
-   
-    void mainLoop(char *response_data) {
+
+    void mainLoop(int current_card) {
         
 
         printf("Main loop started...\n");
-        printf("RESPONSE BUFFER:\n%s\n", response_buffer);
-        
-        // Parse the CSV data from the response buffer into flashcards
-        char *csv_start = strstr(response_buffer, "\r\n\r\n"); //Find the first blank line in the response (after HTTP header)
-        if (csv_start) {
-            csv_start += 4; // Move past line break unicode ("\r\n\r\n") to the actual CSV data
-            parse_csv(csv_start);
-        } else {
-            printf("Failed to find CSV body.\n");
-        }  
-        printf("Parsing finished\n");
         
-       
+        uint32_t flashcard_count = deck_count();
+        if (current_card < 0 || (uint32_t)current_card >= flashcard_count) {
         
-        show_text_on_oled("Anki Flashcard   Pico Display");
-        DEV_Delay_ms(5000);
-        char message[64];
-        sprintf(message, "%d flashcards      loaded", flashcard_count);
-        show_text_on_oled(message);
-        DEV_Delay_ms(5000);
+            show_text_on_oled("Anki Flashcard   Pico Display");
+            DEV_Delay_ms(5000);
+            char message[64];
+            sprintf(message, "%lu flashcards      loaded", (unsigned long)flashcard_count);
+            show_text_on_oled(message);
+            DEV_Delay_ms(5000);
+
+            current_card = next_card();
+        }
 
 
     
-        //Begin randomly displaying flashcards    
+        //Begin displaying flashcards in review order
         
-        srand(to_us_since_boot(get_absolute_time())); // seed for rand()
-
-        int current_card = rand() % flashcard_count;
         bool show_front = true;
+        int flips = 0;                              // flips of the current card
         absolute_time_t next_flashcard_time = make_timeout_time_ms(DISPLAY_INTERVAL_MS);
 
-        int key0 = 15; 
-        int key1 = 17;
-        DEV_GPIO_Mode(key0, 0);
-        DEV_GPIO_Mode(key1, 0);
+        input_init();
     
 
         while (true) {
+            uint32_t current_hash = deck_hash(current_card);
             FlashAction act = show_flashcard(
-                show_front ? flashcards[current_card].front
-                           : flashcards[current_card].back,
+                show_front ? deck_front(current_card)
+                           : deck_back(current_card),
                            next_flashcard_time);
+            printf("Frames rendered: %lu, skipped: %lu\n",
+                   (unsigned long)frame_stats.rendered, (unsigned long)frame_stats.skipped);
         
             switch (act) {
                 case FLASH_FLIP:
                     show_front = !show_front;               // flip same card
+                    flips++;
                     next_flashcard_time = make_timeout_time_ms(DISPLAY_INTERVAL_MS);
                     break;
         
                 case FLASH_SKIP:
+                case FLASH_FORGOT:
                 case FLASH_TIMEOUT: //timeout also performs skip
-                    current_card = rand() % flashcard_count;// new random card
+                    grade_card(current_card, act, flips);
+                    current_card = next_card();             // next card in review order
                     show_front = true;
+                    flips = 0;
                     next_flashcard_time = make_timeout_time_ms(DISPLAY_INTERVAL_MS);
                     break;
         
+                case FLASH_NEW_DECK: {
+                    // Stay on the same card (and side) if the new deck still has it
+                    uint32_t index;
+                    flashcard_count = deck_count();
+                    load_schedule();
+                    if (deck_find(current_hash, &index)) {
+                        current_card = index;
+                    } else {
+                        current_card = next_card();
+                        show_front = true;
+                        flips = 0;
+                        next_flashcard_time = make_timeout_time_ms(DISPLAY_INTERVAL_MS);
+                    }
+                    break;
+                }
+
                 case FLASH_NONE:
                 default:
                     /* page-scroll timeout fell through – nothing to do here */
@@ -330,18 +432,42 @@
         printf("OLED Screen Initialised \r\n");
         OLED_1in3_C_Clear();
         printf("OLED Screen Cleared\r\n");
-        DEV_Delay_ms(2000);
-        show_text_on_oled("Connecting to   WiFi...");
-
-        if(!fetch_csv()){
-            printf("Fetch failed. Restarting\n");
-            sleep_ms(100);
-            watchdog_reboot(0, 0, 0);  // Reboots immediately
-            while (true) tight_loop_contents();  // Wait for reboot
+
+        srand(to_us_since_boot(get_absolute_time())); // seed for rand()
+
+        // Review state saved in flash, restored when the schedule is loaded
+        review_journal_init();
+
+        // Show a card from the deck saved in flash straight away; the refresh
+        // from the network then happens behind the display loop
+        int current_card = -1;
+        if (deck_store_load()) {
+            printf("Loaded %lu cards from flash\n", (unsigned long)deck_count());
+            load_schedule();
+            current_card = next_card();
+            draw_flashcard_page(deck_front(current_card), 0);
+        } else {
+            DEV_Delay_ms(2000);
+            show_text_on_oled("Connecting to   WiFi...");
+        }
+
+        // Without a saved deck there is nothing to show, so wait for the
+        // download; otherwise it runs in the background from the first pass
+        // of the display loop, then every REFRESH_INTERVAL_MS
+        if (deck_count() == 0) {
+            if (!refresh_deck() || deck_count() == 0) {
+                printf("Fetch failed. Restarting\n");
+                sleep_ms(100);
+                watchdog_reboot(0, 0, 0);  // Reboots immediately
+                while (true) tight_loop_contents();  // Wait for reboot
+            }
+            load_schedule();
+            schedule_refresh();
+        } else {
+            next_refresh_time = get_absolute_time();
         }
         
-        
-        mainLoop(response_buffer); // Call the main loop with the response data
+        mainLoop(current_card);
 
         return 0;
     }
@@ -6,6 +6,11 @@
  *  N.b. Not all options are strictly required; this is just an example       *
  *  configuration.                                                            *
  *                                                                            *
+ *  Defining PICOHTTPS_MBEDTLS_LEAN (CMake: -DPICOHTTPS_MBEDTLS_PROFILE=lean)  *
+ *  selects a trimmed profile instead, with only what is needed to talk to    *
+ *  PICOHTTPS_HOSTNAME: TLS 1.2 ECDHE-RSA/ECDHE-ECDSA with AES-GCM over P-256 *
+ *  or X25519. Smaller image, less RAM and a shorter ClientHello.             *
+ *                                                                            *
  *  https://github.com/Mbed-TLS/mbedtls/blob/v2.28.2/include/mbedtls/config.h *
  *                                                                            *
  ******************************************************************************/
@@ -32,6 +37,7 @@
 #define MBEDTLS_ENTROPY_HARDWARE_ALT                // Custom entropy collector (pico-sdk:pico_mbedtls.c)
 
 // Symmetric ciphers
+#if !PICOHTTPS_MBEDTLS_LEAN
 #define MBEDTLS_CIPHER_MODE_CBC                     // Cipher block chaining
 #define MBEDTLS_CIPHER_MODE_CFB                     // Cipher feedback mode
 #define MBEDTLS_CIPHER_MODE_CTR                     // Counter block cipher mode
@@ -41,12 +47,17 @@
 #define MBEDTLS_CIPHER_PADDING_ONE_AND_ZEROS
 #define MBEDTLS_CIPHER_PADDING_ZEROS_AND_LEN
 #define MBEDTLS_CIPHER_PADDING_ZEROS
+#endif //!PICOHTTPS_MBEDTLS_LEAN
 
 // Weak cipher suite removal
 #define MBEDTLS_REMOVE_ARC4_CIPHERSUITES            // ARC4
 #define MBEDTLS_REMOVE_3DES_CIPHERSUITES            // 3DES
 
 // Elliptic curves
+#if PICOHTTPS_MBEDTLS_LEAN
+#define MBEDTLS_ECP_DP_SECP256R1_ENABLED
+#define MBEDTLS_ECP_DP_CURVE25519_ENABLED
+#else
 #define MBEDTLS_ECP_DP_SECP192R1_ENABLED
 #define MBEDTLS_ECP_DP_SECP224R1_ENABLED
 #define MBEDTLS_ECP_DP_SECP256R1_ENABLED
@@ -60,30 +71,49 @@
 #define MBEDTLS_ECP_DP_BP512R1_ENABLED
 #define MBEDTLS_ECP_DP_CURVE25519_ENABLED
 #define MBEDTLS_ECP_DP_CURVE448_ENABLED
+#endif //PICOHTTPS_MBEDTLS_LEAN
 #define MBEDTLS_ECP_NIST_OPTIM                      // NIST optimizations
+#if !PICOHTTPS_MBEDTLS_LEAN
 #define MBEDTLS_ECDSA_DETERMINISTIC                 // Deterministic ECDSA (more secure)
+#endif //!PICOHTTPS_MBEDTLS_LEAN
 
 // Key exchange
+#if !PICOHTTPS_MBEDTLS_LEAN
 #define MBEDTLS_KEY_EXCHANGE_RSA_ENABLED
+#endif //!PICOHTTPS_MBEDTLS_LEAN
 #define MBEDTLS_KEY_EXCHANGE_ECDHE_RSA_ENABLED
 #define MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED
+#if !PICOHTTPS_MBEDTLS_LEAN
 #define MBEDTLS_KEY_EXCHANGE_ECDH_ECDSA_ENABLED
 #define MBEDTLS_KEY_EXCHANGE_ECDH_RSA_ENABLED
+#endif //!PICOHTTPS_MBEDTLS_LEAN
 
 // PKCS
 #define MBEDTLS_PKCS1_V15                           // PKCS#1 v1.5 encoding
+#if !PICOHTTPS_MBEDTLS_LEAN
 #define MBEDTLS_PKCS1_V21                           // PKCS#1 v2.1 encoding
+#endif //!PICOHTTPS_MBEDTLS_LEAN
 
 // TLS records
 #define MBEDTLS_SSL_ALL_ALERT_MESSAGES              // Send alert records
 #define MBEDTLS_SSL_RECORD_CHECKING                 // Validate records
 
 // TLS extensions
+//
+//  Encrypt-then-MAC and truncated HMAC only apply to CBC suites.
+//
+#if !PICOHTTPS_MBEDTLS_LEAN
 #define MBEDTLS_SSL_ENCRYPT_THEN_MAC                // TLS extension (RFC 7366)
+#endif //!PICOHTTPS_MBEDTLS_LEAN
 #define MBEDTLS_SSL_EXTENDED_MASTER_SECRET          // TLS extension (RFC 7627)
+#if !PICOHTTPS_MBEDTLS_LEAN
 #define MBEDTLS_SSL_MAX_FRAGMENT_LENGTH             // TLS extension (RFC 6066)
+#endif //!PICOHTTPS_MBEDTLS_LEAN
 #define MBEDTLS_SSL_SERVER_NAME_INDICATION          // TLS extension (RFC 6066)
+#define MBEDTLS_SSL_SESSION_TICKETS                 // TLS extension (RFC 5077)
+#if !PICOHTTPS_MBEDTLS_LEAN
 #define MBEDTLS_SSL_TRUNCATED_HMAC                  // TLS extension (RFC 6066)
+#endif //!PICOHTTPS_MBEDTLS_LEAN
 
 // Protocols
 #define MBEDTLS_SSL_PROTO_TLS1_2                    // Enable TLS version 1.2
@@ -107,9 +137,15 @@
 #define MBEDTLS_PK_PARSE_C                          // PK
 
 // Hashing
+//
+//  SHA 512 also provides SHA 384, which certificate chains are commonly
+//  signed with.
+//
 #define MBEDTLS_MD_C                                // MD generic code
+#if !PICOHTTPS_MBEDTLS_LEAN
 #define MBEDTLS_MD5_C                               // MD5
 #define MBEDTLS_POLY1305_C                          // Poly1305 MAC
+#endif //!PICOHTTPS_MBEDTLS_LEAN
 #define MBEDTLS_SHA256_C                            // SHA 256
 #define MBEDTLS_SHA512_C                            // SHA 512
 
@@ -123,8 +159,10 @@
 
 // Public Key
 #define MBEDTLS_PK_C                                // Public key generic code
+#if !PICOHTTPS_MBEDTLS_LEAN
 #define MBEDTLS_PKCS5_C                             // PKCS#5
 #define MBEDTLS_PKCS12_C                            // PKCS#12
+#endif //!PICOHTTPS_MBEDTLS_LEAN
 
 // SSL/TLS
 #define MBEDTLS_SSL_TLS_C                           // TLS generic code
@@ -138,7 +176,9 @@
 #define MBEDTLS_ENTROPY_C                           // for ALTCP TLS
 #define MBEDTLS_BIGNUM_C                            // for define MBEDTLS_ECP_C, MBEDTLS_RSA_C, MBEDTLS_X509_USE_C
 #define MBEDTLS_BASE64_C                            // for MBEDTLS_PEM_PARSE_C
+#if !PICOHTTPS_MBEDTLS_LEAN
 #define MBEDTLS_HMAC_DRBG_C                         // for MBEDTLS_ECDSA_DETERMINISTIC
+#endif //!PICOHTTPS_MBEDTLS_LEAN
 #define MBEDTLS_CTR_DRBG_C                          // for MBEDTLS_AES_C
 #define MBEDTLS_OID_C                               // for MBEDTLS_RSA_C
 #define MBEDTLS_ASN1_WRITE_C                        // for MBEDTLS_ECDSA_C
@@ -154,3 +194,24 @@
 
 
 /* Module config *************************************************************/
+
+// Cipher suites offered, in order of preference
+//
+//  Unset, every suite the enabled features allow is offered.
+//
+#if PICOHTTPS_MBEDTLS_LEAN
+#define MBEDTLS_SSL_CIPHERSUITES                        \
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,    \
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,      \
+    MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,    \
+    MBEDTLS_TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384
+#endif //PICOHTTPS_MBEDTLS_LEAN
+
+// Outgoing record buffer size
+//
+//  Only the handshake and a short GET request are ever sent. The incoming
+//  buffer stays at the full 16 KB, as the server decides its record size.
+//
+#if PICOHTTPS_MBEDTLS_LEAN
+#define MBEDTLS_SSL_OUT_CONTENT_LEN                 2048            // bytes
+#endif //PICOHTTPS_MBEDTLS_LEAN
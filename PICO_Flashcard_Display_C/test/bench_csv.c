@@ -0,0 +1,130 @@
+/* CSV parser benchmark *******************************************************
+ *                                                                            *
+ *  Parses synthetic decks of 1k, 10k and 100k cards with main.c's original   *
+ *  strndup() parser (csv_ref.c) and with deck_csv fed in TCP-segment sized   *
+ *  pieces, checks deck_csv's cards against the generator's, and reports      *
+ *  heap allocations, heap bytes and time for both. The heap is counted by    *
+ *  wrapping malloc() and friends at link time.                               *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "deck_csv.h"
+
+#include "csv_ref.h"
+#include "deck_gen.h"
+#include "host.h"
+#include "test.h"
+
+
+#define SEGMENT             1460    // Typical TCP payload
+
+
+/* Heap accounting ************************************************************/
+
+static size_t allocations;
+static size_t allocated;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+char* __real_strndup(const char* str, size_t n);
+char* __real_strdup(const char* str);
+
+void* __wrap_malloc(size_t size){
+    allocations++;
+    allocated += size;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size){
+    allocations++;
+    allocated += count * size;
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size){
+    allocations++;
+    allocated += size;
+    return __real_realloc(ptr, size);
+}
+
+char* __wrap_strndup(const char* str, size_t n){
+    allocations++;
+    allocated += strnlen(str, n) + 1;
+    return __real_strndup(str, n);
+}
+
+char* __wrap_strdup(const char* str){
+    allocations++;
+    allocated += strlen(str) + 1;
+    return __real_strdup(str);
+}
+
+
+/* Benchmark ******************************************************************/
+
+typedef struct{
+    const deck_gen_t* deck;
+    uint32_t next;
+    uint32_t mismatches;
+} expect_t;
+
+static void on_card(const char* front, const char* back, void* arg){
+    expect_t* expect = arg;
+    uint32_t i = expect->next++;
+    if(i >= expect->deck->cards
+       || strcmp(front, expect->deck->front[i]) != 0
+       || strcmp(back, expect->deck->back[i]) != 0){
+        expect->mismatches++;
+    }
+}
+
+static void run(uint32_t cards){
+    deck_gen_t deck;
+    deck_gen(&deck, cards, cards);
+    ref_Flashcard* table = malloc(cards * sizeof(ref_Flashcard));
+
+    // Original: the whole response in one buffer, two copies per card
+    allocations = allocated = 0;
+    uint64_t start = host_now_ns();
+    int parsed = ref_parse_csv(deck.csv, table, cards);
+    double ref_ms = (host_now_ns() - start) / 1e6;
+    size_t ref_allocations = allocations, ref_allocated = allocated;
+    ref_free_cards(table, parsed);
+    CHECK(parsed == (int)cards);
+
+    // Streaming: fixed parser state, fields handed straight on
+    static deck_csv_parser_t parser;
+    expect_t expect = {&deck, 0, 0};
+    allocations = allocated = 0;
+    start = host_now_ns();
+    deck_csv_init(&parser, on_card, &expect);
+    for(size_t offset = 0; offset < deck.len; offset += SEGMENT){
+        size_t len = deck.len - offset < SEGMENT ? deck.len - offset : SEGMENT;
+        deck_csv_feed(&parser, deck.csv + offset, len);
+    }
+    uint32_t reported = deck_csv_finish(&parser);
+    double csv_ms = (host_now_ns() - start) / 1e6;
+    CHECK(reported == cards);
+    CHECK(expect.next == cards);
+    CHECK(expect.mismatches == 0);
+    CHECK(parser.truncated == 0);
+
+    printf("%6u cards %8zu bytes  strndup: %6zu allocs %8zu heap bytes + %zu buffer %7.2f ms"
+           "  deck_csv: %zu allocs %zu heap bytes + %zu state %6.2f ms\n",
+           cards, deck.len, ref_allocations, ref_allocated, deck.len + 1, ref_ms,
+           allocations, allocated, sizeof(parser), csv_ms);
+
+    free(table);
+    deck_gen_free(&deck);
+}
+
+int main(void){
+    run(1000);
+    run(10000);
+    run(100000);
+    return test_result("bench_csv");
+}
@@ -0,0 +1,88 @@
+/* Fill benchmark *************************************************************
+ *                                                                            *
+ *  Full-screen fills on the display's 128x64 image, through the original     *
+ *  per-pixel / per-byte code (paint_ref.c) and through GUI_Paint's span      *
+ *  fills: Paint_Clear(), Paint_ClearWindows() and a filled rectangle, at     *
+ *  Scale 2 and 4. Checks the images match, and reports us per fill. Host     *
+ *  times; the ratio is what carries over.                                    *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "GUI_Paint.h"
+#include "OLED_1in3_c.h"
+
+#include "host.h"
+#include "paint_ref.h"
+#include "test.h"
+
+
+#define IMAGE_BYTES         (2 * OLED_1in3_C_ROW_BYTES * OLED_1in3_C_HEIGHT)   // Room for Scale 4
+#define REPEATS             2000
+
+
+static UBYTE expected[IMAGE_BYTES];
+static UBYTE actual[IMAGE_BYTES];
+
+typedef void (*fill_fn)(UWORD Color);
+
+
+static void ref_clear(UWORD c){ ref_Clear(c); }
+static void new_clear(UWORD c){ Paint_Clear(c); }
+static void ref_windows(UWORD c){ ref_ClearWindows(0, 0, Paint.Width, Paint.Height, c); }
+static void new_windows(UWORD c){ Paint_ClearWindows(0, 0, Paint.Width, Paint.Height, c); }
+static void ref_rect(UWORD c){ ref_DrawRectangle(1, 1, Paint.Width, Paint.Height, c, DOT_PIXEL_1X1, DRAW_FILL_FULL); }
+static void new_rect(UWORD c){ Paint_DrawRectangle(1, 1, Paint.Width, Paint.Height, c, DOT_PIXEL_1X1, DRAW_FILL_FULL); }
+
+static const struct{
+    const char* name;
+    fill_fn ref, paint;
+} fills[] = {
+    {"Paint_Clear", ref_clear, new_clear},
+    {"Paint_ClearWindows", ref_windows, new_windows},
+    {"Paint_DrawRectangle", ref_rect, new_rect}
+};
+
+
+// Alternates two colours the scale can store, so no fill is a no-op
+static UWORD colour(UBYTE scale, int i){
+    if(scale == 2) return i & 1 ? WHITE : BLACK;
+    return i & 3;
+}
+
+static void check(UBYTE scale, fill_fn ref, fill_fn paint){
+    for(int i = 0; i < 4; i++){
+        memset(expected, 0x5a, IMAGE_BYTES);
+        memset(actual, 0x5a, IMAGE_BYTES);
+        Paint_SelectImage(expected);
+        ref(colour(scale, i));
+        Paint_SelectImage(actual);
+        paint(colour(scale, i));
+        CHECK(memcmp(expected, actual, IMAGE_BYTES) == 0);
+    }
+}
+
+static double time_fill(UBYTE scale, fill_fn fill){
+    uint64_t start = host_now_ns();
+    for(int r = 0; r < REPEATS; r++) fill(colour(scale, r));
+    return (double)(host_now_ns() - start) / REPEATS / 1000;
+}
+
+int main(void){
+    static const UBYTE scales[] = {2, 4};
+
+    for(unsigned s = 0; s < 2; s++){
+        Paint_NewImage(actual, OLED_1in3_C_WIDTH, OLED_1in3_C_HEIGHT, ROTATE_0, WHITE);
+        Paint_SetScale(scales[s]);
+        for(unsigned f = 0; f < sizeof(fills) / sizeof(fills[0]); f++){
+            check(scales[s], fills[f].ref, fills[f].paint);
+            Paint_SelectImage(actual);
+            double before = time_fill(scales[s], fills[f].ref);
+            double after = time_fill(scales[s], fills[f].paint);
+            printf("Scale %u  %-20s  per-pixel %8.2f us  span %6.2f us  (%.1fx)\n",
+                   scales[s], fills[f].name, before, after, before / after);
+        }
+    }
+    return test_result("bench_fill");
+}
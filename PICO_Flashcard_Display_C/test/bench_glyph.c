@@ -0,0 +1,104 @@
+/* Glyph benchmark ************************************************************
+ *                                                                            *
+ *  Renders every printable character of each font at every bit offset,      *
+ *  through the original per-pixel path (paint_ref.c) and through             *
+ *  Paint_DrawChar(), checks the images match bit for bit, and reports ns     *
+ *  per glyph for both on the display's configuration (ROTATE_0,              *
+ *  MIRROR_NONE, Scale 2). Host times; the ratio is what carries over.        *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "GUI_Paint.h"
+#include "OLED_1in3_c.h"
+
+#include "host.h"
+#include "paint_ref.h"
+#include "test.h"
+
+
+#define IMAGE_BYTES         (OLED_1in3_C_ROW_BYTES * OLED_1in3_C_HEIGHT)
+#define REPEATS             200
+
+
+static UBYTE expected[IMAGE_BYTES];
+static UBYTE actual[IMAGE_BYTES];
+
+static struct{
+    const char* name;
+    sFONT* font;
+} fonts[] = {
+    {"Font8", &Font8},
+    {"Font12", &Font12},
+    {"Font16", &Font16},
+    {"Font20", &Font20},
+    {"Font24", &Font24}
+};
+
+
+static void scribble(UBYTE* image){
+    uint32_t seed = 7;
+    for(int i = 0; i < IMAGE_BYTES; i++){
+        seed = seed * 1103515245 + 12345;
+        image[i] = seed >> 16;
+    }
+}
+
+// Every character at every bit offset, on a scribbled background
+static void check_font(sFONT* font){
+    for(int shift = 0; shift < 8; shift++){
+        for(UWORD fg = 0; fg < 2; fg++){
+            UWORD foreground = fg ? WHITE : BLACK;
+            UWORD background = fg ? BLACK : WHITE;
+            scribble(expected);
+            scribble(actual);
+            UWORD x = shift, y = 0;
+            for(char c = ' '; c <= '~'; c++){
+                Paint_SelectImage(expected);
+                ref_DrawChar(x, y, c, font, foreground, background);
+                Paint_SelectImage(actual);
+                Paint_DrawChar(x, y, c, font, foreground, background);
+                x += 8 * ((font->Width + 7) / 8);
+                if(x + font->Width > OLED_1in3_C_WIDTH){
+                    x = shift;
+                    y = (y + font->Height) % (OLED_1in3_C_HEIGHT - font->Height);
+                }
+            }
+            CHECK(memcmp(expected, actual, IMAGE_BYTES) == 0);
+        }
+    }
+}
+
+static double time_font(sFONT* font, void (*draw)(UWORD, UWORD, const char, sFONT*, UWORD, UWORD)){
+    uint32_t glyphs = 0;
+    uint64_t start = host_now_ns();
+    for(int r = 0; r < REPEATS; r++){
+        UWORD x = r % 8, y = 0;
+        for(char c = ' '; c <= '~'; c++){
+            draw(x, y, c, font, WHITE, BLACK);
+            glyphs++;
+            x += font->Width + 1;
+            if(x + font->Width > OLED_1in3_C_WIDTH){
+                x = r % 8;
+                y = (y + font->Height) % (OLED_1in3_C_HEIGHT - font->Height);
+            }
+        }
+    }
+    return (double)(host_now_ns() - start) / glyphs;
+}
+
+int main(void){
+    Paint_NewImage(actual, OLED_1in3_C_WIDTH, OLED_1in3_C_HEIGHT, ROTATE_0, WHITE);
+
+    for(unsigned f = 0; f < sizeof(fonts) / sizeof(fonts[0]); f++){
+        check_font(fonts[f].font);
+        Paint_SelectImage(actual);
+        double per_pixel = time_font(fonts[f].font, ref_DrawChar);
+        double blit = time_font(fonts[f].font, Paint_DrawChar);
+        printf("%-7s %2ux%-2u  per-pixel %7.1f ns/glyph  blitter %6.1f ns/glyph  (%.1fx)\n",
+               fonts[f].name, fonts[f].font->Width, fonts[f].font->Height,
+               per_pixel, blit, per_pixel / blit);
+    }
+    return test_result("bench_glyph");
+}
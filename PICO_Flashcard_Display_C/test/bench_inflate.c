@@ -0,0 +1,119 @@
+/* Inflate benchmark **********************************************************
+ *                                                                            *
+ *  Decompresses a gzip'd ~1 MB CSV deck and 1 MB of incompressible bytes     *
+ *  with http_inflate, fed in 1460-byte pieces as TCP segments arrive, and    *
+ *  with the system zlib's inflate() for comparison, checks both outputs, and *
+ *  reports MB/s of inflated output. Host times; the ratio is what carries    *
+ *  over.                                                                     *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "http_inflate.h"
+
+#include "deck_gen.h"
+#include "host.h"
+#include "test.h"
+
+
+#define SEGMENT             1460
+#define REPEATS             10
+
+
+static uint8_t* plain;
+static size_t plain_len;
+static uint8_t* output;
+static size_t output_len;
+
+
+static void on_output(const char* data, size_t len, void* arg){
+    (void)arg;
+    memcpy(output + output_len, data, len);
+    output_len += len;
+}
+
+static double time_http_inflate(const uint8_t* stream, size_t len){
+    static http_inflate_t inflater;
+    uint64_t start = host_now_ns();
+    for(int r = 0; r < REPEATS; r++){
+        output_len = 0;
+        http_inflate_init(&inflater, HTTP_INFLATE_GZIP, on_output, NULL);
+        for(size_t offset = 0; offset < len; offset += SEGMENT){
+            http_inflate_feed(&inflater, stream + offset, len - offset < SEGMENT ? len - offset : SEGMENT);
+        }
+    }
+    uint64_t elapsed = host_now_ns() - start;
+    CHECK(inflater.complete && !inflater.error);
+    CHECK(output_len == plain_len && memcmp(output, plain, plain_len) == 0);
+    return (double)plain_len * REPEATS / 1e6 / (elapsed / 1e9);
+}
+
+static double time_zlib(const uint8_t* stream, size_t len){
+    uint64_t start = host_now_ns();
+    int ret = Z_OK;
+    z_stream z;
+    for(int r = 0; r < REPEATS; r++){
+        memset(&z, 0, sizeof(z));
+        inflateInit2(&z, 16 + 15);
+        z.next_out = output;
+        z.avail_out = plain_len;
+        for(size_t offset = 0; offset < len && ret != Z_STREAM_END; offset += SEGMENT){
+            z.next_in = (uint8_t*)stream + offset;
+            z.avail_in = len - offset < SEGMENT ? len - offset : SEGMENT;
+            ret = inflate(&z, Z_NO_FLUSH);
+        }
+        inflateEnd(&z);
+        if(r + 1 < REPEATS) ret = Z_OK;
+    }
+    uint64_t elapsed = host_now_ns() - start;
+    CHECK(ret == Z_STREAM_END);
+    CHECK(z.total_out == plain_len && memcmp(output, plain, plain_len) == 0);
+    return (double)plain_len * REPEATS / 1e6 / (elapsed / 1e9);
+}
+
+static void bench(const char* name){
+    z_stream z = {0};
+    deflateInit2(&z, 6, Z_DEFLATED, 16 + 15, 8, Z_DEFAULT_STRATEGY);
+    size_t size = deflateBound(&z, plain_len);
+    uint8_t* stream = malloc(size);
+    z.next_in = plain;
+    z.avail_in = plain_len;
+    z.next_out = stream;
+    z.avail_out = size;
+    CHECK(deflate(&z, Z_FINISH) == Z_STREAM_END);
+    size_t len = z.total_out;
+    deflateEnd(&z);
+
+    double ours = time_http_inflate(stream, len);
+    double theirs = time_zlib(stream, len);
+    printf("%-7s %7zu -> %7zu bytes  http_inflate %6.1f MB/s  zlib %6.1f MB/s  (%.2fx)\n",
+           name, len, plain_len, ours, theirs, theirs / ours);
+    free(stream);
+}
+
+int main(void){
+    deck_gen_t deck;
+    deck_gen(&deck, 12000, 16);
+    plain = (uint8_t*)deck.csv;
+    plain_len = deck.len;
+    output = malloc(plain_len);
+    bench("deck");
+    free(output);
+    deck_gen_free(&deck);
+
+    plain_len = 1 << 20;
+    plain = malloc(plain_len);
+    output = malloc(plain_len);
+    uint32_t seed = 16;
+    for(size_t i = 0; i < plain_len; i++){
+        seed = seed * 1103515245 + 12345;
+        plain[i] = seed >> 24;
+    }
+    bench("random");
+    free(output);
+    free(plain);
+    return test_result("bench_inflate");
+}
@@ -0,0 +1,104 @@
+/* OLED flush benchmark *******************************************************
+ *                                                                            *
+ *  Counts the SPI calls and pin writes of a full-frame flush, for the        *
+ *  original byte-at-a-time loop and for OLED_1in3_C_Display()'s column       *
+ *  bursts, and projects the frame time on the Pico from them. Both paths     *
+ *  must leave the same picture in the panel model.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "OLED_1in3_c.h"
+
+#include "host.h"
+#include "test.h"
+
+
+// Projection (RP2040 at 125 MHz, SPI at the 10 MHz DEV_Module_Init sets)
+#define SPI_BYTE_US         0.8     // 8 bits at 10 MHz
+#define SPI_CALL_US         1.0     // spi_write_blocking() entry, and the
+                                    // FIFO drain it waits for on return
+#define GPIO_WRITE_US       0.1     // DEV_Digital_Write() call
+
+#define FRAME_BYTES         (OLED_1in3_C_ROW_BYTES * OLED_1in3_C_HEIGHT)
+
+
+static UBYTE image[FRAME_BYTES];
+
+
+/* Original flush *************************************************************/
+
+static UBYTE reverse(UBYTE temp){
+    temp = ((temp & 0x55) << 1) | ((temp & 0xaa) >> 1);
+    temp = ((temp & 0x33) << 2) | ((temp & 0xcc) >> 2);
+    temp = ((temp & 0x0f) << 4) | ((temp & 0xf0) >> 4);
+    return temp;
+}
+
+static void write_reg(UBYTE reg){
+    OLED_DC_0;
+    OLED_CS_0;
+    DEV_SPI_WriteByte(reg);
+    OLED_CS_1;
+}
+
+static void write_data(UBYTE data){
+    OLED_DC_1;
+    OLED_CS_0;
+    DEV_SPI_WriteByte(data);
+    OLED_CS_1;
+}
+
+static void display_bytewise(const UBYTE* Image){
+    UWORD Width = OLED_1in3_C_ROW_BYTES;
+    write_reg(0xb0);
+    for(UWORD j = 0; j < OLED_1in3_C_HEIGHT; j++){
+        UWORD column = 63 - j;
+        write_reg(0x00 + (column & 0x0f));
+        write_reg(0x10 + (column >> 4));
+        for(UWORD i = 0; i < Width; i++) write_data(reverse(Image[i + j * Width]));
+    }
+}
+
+
+/* Benchmark ******************************************************************/
+
+static void report(const char* name){
+    host_dev_stats_t* s = &host_dev_stats;
+    double frame_us = s->spi_bytes * SPI_BYTE_US + s->spi_calls * SPI_CALL_US + s->gpio_writes * GPIO_WRITE_US;
+    printf("%-10s %6lu calls %6lu bytes %6.1f bytes/call %6lu pin writes  ~%5.0f us/frame\n",
+           name, (unsigned long)s->spi_calls, (unsigned long)s->spi_bytes,
+           (double)s->spi_bytes / s->spi_calls, (unsigned long)s->gpio_writes, frame_us);
+}
+
+int main(void){
+    uint32_t seed = 1;
+    for(int i = 0; i < FRAME_BYTES; i++){
+        seed = seed * 1103515245 + 12345;
+        image[i] = seed >> 16;
+    }
+
+    // The panel is put in vertical addressing mode first
+    host_dev_reset();
+    OLED_1in3_C_Init();
+
+    static uint8_t expected[HOST_PANEL_PAGES][HOST_PANEL_COLUMNS];
+    memset(&host_dev_stats, 0, sizeof(host_dev_stats));
+    display_bytewise(image);
+    memcpy(expected, host_panel, sizeof(expected));
+    report("bytewise");
+    CHECK(host_dev_stats.errors == 0);
+
+    memset(host_panel, 0, sizeof(host_panel));
+    memset(&host_dev_stats, 0, sizeof(host_dev_stats));
+    OLED_1in3_C_Display(image);
+    report("burst");
+    CHECK(host_dev_stats.errors == 0);
+    CHECK(memcmp(expected, host_panel, sizeof(expected)) == 0);
+    CHECK(host_dev_stats.spi_calls == 2 * OLED_1in3_C_HEIGHT);
+
+    printf("(projection: %.1f us/byte, %.1f us/SPI call, %.1f us/pin write)\n",
+           SPI_BYTE_US, SPI_CALL_US, GPIO_WRITE_US);
+    return test_result("bench_oled");
+}
@@ -0,0 +1,174 @@
+/* Weighted card sampler benchmark ********************************************
+ *                                                                            *
+ *  Checks that draws follow the weights (zero never drawn, extreme and       *
+ *  lopsided weights included, up to the largest table, and past 65536 cards  *
+ *  in the wide build), then reports build time per card and draw time at     *
+ *  1k, 10k and 100k cards, next to a linear scan of the running weight       *
+ *  total per draw.                                                           *
+ *                                                                            *
+ *  Built twice: with 16 bit card indices, as on the Pico, where 100k cards   *
+ *  is over the limit, and with 32 bit ones (bench_review_alias_wide).        *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "review_alias.h"
+
+#include "host.h"
+#include "test.h"
+
+
+#define DRAWS               10000000
+
+
+static uint32_t* weights;
+
+
+static uint32_t weight_of(uint32_t index, void* arg){
+    (void)arg;
+    return weights[index];
+}
+
+// Draw counts within `percent` of the weights' shares
+static bool follows(uint32_t count, uint32_t draws, uint32_t percent){
+    review_alias_t alias = {0};
+    if(!review_alias_build(&alias, count, weight_of, NULL, count)) return false;
+    uint32_t* drawn = calloc(count, sizeof(uint32_t));
+    for(uint32_t i = 0; i < draws; i++){
+        uint32_t card = review_alias_draw(&alias);
+        if(card < count) drawn[card]++;
+        else return false;
+    }
+    review_alias_free(&alias);
+
+    double total = 0;
+    for(uint32_t i = 0; i < count; i++) total += weights[i];
+    bool ok = true;
+    for(uint32_t i = 0; i < count; i++){
+        double expected = draws * (weights[i] / total);
+        if(weights[i] == 0) ok = ok && drawn[i] == 0;
+        else ok = ok && drawn[i] >= expected * (100 - percent) / 100 && drawn[i] <= expected * (100 + percent) / 100;
+    }
+    free(drawn);
+    return ok;
+}
+
+static void check_draws(void){
+    weights = malloc((1u << 17) * sizeof(uint32_t));
+
+    // Small weights, some zero
+    for(uint32_t i = 0; i < 10; i++) weights[i] = i % 4 ? i : 0;
+    CHECK(follows(10, DRAWS, 2));
+
+    // One card taking every draw, in the largest table (capped for time)
+    uint32_t largest = REVIEW_ALIAS_MAX_CARDS < 1u << 17 ? REVIEW_ALIAS_MAX_CARDS : 1u << 17;
+    memset(weights, 0, largest * sizeof(uint32_t));
+    weights[12345] = 1;
+    CHECK(follows(largest, 100000, 0));
+
+    // Weights near UINT32_MAX, 3 to 1
+    for(uint32_t i = 0; i < largest; i++) weights[i] = i % 2 ? UINT32_MAX : UINT32_MAX / 3;
+    review_alias_t alias = {0};
+    CHECK(review_alias_build(&alias, largest, weight_of, NULL, 1));
+    uint32_t heavy = 0;
+    for(uint32_t i = 0; i < DRAWS; i++) heavy += review_alias_draw(&alias) % 2;
+    CHECK(heavy > DRAWS * 0.745 && heavy < DRAWS * 0.755);
+    review_alias_free(&alias);
+
+    // A heavy card among many light ones
+    for(uint32_t i = 0; i < 1000; i++) weights[i] = 1;
+    weights[7] = 1000;
+    CHECK(follows(1000, DRAWS, 10));
+
+    // Weights 1 to 3 with the first cards 0, in the most cards checked: no
+    // entry keeps or takes a card of weight 0, and the weights get their
+    // shares of the draws
+    uint32_t many = REVIEW_ALIAS_MAX_CARDS < 400000 ? REVIEW_ALIAS_MAX_CARDS : 400000;
+    weights = realloc(weights, many * sizeof(uint32_t));
+    for(uint32_t i = 0; i < many; i++) weights[i] = i < 4 ? 0 : i % 3 + 1;
+    CHECK(review_alias_build(&alias, many, weight_of, NULL, 1));
+    uint32_t zero_kept = 0, zero_taken = 0;
+    for(uint32_t i = 0; i < many; i++){
+        if(weights[i] == 0 && alias.table[i].keep != 0) zero_kept++;
+        if(weights[alias.table[i].alias] == 0 && alias.table[i].keep != UINT16_MAX) zero_taken++;
+    }
+    CHECK(zero_kept == 0 && zero_taken == 0);
+    uint32_t drawn[4] = {0};
+    for(uint32_t i = 0; i < DRAWS; i++) drawn[weights[review_alias_draw(&alias)]]++;
+    CHECK(drawn[0] == 0);
+    for(uint32_t w = 1; w <= 3; w++) CHECK(drawn[w] > DRAWS * w / 6.0 * 0.99 && drawn[w] < DRAWS * w / 6.0 * 1.01);
+    review_alias_free(&alias);
+
+    // Limits; a failed build leaves the table as it was
+    CHECK(!review_alias_build(&alias, 0, weight_of, NULL, 1));
+    CHECK(!review_alias_build(&alias, REVIEW_ALIAS_MAX_CARDS + 1, weight_of, NULL, 1));
+    CHECK(review_alias_build(&alias, 10, weight_of, NULL, 1));
+    review_alias_entry_t* table = alias.table;
+    memset(weights, 0, 10 * sizeof(uint32_t));
+    CHECK(!review_alias_build(&alias, 10, weight_of, NULL, 1));      // All zero
+    CHECK(alias.table == table && alias.count == 10);
+    review_alias_free(&alias);
+
+    free(weights);
+}
+
+// Linear scan: walk the running total to a random point
+static uint32_t scan_draw(uint32_t count, uint64_t total, uint32_t* state){
+    *state = *state * 1103515245 + 12345;
+    uint64_t point = (uint64_t)*state * total >> 32;
+    for(uint32_t i = 0; i < count; i++){
+        if(point < weights[i]) return i;
+        point -= weights[i];
+    }
+    return count - 1;
+}
+
+static void bench(uint32_t count){
+    if(count > REVIEW_ALIAS_MAX_CARDS){
+        printf("%6u cards  over REVIEW_ALIAS_MAX_CARDS (%u)\n", count, REVIEW_ALIAS_MAX_CARDS);
+        return;
+    }
+
+    // Weighted as the scheduler does: (256 - ease)^2
+    weights = malloc(count * sizeof(uint32_t));
+    uint32_t seed = count;
+    uint64_t total = 0;
+    for(uint32_t i = 0; i < count; i++){
+        seed = seed * 1103515245 + 12345;
+        uint32_t w = 256 - (seed >> 24);
+        total += weights[i] = w * w;
+    }
+
+    review_alias_t alias = {0};
+    uint32_t builds = 20000000 / count + 1;
+    uint64_t start = host_now_ns();
+    for(uint32_t b = 0; b < builds; b++) CHECK(review_alias_build(&alias, count, weight_of, NULL, b));
+    double build = (double)(host_now_ns() - start) / builds;
+
+    volatile uint32_t sink = 0;
+    start = host_now_ns();
+    for(uint32_t i = 0; i < DRAWS; i++) sink += review_alias_draw(&alias);
+    double draw = (double)(host_now_ns() - start) / DRAWS;
+
+    uint32_t scans = 200000000 / count + 1, state = 1;
+    start = host_now_ns();
+    for(uint32_t i = 0; i < scans; i++) sink += scan_draw(count, total, &state);
+    double scan = (double)(host_now_ns() - start) / scans;
+    (void)sink;
+
+    printf("%6u cards  build %8.1f us (%4.1f ns/card)  draw %5.1f ns  linear scan %8.0f ns/draw  table %u bytes\n",
+           count, build / 1000, build / count, draw, scan,
+           count * (unsigned)sizeof(review_alias_entry_t));
+    review_alias_free(&alias);
+    free(weights);
+}
+
+int main(void){
+    check_draws();
+    bench(1000);
+    bench(10000);
+    bench(100000);
+    return test_result(REVIEW_ALIAS_INDEX_BITS == 16 ? "bench_review_alias" : "bench_review_alias_wide");
+}
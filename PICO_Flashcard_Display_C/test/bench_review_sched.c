@@ -0,0 +1,265 @@
+/* Review scheduler simulator *************************************************
+ *                                                                            *
+ *  Replays years of daily review sessions against review_sched with a        *
+ *  synthetic learner: each card has a hidden difficulty and a memory that    *
+ *  fades exponentially, and grades follow from how likely it still is to be  *
+ *  recalled. Some cards are shown with nobody looking (REVIEW_GRADE_NONE)    *
+ *  and some not graded at all.                                               *
+ *                                                                            *
+ *  A 200 card run checks every pick against a linear scan of the card        *
+ *  state: the earliest due card if any is due, else an unseen card, else     *
+ *  any card but the last; each card introduced once; state kept by hash      *
+ *  over a deck reload. Then 1k, 10k and 65535 card decks are timed and the   *
+ *  cost per pick reported next to the linear scan's, with the learner's      *
+ *  recall rate compared to picking with rand() % n as main.c used to.        *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "review_sched.h"
+
+#include "host.h"
+#include "test.h"
+
+
+#define SESSIONS            2000    // One a day
+#define SESSION_CARDS       40
+#define CARD_SECONDS        20      // Between picks within a session
+#define DAY                 86400
+#define REPLACED            10      // Percent of cards changed by the reload
+
+
+// Hidden learner state per card
+typedef struct{
+    float difficulty;               // 0 easy to 1 hard
+    float stability;                // Days until recall drops to 90%
+    uint32_t last;                  // Clock (s) last shown, 0 if never
+} memory_t;
+
+typedef struct{
+    uint32_t picks;
+    uint32_t due;                   // Picks by kind
+    uint32_t fresh;
+    uint32_t ahead;
+    uint32_t reviews;               // Picks of cards seen before
+    uint32_t recalled;              // ...that were recalled
+    uint64_t ns;                    // Time in review_sched_next() + grade
+} stats_t;
+
+static memory_t* memory;
+static uint32_t seed;
+static uint32_t generation;         // Changes the hashes of replaced cards
+
+
+static uint32_t random_next(void){
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+static double uniform(void){
+    return (random_next() & 0xffffff) / (double)0x1000000;
+}
+
+// Distinct content hash per card; replaced cards get new ones on reload
+static uint32_t card_hash(uint32_t index){
+    uint32_t version = index % 100 < REPLACED ? generation : 0;
+    return (index * 2654435761u) ^ (version * 0x85ebca6bu) ^ 0x5bd1e995;
+}
+
+// The learner sees the card: grade it and update their memory of it
+static review_grade_t learn(uint32_t index, uint32_t now, stats_t* stats){
+    memory_t* m = &memory[index];
+    if(uniform() < 0.05) return REVIEW_GRADE_NONE;      // Nobody looking
+
+    double p = 0.9 - 0.6 * m->difficulty;               // First sight
+    if(m->last){
+        double days = (now - m->last) / (double)DAY;
+        p = exp(log(0.9) * days / m->stability);
+        stats->reviews++;
+    }
+    bool first = !m->last;
+    m->last = now;
+    if(uniform() >= p){
+        m->stability = fmaxf(0.5f, m->stability * 0.7f);
+        return REVIEW_GRADE_AGAIN;
+    }
+    if(!first) stats->recalled++;
+    m->stability = first ? 2 - m->difficulty : m->stability * (1.5f + 2.5f * (1 - m->difficulty));
+    return p > 0.97 ? REVIEW_GRADE_EASY : p > 0.85 ? REVIEW_GRADE_GOOD : REVIEW_GRADE_HARD;
+}
+
+static void reset_learner(uint32_t cards){
+    for(uint32_t i = 0; i < cards; i++){
+        memory[i] = (memory_t){.difficulty = uniform(), .stability = 0.1f};
+    }
+}
+
+// Linear scan reference: earliest due card, as main.c could have done it
+static uint32_t scan_earliest(const review_card_t* cards, uint32_t count){
+    uint32_t best = 0;
+    for(uint32_t i = 1; i < count; i++) if(cards[i].due < cards[best].due) best = i;
+    return best;
+}
+
+// Check a pick against the card state from before it
+static void check_pick(const review_card_t* before, uint32_t count, uint32_t hand,
+                       uint32_t last, uint32_t picked, uint32_t now, bool* introduced){
+    uint32_t earliest = REVIEW_SCHED_NEW;
+    bool unseen = false;
+    for(uint32_t i = 0; i < count; i++){
+        uint32_t due = before[i].due;
+        if(i == hand && due == REVIEW_SCHED_NEW) due = now;     // Put back as due
+        if(due == REVIEW_SCHED_NEW) unseen = true;
+        else if(due < earliest) earliest = due;
+    }
+    uint32_t due = picked == hand && before[picked].due == REVIEW_SCHED_NEW ? now : before[picked].due;
+
+    if(earliest <= now){
+        CHECK(due == earliest);
+    } else if(unseen){
+        CHECK(due == REVIEW_SCHED_NEW);
+        CHECK(!introduced[picked]);
+        introduced[picked] = true;
+    } else {
+        CHECK(picked != last || count == 1);
+    }
+}
+
+// Run the sessions; with `check`, verify every pick
+static void simulate(uint32_t count, bool check, stats_t* stats){
+    memset(stats, 0, sizeof(*stats));
+    generation = 0;
+    CHECK(review_sched_load(count, card_hash, 1));
+    reset_learner(count);
+
+    review_card_t* before = check ? malloc(count * sizeof(review_card_t)) : NULL;
+    bool* introduced = check ? calloc(count, sizeof(bool)) : NULL;
+    uint32_t hand = UINT32_MAX, last = UINT32_MAX;
+    uint32_t now = DAY;
+
+    for(uint32_t session = 0; session < SESSIONS; session++){
+
+        // Halfway, a new version of the deck with some cards changed
+        if(check && session == SESSIONS / 2){
+            uint32_t n;
+            const review_card_t* cards = review_sched_cards(&n);
+            memcpy(before, cards, count * sizeof(review_card_t));
+            generation++;
+            CHECK(review_sched_load(count, card_hash, 2));
+            cards = review_sched_cards(&n);
+            for(uint32_t i = 0; i < count; i++){
+                bool kept = false;
+                for(uint32_t j = 0; j < count && !kept; j++) kept = !memcmp(&cards[i], &before[j], sizeof(review_card_t));
+                if(i % 100 < REPLACED){
+                    CHECK(cards[i].due == REVIEW_SCHED_NEW);
+                    introduced[i] = false;
+                    memory[i] = (memory_t){.difficulty = uniform(), .stability = 0.1f};
+                } else {
+                    CHECK(kept);
+                }
+            }
+            last = UINT32_MAX;
+        }
+
+        for(uint32_t pick = 0; pick < SESSION_CARDS; pick++){
+            uint32_t n, index;
+            const review_card_t* cards = review_sched_cards(&n);
+            if(check) memcpy(before, cards, count * sizeof(review_card_t));
+
+            uint64_t start = host_now_ns();
+            CHECK(review_sched_next(now, &index));
+            uint64_t picked = host_now_ns();
+            stats->ns += picked - start;
+            CHECK(index < count);
+            if(check) check_pick(before, count, hand, last, index, now, introduced);
+
+            uint32_t due = cards[index].due;
+            stats->picks++;
+            if(due == REVIEW_SCHED_NEW) stats->fresh++;
+            else if(due <= now) stats->due++;
+            else stats->ahead++;
+
+            // One in fifty is left ungraded and put back by the next pick
+            hand = last = index;
+            if(random_next() % 50){
+                review_grade_t grade = learn(index, now, stats);
+                start = host_now_ns();
+                review_sched_grade(grade, now);
+                stats->ns += host_now_ns() - start;
+                hand = UINT32_MAX;
+            }
+            now += CARD_SECONDS;
+        }
+        now += DAY - SESSION_CARDS * CARD_SECONDS;
+    }
+    free(before);
+    free(introduced);
+}
+
+// The same learner, shown cards by rand() % n
+static double random_recall(uint32_t count){
+    stats_t stats = {0};
+    reset_learner(count);
+    uint32_t now = DAY;
+    for(uint32_t session = 0; session < SESSIONS; session++){
+        for(uint32_t pick = 0; pick < SESSION_CARDS; pick++){
+            learn(random_next() % count, now, &stats);
+            now += CARD_SECONDS;
+        }
+        now += DAY - SESSION_CARDS * CARD_SECONDS;
+    }
+    return stats.reviews ? 100.0 * stats.recalled / stats.reviews : 0;
+}
+
+// Time the linear scan over the final state
+static double time_scan(void){
+    uint32_t n;
+    const review_card_t* cards = review_sched_cards(&n);
+    volatile uint32_t sink = 0;
+    uint32_t repeats = 20000000 / n + 1;
+    uint64_t start = host_now_ns();
+    for(uint32_t r = 0; r < repeats; r++) sink += scan_earliest(cards, n);
+    (void)sink;
+    return (double)(host_now_ns() - start) / repeats;
+}
+
+// Cost of the two clock reads around each call
+static double timer_overhead(void){
+    uint64_t total = 0;
+    for(int i = 0; i < 100000; i++){
+        uint64_t start = host_now_ns();
+        total += host_now_ns() - start;
+    }
+    return total / 100000.0;
+}
+
+int main(void){
+    static const uint32_t sizes[] = {1000, 10000, 65535};
+    memory = malloc(65535 * sizeof(memory_t));
+    seed = 21;
+
+    stats_t stats;
+    simulate(200, true, &stats);
+    CHECK(stats.due > 0 && stats.fresh > 0 && stats.ahead > 0);
+
+    double overhead = timer_overhead();
+    for(unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++){
+        seed = 21;
+        simulate(sizes[s], false, &stats);
+        double per_pick = (double)stats.ns / stats.picks - 2 * overhead;
+        double scan = time_scan();
+        printf("%5u cards  %u picks (%2.0f%% due, %2.0f%% new, %2.0f%% ahead)  "
+               "%5.0f ns/pick  linear scan %7.0f ns  recall %4.1f%%  rand() recall %4.1f%%\n",
+               sizes[s], stats.picks,
+               100.0 * stats.due / stats.picks, 100.0 * stats.fresh / stats.picks,
+               100.0 * stats.ahead / stats.picks,
+               per_pick, scan,
+               stats.reviews ? 100.0 * stats.recalled / stats.reviews : 0,
+               random_recall(sizes[s]));
+    }
+    free(memory);
+    return test_result("bench_review_sched");
+}
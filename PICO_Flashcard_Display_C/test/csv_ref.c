@@ -0,0 +1,113 @@
+/* Reference CSV parser *******************************************************
+ *                                                                            *
+ *  Copied from main.c as it was before the streaming parser, with the card   *
+ *  table and its size passed in rather than global.                          *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "csv_ref.h"
+
+
+static void trim_whitespace(char *str) {
+    if (!str) return;
+
+    // Trim leading
+    while (*str == ' ' || *str == '\t' || *str == '\r' || *str == '\n') {
+        str++;
+    }
+
+    // Trim trailing
+    char *end = str + strlen(str) - 1;
+    while (end > str && (*end == ' ' || *end == '\t' || *end == '\r' || *end == '\n')) {
+        *end-- = '\0';
+    }
+}
+
+int ref_parse_csv(char *csv, ref_Flashcard *cards, int max_cards)
+{
+    int flashcard_count = 0;
+    char *p = csv;
+
+    while (*p && flashcard_count < max_cards) {
+
+        // ---- Field 0 (front) ----
+        char *front = NULL, *back = NULL;
+        size_t front_len = 0, back_len = 0;
+
+        if (*p == '"') {                         // ► quoted field
+            p++;                                 // skip opening "
+            char *start = p;
+            while (*p) {
+                if (*p == '"' && p[1] == '"') {  // ""  ->  "
+                    p += 2;
+                } else if (*p == '"') {          // closing "
+                    break;
+                } else {
+                    p++;
+                }
+            }
+            front_len = (size_t)(p - start);
+            front = strndup(start, front_len);
+            if (*p == '"') p++;                  // skip closing "
+        } else {                                // ► un-quoted field
+            char *start = p;
+            while (*p && *p != ',' && *p != '\r' && *p != '\n') p++;
+            front_len = (size_t)(p - start);
+            front = strndup(start, front_len);
+        }
+
+        // expect comma separator
+        if (*p == ',') p++; else break;
+
+        // ---- Field 1 (back) ----
+        if (*p == '"') {
+            p++;
+            char *start = p;
+            while (*p) {
+                if (*p == '"' && p[1] == '"') {      // escaped quote
+                    p += 2;
+                } else if (*p == '"') {              // closing quote
+                    break;
+                } else {
+                    p++;
+                }
+            }
+            back_len = (size_t)(p - start);
+            back = strndup(start, back_len);
+            if (*p == '"') p++;
+        } else {
+            char *start = p;
+            while (*p && *p != '\r' && *p != '\n') p++;
+            back_len = (size_t)(p - start);
+            back = strndup(start, back_len);
+        }
+
+        // consume end-of-record  (CR? LF?)
+        if (*p == '\r') p++;
+        if (*p == '\n') p++;
+
+        trim_whitespace(front);
+        trim_whitespace(back);
+
+        if (front[0] && back[0]) {
+            cards[flashcard_count].front = front;
+            cards[flashcard_count].back  = back;
+            flashcard_count++;
+        } else {        // bad record: release memory
+            free(front);  free(back);
+        }
+    }
+
+    return flashcard_count;
+}
+
+void ref_free_cards(ref_Flashcard *cards, int count)
+{
+    for (int i = 0; i < count; i++) {
+        free(cards[i].front);
+        free(cards[i].back);
+    }
+}
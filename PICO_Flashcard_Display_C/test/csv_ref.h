@@ -0,0 +1,23 @@
+/* Reference CSV parser *******************************************************
+ *                                                                            *
+ *  main.c's original parse_csv(): reads a whole NUL-terminated response and  *
+ *  strndup()s both fields of every card. Kept so the benchmark can compare   *
+ *  it with the streaming parser in lib/Deck.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef CSV_REF_H
+#define CSV_REF_H
+
+typedef struct {
+    char *front;
+    char *back;
+} ref_Flashcard;
+
+// Parse `csv` into `cards`, returns the number of cards
+int ref_parse_csv(char *csv, ref_Flashcard *cards, int max_cards);
+
+// Free the fields of `count` cards
+void ref_free_cards(ref_Flashcard *cards, int count);
+
+#endif //CSV_REF_H
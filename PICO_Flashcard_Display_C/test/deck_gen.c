@@ -0,0 +1,97 @@
+/* Synthetic decks ************************************************************/
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "deck_gen.h"
+
+
+// Longest generated field (unescaped); well inside DECK_CSV_MAX_RECORD
+#define FIELD_MAX           200
+
+static const char* const words[] = {
+    "the", "cat", "Kanji", "river", "to run", "quickly", "über", "naïve",
+    "photosynthesis", "mitochondria", "a", "of", "verb", "noun", "(plural)",
+    "1945", "3.14", "x^2", "<b>bold</b>", "it's", "Tokyo", "apple"
+};
+
+static uint32_t seed;
+
+static uint32_t random_next(void){
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+// Fill `field` with words, and some of the awkward characters
+static size_t make_field(char* field, size_t max_words){
+    size_t len = 0;
+    size_t count = 1 + random_next() % max_words;
+    for(size_t w = 0; w < count; w++){
+        const char* word = words[random_next() % (sizeof(words) / sizeof(words[0]))];
+        size_t n = strlen(word);
+        if(len + n + 3 > FIELD_MAX) break;
+        if(w){
+            switch(random_next() % 16){
+                case 0: field[len++] = ','; break;
+                case 1: field[len++] = '"'; break;
+                case 2: field[len++] = '\n'; break;
+                case 3: memcpy(field + len, "\r\n", 2); len += 2; break;
+                default: break;
+            }
+            field[len++] = ' ';
+        }
+        memcpy(field + len, word, n);
+        len += n;
+    }
+    field[len] = '\0';
+    return len;
+}
+
+// Append `field` as a CSV field, quoting it when it has to be
+static size_t write_field(char* out, const char* field, bool is_front){
+    bool quote = strpbrk(field, is_front ? "\",\r\n" : "\"\r\n") || random_next() % 8 == 0;
+    size_t len = 0;
+    if(quote) out[len++] = '"';
+    for(const char* c = field; *c; c++){
+        if(*c == '"') out[len++] = '"';
+        out[len++] = *c;
+    }
+    if(quote) out[len++] = '"';
+    return len;
+}
+
+// Generate a deck of `cards` cards
+void deck_gen(deck_gen_t* deck, uint32_t cards, uint32_t deck_seed){
+    seed = deck_seed;
+    deck->cards = cards;
+    deck->front = malloc(cards * sizeof(char*));
+    deck->back = malloc(cards * sizeof(char*));
+    deck->text = malloc((size_t)cards * 2 * (FIELD_MAX + 1));
+    deck->csv = malloc((size_t)cards * (4 * FIELD_MAX + 8) + 1);
+
+    char* text = deck->text;
+    size_t len = 0;
+    for(uint32_t i = 0; i < cards; i++){
+        deck->front[i] = text;
+        text += make_field(text, 4) + 1;
+        deck->back[i] = text;
+        text += make_field(text, 20) + 1;
+
+        len += write_field(deck->csv + len, deck->front[i], true);
+        deck->csv[len++] = ',';
+        len += write_field(deck->csv + len, deck->back[i], false);
+        if(random_next() % 2) deck->csv[len++] = '\r';
+        deck->csv[len++] = '\n';
+    }
+    deck->csv[len] = '\0';
+    deck->len = len;
+}
+
+// Release a generated deck
+void deck_gen_free(deck_gen_t* deck){
+    free(deck->front);
+    free(deck->back);
+    free(deck->text);
+    free(deck->csv);
+}
@@ -0,0 +1,32 @@
+/* Synthetic decks ************************************************************
+ *                                                                            *
+ *  Generates a two column CSV deck in the format the conversion script       *
+ *  writes, together with the cards it should parse to. Fields mix plain      *
+ *  text with the awkward cases: quoted fields holding commas, "" escapes     *
+ *  and CR/LF line breaks, and records ended by LF or CRLF. The same seed     *
+ *  always gives the same deck.                                               *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef DECK_GEN_H
+#define DECK_GEN_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct{
+    char* csv;                      // The deck, NUL-terminated
+    size_t len;                     // Length of `csv`
+    uint32_t cards;
+    char** front;                   // Expected fields, unescaped, per card
+    char** back;
+    char* text;                     // Storage behind `front` and `back`
+} deck_gen_t;
+
+// Generate a deck of `cards` cards
+void deck_gen(deck_gen_t* deck, uint32_t cards, uint32_t seed);
+
+// Release a generated deck
+void deck_gen_free(deck_gen_t* deck);
+
+#endif //DECK_GEN_H
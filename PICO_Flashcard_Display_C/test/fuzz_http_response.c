@@ -0,0 +1,224 @@
+/* HTTP response parser fuzz driver *******************************************
+ *                                                                            *
+ *  LLVMFuzzerTestOneInput() feeds the input to http_response twice, whole    *
+ *  and split at points taken from the input itself, and checks the           *
+ *  parser's invariants: both runs agree, nothing is consumed or reported     *
+ *  once the response is complete or in error, the body callback sees         *
+ *  exactly body_received bytes (content_length of them for a complete        *
+ *  Content-Length body), and header names and values come trimmed.          *
+ *                                                                            *
+ *  With -DHOST_FUZZ=ON (clang) this builds against libFuzzer. Otherwise a    *
+ *  standalone main() replays files named on the command line, or mutates     *
+ *  a few valid responses for a fixed number of rounds, which is what ctest   *
+ *  runs.                                                                     *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "http_response.h"
+
+#include "test.h"
+
+
+typedef struct{
+    uint64_t body_bytes;
+    uint32_t body_hash;
+    uint32_t headers;
+    uint32_t header_hash;
+    bool done;                      // Complete or in error
+    bool late_callback;             // Callback after done
+} observed_t;
+
+typedef struct{
+    http_response_parser_t parser;
+    observed_t seen;
+} run_t;
+
+static run_t whole, pieces;             // Input fed whole, and in pieces
+
+
+static uint32_t hash(uint32_t h, const char* data, size_t len){
+    while(len--) h = (h ^ (uint8_t)*data++) * 16777619u;
+    return h;
+}
+
+static bool is_space(char c){
+    return c == ' ' || c == '\t';
+}
+
+static void on_header(const char* name, const char* value, void* arg){
+    run_t* run = arg;
+    size_t name_len = strlen(name), value_len = strlen(value);
+    CHECK(name_len + value_len < HTTP_RESPONSE_LINE_SIZE);
+    CHECK(!name_len || (!is_space(name[0]) && !is_space(name[name_len - 1])));
+    CHECK(!value_len || (!is_space(value[0]) && !is_space(value[value_len - 1])));
+    CHECK(run->parser.status >= 200);
+    if(run->seen.done) run->seen.late_callback = true;
+    run->seen.headers++;
+    run->seen.header_hash = hash(hash(run->seen.header_hash, name, name_len), value, value_len);
+}
+
+static void on_body(const char* data, size_t len, void* arg){
+    run_t* run = arg;
+    CHECK(len > 0);
+    CHECK(run->parser.headers_done);
+    if(run->seen.done) run->seen.late_callback = true;
+    run->seen.body_bytes += len;
+    run->seen.body_hash = hash(run->seen.body_hash, data, len);
+}
+
+// Feed `data` in pieces; `cuts` picks the piece lengths (NULL: whole)
+static void feed(run_t* run, const char* data, size_t len, const uint8_t* cuts, size_t cuts_len){
+    memset(&run->seen, 0, sizeof(run->seen));
+    http_response_init(&run->parser, on_header, on_body, run);
+    size_t offset = 0, cut = 0;
+    while(offset < len){
+        size_t piece = cuts ? 1 + cuts[cut++ % cuts_len] % 32 : len;
+        if(piece > len - offset) piece = len - offset;
+        size_t consumed = http_response_feed(&run->parser, data + offset, piece);
+        CHECK(consumed <= piece);
+        if(run->seen.done) CHECK(consumed == 0);
+        if(consumed < piece) CHECK(run->parser.complete || run->parser.error);
+        run->seen.done = run->parser.complete || run->parser.error;
+        offset += piece;
+    }
+    http_response_close(&run->parser);
+
+    http_response_parser_t* parser = &run->parser;
+    CHECK(!run->seen.late_callback);
+    CHECK(!(parser->complete && parser->error));
+    CHECK(parser->body_received == run->seen.body_bytes);
+    if(parser->complete){
+        CHECK(parser->headers_done);
+        CHECK(parser->status >= 200 && parser->status <= 599);
+        if(parser->framing == HTTP_RESPONSE_FRAMING_LENGTH)
+            CHECK(parser->body_received == (uint64_t)parser->content_length);
+        if(parser->framing == HTTP_RESPONSE_FRAMING_NONE) CHECK(parser->body_received == 0);
+    }
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t len){
+    feed(&whole, (const char*)data, len, NULL, 0);
+    feed(&pieces, (const char*)data, len, data, len);
+    CHECK(whole.parser.complete == pieces.parser.complete);
+    CHECK(whole.parser.error == pieces.parser.error);
+    CHECK(whole.parser.status == pieces.parser.status);
+    CHECK(whole.parser.framing == pieces.parser.framing);
+    CHECK(whole.parser.body_received == pieces.parser.body_received);
+    CHECK(whole.seen.body_hash == pieces.seen.body_hash);
+    CHECK(whole.seen.headers == pieces.seen.headers);
+    CHECK(whole.seen.header_hash == pieces.seen.header_hash);
+    if(test_failures) abort();                      // Let the fuzzer keep the input
+    return 0;
+}
+
+
+/* Standalone driver **********************************************************/
+
+#ifndef HOST_LIBFUZZER
+
+#define ROUNDS              200000
+#define INPUT_MAX           2048
+
+static const char* const seeds[] = {
+    "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nhello",
+    "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5;a=b\r\nhello\r\n0\r\nX: y\r\n\r\n",
+    "HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 304 Not Modified\r\nETag: \"x\"\r\n\r\n",
+    "HTTP/1.0 200 OK\r\nServer: s\r\n\r\nbody to close",
+    "HTTP/1.1 204 No Content\r\nContent-Length: 3\r\nContent-Length: 3\r\n\r\n"
+};
+
+// Snippets spliced in by the mutator
+static const char* const tokens[] = {
+    "\r\n", "\n", ":", " ", ";", "0", "ffffffff", "HTTP/1.1 ", "200 ", "1",
+    "Content-Length: ", "Transfer-Encoding: chunked", "\r\n\r\n", "0\r\n\r\n"
+};
+
+static uint32_t seed = 1;
+
+static uint32_t random_next(void){
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+static size_t mutate(uint8_t* data, size_t len){
+    int steps = 1 + random_next() % 8;
+    while(steps--){
+        size_t at = len ? random_next() % (len + 1) : 0;
+        switch(random_next() % 5){
+            case 0:                                 // Flip a byte
+                if(at < len) data[at] ^= 1 << (random_next() % 8);
+                break;
+            case 1:                                 // Delete a run
+                if(at < len){
+                    size_t n = 1 + random_next() % (len - at);
+                    memmove(data + at, data + at + n, len - at - n);
+                    len -= n;
+                }
+                break;
+            case 2:{                                // Insert a token
+                const char* token = tokens[random_next() % (sizeof(tokens) / sizeof(tokens[0]))];
+                size_t n = strlen(token);
+                if(len + n > INPUT_MAX) break;
+                memmove(data + at + n, data + at, len - at);
+                memcpy(data + at, token, n);
+                len += n;
+                break;
+            }
+            case 3:{                                // Repeat a run
+                size_t n = 1 + random_next() % 64;
+                if(at + n > len || len + n > INPUT_MAX) break;
+                memmove(data + at + n, data + at, len - at);
+                len += n;
+                break;
+            }
+            default:                                // Truncate
+                len = at;
+                break;
+        }
+    }
+    return len;
+}
+
+int main(int argc, char** argv){
+
+    // Replay inputs, e.g. a crash the fuzzer saved
+    if(argc > 1){
+        static uint8_t data[1 << 20];
+        for(int i = 1; i < argc; i++){
+            FILE* file = fopen(argv[i], "rb");
+            if(!file){
+                perror(argv[i]);
+                return 2;
+            }
+            size_t len = fread(data, 1, sizeof(data), file);
+            fclose(file);
+            LLVMFuzzerTestOneInput(data, len);
+        }
+        return test_result("fuzz_http_response");
+    }
+
+    static uint8_t data[INPUT_MAX];
+    uint32_t complete = 0, error = 0;
+    for(int round = 0; round < ROUNDS; round++){
+        const char* start = seeds[round % (sizeof(seeds) / sizeof(seeds[0]))];
+        size_t len = strlen(start);
+        memcpy(data, start, len);
+        len = mutate(data, len);
+        LLVMFuzzerTestOneInput(data, len);
+
+        // Chain some mutations further
+        if(random_next() % 4 == 0){
+            len = mutate(data, len);
+            LLVMFuzzerTestOneInput(data, len);
+        }
+        complete += whole.parser.complete;
+        error += whole.parser.error;
+    }
+    printf("%d rounds: %u complete, %u malformed\n", ROUNDS, complete, error);
+    return test_result("fuzz_http_response");
+}
+
+#endif //HOST_LIBFUZZER
@@ -0,0 +1,12 @@
+/* Host stand-in for altcp_tls_mbedtls_structs.h ******************************/
+
+#ifndef HOST_ALTCP_TLS_MBEDTLS_STRUCTS_H
+#define HOST_ALTCP_TLS_MBEDTLS_STRUCTS_H
+
+#include "mbedtls/ssl.h"
+
+typedef struct altcp_mbedtls_state_s{
+    mbedtls_ssl_context ssl_context;
+} altcp_mbedtls_state_t;
+
+#endif //HOST_ALTCP_TLS_MBEDTLS_STRUCTS_H
@@ -0,0 +1,25 @@
+/* Host stand-in for hardware/flash.h *****************************************/
+//
+//  Erase and program act on host_flash[] with NOR semantics; see
+//  host_flash.c.
+//
+
+#ifndef HOST_HARDWARE_FLASH_H
+#define HOST_HARDWARE_FLASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Pico W
+#ifndef PICO_FLASH_SIZE_BYTES
+#define PICO_FLASH_SIZE_BYTES                       (2 * 1024 * 1024)
+#endif //PICO_FLASH_SIZE_BYTES
+
+#define FLASH_PAGE_SIZE                             (1u << 8)
+#define FLASH_SECTOR_SIZE                           (1u << 12)
+#define FLASH_BLOCK_SIZE                            (1u << 16)
+
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t* data, size_t count);
+
+#endif //HOST_HARDWARE_FLASH_H
@@ -0,0 +1,15 @@
+/* Host stand-in for hardware/regs/addressmap.h *******************************/
+//
+//  The XIP window is host_flash[].
+//
+
+#ifndef HOST_HARDWARE_REGS_ADDRESSMAP_H
+#define HOST_HARDWARE_REGS_ADDRESSMAP_H
+
+#include <stdint.h>
+
+extern uint8_t host_flash[];
+
+#define XIP_BASE                                    ((uintptr_t)host_flash)
+
+#endif //HOST_HARDWARE_REGS_ADDRESSMAP_H
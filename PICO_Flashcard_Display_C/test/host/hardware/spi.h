@@ -0,0 +1,10 @@
+/* Host stand-in for hardware/spi.h *******************************************/
+//
+//  Empty: DEV_Config.h includes it, but the host build replaces DEV_Config.c
+//  with host_dev.c, which needs nothing from it.
+//
+
+#ifndef HOST_HARDWARE_SPI_H
+#define HOST_HARDWARE_SPI_H
+
+#endif //HOST_HARDWARE_SPI_H
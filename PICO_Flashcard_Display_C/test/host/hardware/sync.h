@@ -0,0 +1,17 @@
+/* Host stand-in for hardware/sync.h ******************************************/
+//
+//  Barriers as full compiler and CPU fences, so a producer and consumer on
+//  two threads see each other's writes in order. Events wake nothing.
+//
+
+#ifndef HOST_HARDWARE_SYNC_H
+#define HOST_HARDWARE_SYNC_H
+
+static inline void __dmb(void){
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void __sev(void){
+}
+
+#endif //HOST_HARDWARE_SYNC_H
@@ -0,0 +1,185 @@
+/* Host test support **********************************************************
+ *                                                                            *
+ *  Stand-ins for the Pico hardware the libraries touch, so they build and    *
+ *  run on Linux:                                                             *
+ *                                                                            *
+ *    host_time.c   simulated clock behind pico/stdlib.h's time functions     *
+ *    host_dev.c    DEV_Config.c replacement: counts SPI traffic, plays it    *
+ *                  into a model of the panel's RAM, and runs SPI DMA         *
+ *                  transfers when told to                                    *
+ *    host_flash.c  on-board flash in RAM, behind the XIP window, with NOR    *
+ *                  erase/program semantics and power cuts on demand          *
+ *    host_net.c    wireless chip, DNS and lwIP TCP + TLS connections, played *
+ *                  step by step by the test as the server and network        *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+/* Clock **********************************************************************/
+
+// Move the simulated clock on
+void host_advance_us(uint64_t us);
+
+// Hook run by tight_loop_contents() and the sleep functions
+//
+//  Stands for hardware progressing while the CPU waits. NULL for none.
+//
+void host_set_idle(void (*idle)(void));
+
+// Wall-clock time for benchmarks (ns, monotonic)
+uint64_t host_now_ns(void);
+
+
+/* Display hardware ***********************************************************/
+
+// Page and column count of the SH1107's display RAM
+#define HOST_PANEL_PAGES                            16
+#define HOST_PANEL_COLUMNS                          128
+
+// Traffic since host_dev_reset()
+typedef struct{
+    uint32_t spi_calls;             // Blocking SPI writes
+    uint32_t spi_bytes;             // Bytes over SPI, blocking or DMA
+    uint32_t gpio_writes;           // DEV_Digital_Write() calls
+    uint32_t dma_transfers;         // DMA transfers started
+    uint32_t errors;                // Bytes sent with CS high, or CS/DC
+                                    // moved while a DMA transfer was running
+} host_dev_stats_t;
+
+extern host_dev_stats_t host_dev_stats;
+
+// Panel display RAM, as the controller would hold it
+extern uint8_t host_panel[HOST_PANEL_PAGES][HOST_PANEL_COLUMNS];
+
+// Clear the counters, the panel model and any DMA transfer
+void host_dev_reset(void);
+
+// Whether a DMA transfer is waiting to be run
+bool host_dev_dma_pending(void);
+
+// Run the pending DMA transfer and its completion interrupt
+//
+//  @return         `false` if there was none
+//
+bool host_dev_dma_finish(void);
+
+// Finish DMA transfers automatically whenever the CPU waits (the default)
+void host_dev_dma_auto(bool on);
+
+
+
+/* Flash **********************************************************************/
+
+// Flash contents, PICO_FLASH_SIZE_BYTES long; XIP_BASE points here
+extern uint8_t host_flash[];
+
+// Flash operations since host_flash_reset()
+typedef struct{
+    uint32_t erases;                // Sectors erased (including torn)
+    uint32_t programs;              // Pages programmed (including torn)
+    uint32_t bytes;                 // Bytes erased or programmed
+    uint32_t overwrites;            // Bytes programmed that were not
+                                    // erased (0xff leaves a byte as it is,
+                                    // so does not count)
+} host_flash_stats_t;
+
+extern host_flash_stats_t host_flash_stats;
+
+// Erase the whole flash, restore power and clear the counters
+void host_flash_reset(void);
+
+// Lose power part way through a later operation
+//
+//  Erase and program proceed byte by byte; once `bytes` more bytes have been
+//  erased or programmed the operation in progress stops there, leaving a
+//  torn sector or page, and every later operation fails without touching
+//  the flash.
+//
+void host_flash_cut_power(uint32_t bytes);
+
+// Whether power has been lost
+bool host_flash_power_lost(void);
+
+// Power back on, as after a reboot; the flash keeps its contents
+void host_flash_power_on(void);
+
+
+
+/* Network ********************************************************************/
+
+// Behaviour and traffic since host_net_reset()
+//
+//  The behaviour fields may be changed at any time; results are lwIP err_t
+//  and cyw43 link status values.
+//
+typedef struct{
+    int link;                       // cyw43_tcpip_link_status()
+    int join_result;                // cyw43_arch_wifi_connect_async()
+    int dns_result;                 // dns_gethostbyname(): ERR_OK for a
+                                    // cached address, else ERR_INPROGRESS
+                                    // (answer with host_net_resolve()) or
+                                    // an error
+    int write_result;               // altcp_write()
+    int close_result;               // altcp_close(); on error the caller
+                                    // must altcp_abort()
+    bool resume;                    // Server resumes an offered TLS session
+
+    uint32_t joins;                 // Network joins started
+    uint32_t queries;               // DNS queries
+    uint32_t configs;               // TLS configurations created
+    uint32_t connections;           // Connections opened
+    uint32_t closes;                // Connections closed
+    uint32_t aborts;                // Connections aborted
+    uint32_t recved;                // Bytes advertised with altcp_recved()
+    int32_t pbufs;                  // Packet buffers handed out, not freed
+    uint32_t errors;                // A connection used after it was closed,
+                                    // aborted or freed by an error; lwIP
+                                    // lock misuse
+    char request[1024];             // Bytes written to the connection
+    size_t request_len;
+} host_net_t;
+
+extern host_net_t host_net;
+
+// Forget connections and queries, clear the counters, link down, DNS
+// answered asynchronously, writes and closes succeed, no resumption
+void host_net_reset(void);
+
+// Answer the outstanding DNS query
+//
+//  @return         `false` if there was none
+//
+bool host_net_resolve(bool found);
+
+// Complete the connection's TLS handshake
+//
+//  @return         `false` if there is no connection waiting for it
+//
+bool host_net_connected(void);
+
+// Server acknowledges `len` bytes
+void host_net_ack(uint16_t len);
+
+// Server sends `len` bytes, as a chain of packet buffers of up to `piece`
+void host_net_receive(const char* data, size_t len, size_t piece);
+
+// Server closes the connection
+void host_net_close(void);
+
+// Connection fails with lwIP error `err`; lwIP frees it
+void host_net_fail(int err);
+
+// Whether the connection is open (created and not closed, aborted or failed)
+bool host_net_open(void);
+
+// Whether the open connection still has callbacks attached
+bool host_net_attached(void);
+
+
+#endif //HOST_H
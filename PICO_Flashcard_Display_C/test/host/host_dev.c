@@ -0,0 +1,199 @@
+/* Display hardware stand-in **************************************************
+ *                                                                            *
+ *  Replaces DEV_Config.c. SPI bytes are counted and, while CS is low, fed    *
+ *  to a model of the SH1107 controller: commands move the page and column    *
+ *  pointers, data bytes land in host_panel[]. A DMA transfer is only         *
+ *  recorded when started; host_dev_dma_finish() plays it out and raises     *
+ *  the completion "interrupt", so tests choose when it lands.              *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "DEV_Config.h"
+
+#include "host.h"
+
+
+host_dev_stats_t host_dev_stats;
+uint8_t host_panel[HOST_PANEL_PAGES][HOST_PANEL_COLUMNS];
+
+static bool cs = true;                      // Pin levels
+static bool dc = false;
+
+static uint8_t page = 0;                    // Controller state
+static uint8_t column = 0;
+static bool vertical = false;               // 0x21 addressing: pages advance
+static uint8_t operand = 0;                 // Command waiting for its
+                                            // argument byte, 0 if none
+
+static const uint8_t* dma_data = NULL;      // Pending DMA transfer
+static uint32_t dma_len = 0;
+static DEV_SPI_DMA_Callback dma_done = NULL;
+
+
+/* Controller model ***********************************************************/
+
+static void command(uint8_t byte){
+    if(operand){
+        operand = 0;
+        return;
+    }
+    if(byte <= 0x0f) column = (column & 0xf0) | byte;
+    else if(byte <= 0x17) column = (column & 0x0f) | (byte & 0x07) << 4;
+    else if(byte == 0x20 || byte == 0x21) vertical = byte == 0x21;
+    else if(byte >= 0xb0 && byte <= 0xbf) page = byte & 0x0f;
+    else switch(byte){
+        case 0x81: case 0xa8: case 0xad: case 0xd3:
+        case 0xd5: case 0xd9: case 0xdb: case 0xdc:
+            operand = byte;                 // Two-byte commands
+            break;
+    }
+}
+
+static void data(uint8_t byte){
+    host_panel[page][column] = byte;
+    if(vertical){
+        page = (page + 1) % HOST_PANEL_PAGES;
+        if(page == 0) column = (column + 1) % HOST_PANEL_COLUMNS;
+    } else {
+        column = (column + 1) % HOST_PANEL_COLUMNS;
+    }
+}
+
+static void shift(const uint8_t* bytes, uint32_t len){
+    host_dev_stats.spi_bytes += len;
+    if(cs){
+        host_dev_stats.errors++;
+        return;
+    }
+    for(uint32_t i = 0; i < len; i++){
+        if(dc) data(bytes[i]);
+        else command(bytes[i]);
+    }
+}
+
+static void dma_idle(void){
+    while(host_dev_dma_finish());
+}
+
+
+/* Test control ***************************************************************/
+
+void host_dev_reset(void){
+    memset(&host_dev_stats, 0, sizeof(host_dev_stats));
+    memset(host_panel, 0, sizeof(host_panel));
+    cs = true;
+    dc = false;
+    page = column = operand = 0;
+    vertical = false;
+    dma_data = NULL;
+    dma_done = NULL;
+    host_dev_dma_auto(true);
+}
+
+bool host_dev_dma_pending(void){
+    return dma_data != NULL;
+}
+
+bool host_dev_dma_finish(void){
+    if(!dma_data) return false;
+    const uint8_t* bytes = dma_data;
+    DEV_SPI_DMA_Callback done = dma_done;
+    dma_data = NULL;
+    dma_done = NULL;
+    shift(bytes, dma_len);
+    if(done) done();
+    return true;
+}
+
+void host_dev_dma_auto(bool on){
+    host_set_idle(on ? dma_idle : NULL);
+}
+
+
+/* DEV_Config.h ***************************************************************/
+
+void DEV_Digital_Write(UWORD Pin, UBYTE Value){
+    host_dev_stats.gpio_writes++;
+    if(Pin != LCD_CS_PIN && Pin != LCD_DC_PIN) return;
+    if(dma_data) host_dev_stats.errors++;
+    if(Pin == LCD_CS_PIN) cs = Value;
+    else dc = Value;
+}
+
+UBYTE DEV_Digital_Read(UWORD Pin){
+    (void)Pin;
+    return 1;
+}
+
+void DEV_GPIO_Mode(UWORD Pin, UWORD Mode){
+    (void)Pin;
+    (void)Mode;
+}
+
+void DEV_KEY_Config(UWORD Pin){
+    (void)Pin;
+}
+
+void DEV_SPI_WriteByte(UBYTE Value){
+    host_dev_stats.spi_calls++;
+    shift(&Value, 1);
+}
+
+void DEV_SPI_Write_nByte(uint8_t *pData, uint32_t Len){
+    host_dev_stats.spi_calls++;
+    shift(pData, Len);
+}
+
+void DEV_SPI_DMA_Write_nByte(const uint8_t *pData, uint32_t Len, DEV_SPI_DMA_Callback Done){
+    if(dma_data) host_dev_stats.errors++;   // Overlapping transfers
+    host_dev_stats.dma_transfers++;
+    dma_data = pData;
+    dma_len = Len;
+    dma_done = Done;
+}
+
+bool DEV_SPI_DMA_Busy(void){
+    return dma_data != NULL;
+}
+
+void DEV_SPI_Wait_Idle(void){
+}
+
+void DEV_Delay_ms(UDOUBLE xms){
+    sleep_ms(xms);
+}
+
+void DEV_Delay_us(UDOUBLE xus){
+    sleep_us(xus);
+}
+
+void DEV_I2C_Write(uint8_t addr, uint8_t reg, uint8_t Value){
+    (void)addr;
+    (void)reg;
+    (void)Value;
+}
+
+void DEV_I2C_Write_nByte(uint8_t addr, uint8_t *pData, uint32_t Len){
+    (void)addr;
+    (void)pData;
+    (void)Len;
+}
+
+uint8_t DEV_I2C_ReadByte(uint8_t addr, uint8_t reg){
+    (void)addr;
+    (void)reg;
+    return 0;
+}
+
+void DEV_SET_PWM(uint8_t Value){
+    (void)Value;
+}
+
+UBYTE DEV_Module_Init(void){
+    return 0;
+}
+
+void DEV_Module_Exit(void){
+}
@@ -0,0 +1,98 @@
+/* Flash stand-in *************************************************************
+ *                                                                            *
+ *  On-board flash as a RAM array behind XIP_BASE. Like NOR flash, erase      *
+ *  sets whole sectors to 0xff and program can only clear bits, so data       *
+ *  programmed over unerased bytes comes out ANDed, as it would on the chip.  *
+ *  Operations must be sector/page aligned, as the SDK requires.             *
+ *                                                                            *
+ *  A power cut can be scheduled a given number of bytes ahead; the           *
+ *  operation it lands in is left half done.                                  *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <assert.h>
+#include <string.h>
+
+#include "pico/flash.h"
+#include "hardware/flash.h"
+
+#include "host.h"
+
+
+// Page aligned, so a test can mmap() an image over part of it
+uint8_t host_flash[PICO_FLASH_SIZE_BYTES] __attribute__((aligned(4096)));
+host_flash_stats_t host_flash_stats;
+
+static bool cut_pending = false;            // Power cut scheduled
+static uint32_t cut_budget = 0;             // Bytes left before it
+static bool power_lost = false;
+
+// The program image ends at the start of flash, leaving it all free
+__asm__(".globl __flash_binary_end\n.set __flash_binary_end, host_flash");
+
+
+// Account for one byte; false if power is lost before it
+static bool byte_budget(void){
+    if(power_lost) return false;
+    if(cut_pending && cut_budget-- == 0){
+        power_lost = true;
+        cut_pending = false;
+        return false;
+    }
+    host_flash_stats.bytes++;
+    return true;
+}
+
+void host_flash_reset(void){
+    memset(host_flash, 0xff, sizeof(host_flash));
+    memset(&host_flash_stats, 0, sizeof(host_flash_stats));
+    cut_pending = false;
+    power_lost = false;
+}
+
+void host_flash_cut_power(uint32_t bytes){
+    cut_pending = true;
+    cut_budget = bytes;
+}
+
+bool host_flash_power_lost(void){
+    return power_lost;
+}
+
+void host_flash_power_on(void){
+    cut_pending = false;
+    power_lost = false;
+}
+
+void flash_range_erase(uint32_t flash_offs, size_t count){
+    assert(flash_offs % FLASH_SECTOR_SIZE == 0 && count % FLASH_SECTOR_SIZE == 0);
+    assert(flash_offs + count <= PICO_FLASH_SIZE_BYTES);
+    for(size_t sector = 0; sector < count && !power_lost; sector += FLASH_SECTOR_SIZE){
+        host_flash_stats.erases++;
+        for(size_t i = 0; i < FLASH_SECTOR_SIZE; i++){
+            if(!byte_budget()) break;
+            host_flash[flash_offs + sector + i] = 0xff;
+        }
+    }
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t* data, size_t count){
+    assert(flash_offs % FLASH_PAGE_SIZE == 0 && count % FLASH_PAGE_SIZE == 0);
+    assert(flash_offs + count <= PICO_FLASH_SIZE_BYTES);
+    for(size_t page = 0; page < count && !power_lost; page += FLASH_PAGE_SIZE){
+        host_flash_stats.programs++;
+        for(size_t i = page; i < page + FLASH_PAGE_SIZE; i++){
+            if(!byte_budget()) break;
+            uint8_t* byte = &host_flash[flash_offs + i];
+            if(data[i] != 0xff && *byte != 0xff) host_flash_stats.overwrites++;
+            *byte &= data[i];
+        }
+    }
+}
+
+int flash_safe_execute(void (*func)(void*), void* param, uint32_t enter_exit_timeout_ms){
+    (void)enter_exit_timeout_ms;
+    if(power_lost) return PICO_ERROR_GENERIC;
+    func(param);
+    return power_lost ? PICO_ERROR_GENERIC : PICO_OK;
+}
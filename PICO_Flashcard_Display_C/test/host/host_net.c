@@ -0,0 +1,331 @@
+/* Network stand-in ***********************************************************
+ *                                                                            *
+ *  The wireless chip, DNS and one lwIP TCP + TLS connection at a time, for   *
+ *  the HTTPS client. Nothing happens by itself: the test plays the network   *
+ *  and server through the host_net_*() calls, firing the callbacks the       *
+ *  client registered, in whatever order and at whatever time it likes.       *
+ *                                                                            *
+ *  Like lwIP, a connection freed by an error or aborted fires no more        *
+ *  callbacks (abort fires the error callback once, with ERR_ABRT); using it  *
+ *  afterwards is counted in host_net.errors, as is firing a callback while   *
+ *  the client holds the lwIP lock.                                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "pico/cyw43_arch.h"
+#include "lwip/dns.h"
+#include "lwip/altcp_tls.h"
+#include "altcp_tls_mbedtls_structs.h"
+
+#include "host.h"
+
+
+struct stdio_driver{
+    int unused;
+};
+
+struct altcp_tls_config{
+    int unused;
+};
+
+host_net_t host_net;
+cyw43_t cyw43_state;
+stdio_driver_t stdio_usb;
+
+static int lock_depth = 0;                  // cyw43_arch_lwip_begin() nesting
+
+static bool query_pending = false;          // DNS query awaiting an answer
+static char query_name[256];
+static dns_found_callback query_found;
+static void* query_arg;
+
+static struct altcp_tls_config config;
+static struct altcp_pcb pcb;                // The connection
+static altcp_mbedtls_state_t tls;
+static bool connection_open = false;
+static altcp_connected_fn connected = NULL;
+static uint8_t next_master = 0;             // Fills each new session's secret
+
+// The server's address
+static const ip_addr_t server = {0x996cc7b9};       // 185.199.108.153
+
+
+// Whether `conn` is the open connection; counts an error if not
+static bool usable(struct altcp_pcb* conn){
+    if(conn == &pcb && connection_open) return true;
+    host_net.errors++;
+    return false;
+}
+
+// Whether callbacks may fire now, i.e. not from under the client's lock
+static bool lwip_context(void){
+    if(!lock_depth) return true;
+    host_net.errors++;
+    return false;
+}
+
+
+/* Test side ******************************************************************/
+
+void host_net_reset(void){
+    memset(&host_net, 0, sizeof(host_net));
+    host_net.link = CYW43_LINK_DOWN;
+    host_net.dns_result = ERR_INPROGRESS;
+    lock_depth = 0;
+    query_pending = false;
+    connection_open = false;
+    connected = NULL;
+}
+
+bool host_net_resolve(bool found){
+    if(!query_pending || !lwip_context()) return false;
+    query_pending = false;
+    query_found(query_name, found ? &server : NULL, query_arg);
+    return true;
+}
+
+bool host_net_connected(void){
+    if(!connection_open || !connected || !lwip_context()) return false;
+
+    // Handshake: resume the offered session if the server is willing
+    mbedtls_ssl_context* ssl = &tls.ssl_context;
+    if(ssl->offering && host_net.resume) ssl->session = ssl->offered;
+    else memset(ssl->session.master, ++next_master, sizeof(ssl->session.master));
+
+    altcp_connected_fn fire = connected;
+    connected = NULL;
+    fire(pcb.arg, &pcb, ERR_OK);
+    return true;
+}
+
+void host_net_ack(uint16_t len){
+    if(connection_open && pcb.sent && lwip_context()) pcb.sent(pcb.arg, &pcb, len);
+}
+
+void host_net_receive(const char* data, size_t len, size_t piece){
+    if(!connection_open || !pcb.recv || !lwip_context()) return;
+    struct pbuf* head = NULL;
+    struct pbuf** tail = &head;
+    for(size_t offset = 0; offset < len; offset += piece){
+        size_t n = len - offset < piece ? len - offset : piece;
+        struct pbuf* p = malloc(sizeof(struct pbuf) + n);
+        p->next = NULL;
+        p->payload = p + 1;
+        p->len = n;
+        p->tot_len = len - offset;
+        memcpy(p->payload, data + offset, n);
+        *tail = p;
+        tail = &p->next;
+        host_net.pbufs++;
+    }
+    if(head) pcb.recv(pcb.arg, &pcb, head, ERR_OK);
+}
+
+void host_net_close(void){
+    if(connection_open && pcb.recv && lwip_context()) pcb.recv(pcb.arg, &pcb, NULL, ERR_OK);
+}
+
+void host_net_fail(int err){
+    if(!connection_open || !lwip_context()) return;
+    connection_open = false;                           // Freed before the callback
+    if(pcb.err) pcb.err(pcb.arg, err);
+}
+
+bool host_net_open(void){
+    return connection_open;
+}
+
+bool host_net_attached(void){
+    return connection_open && (pcb.recv || pcb.sent || pcb.err || pcb.poll);
+}
+
+
+/* Wireless and USB stdio *****************************************************/
+
+bool stdio_usb_init(void){
+    return true;
+}
+
+void stdio_set_translate_crlf(stdio_driver_t* driver, bool translate){
+}
+
+int cyw43_arch_init_with_country(uint32_t country){
+    return 0;
+}
+
+void cyw43_arch_enable_sta_mode(void){
+}
+
+int cyw43_arch_wifi_connect_async(const char* ssid, const char* pw, uint32_t auth){
+    host_net.joins++;
+    return host_net.join_result;
+}
+
+int cyw43_tcpip_link_status(cyw43_t* self, int itf){
+    return host_net.link;
+}
+
+void cyw43_arch_lwip_begin(void){
+    lock_depth++;
+}
+
+void cyw43_arch_lwip_end(void){
+    if(--lock_depth < 0){
+        host_net.errors++;
+        lock_depth = 0;
+    }
+}
+
+
+/* lwIP ***********************************************************************/
+
+char* ipaddr_ntoa(const ip_addr_t* addr){
+    static char text[16];
+    const uint8_t* octets = (const uint8_t*)&addr->addr;
+    snprintf(text, sizeof(text), "%u.%u.%u.%u", octets[0], octets[1], octets[2], octets[3]);
+    return text;
+}
+
+err_t dns_gethostbyname(const char* hostname, ip_addr_t* addr, dns_found_callback found, void* callback_arg){
+    host_net.queries++;
+    if(host_net.dns_result == ERR_OK) *addr = server;
+    if(host_net.dns_result == ERR_INPROGRESS){
+        query_pending = true;
+        snprintf(query_name, sizeof(query_name), "%s", hostname);
+        query_found = found;
+        query_arg = callback_arg;
+    }
+    return host_net.dns_result;
+}
+
+u8_t pbuf_free(struct pbuf* p){
+    u8_t count = 0;
+    while(p){
+        struct pbuf* next = p->next;
+        free(p);
+        host_net.pbufs--;
+        count++;
+        p = next;
+    }
+    return count;
+}
+
+struct altcp_tls_config* altcp_tls_create_config_client(const u8_t* cert, size_t cert_len){
+    host_net.configs++;
+    return &config;
+}
+
+struct altcp_pcb* altcp_tls_new(struct altcp_tls_config* tls_config, u8_t ip_type){
+    if(connection_open) host_net.errors++;             // Last one never closed
+    memset(&pcb, 0, sizeof(pcb));
+    memset(&tls, 0, sizeof(tls));
+    pcb.state = &tls;
+    connection_open = true;
+    connected = NULL;
+    host_net.connections++;
+    return &pcb;
+}
+
+void altcp_arg(struct altcp_pcb* conn, void* arg){
+    if(usable(conn)) conn->arg = arg;
+}
+
+void altcp_recv(struct altcp_pcb* conn, altcp_recv_fn recv){
+    if(usable(conn)) conn->recv = recv;
+}
+
+void altcp_sent(struct altcp_pcb* conn, altcp_sent_fn sent){
+    if(usable(conn)) conn->sent = sent;
+}
+
+void altcp_poll(struct altcp_pcb* conn, altcp_poll_fn poll, u8_t interval){
+    if(!usable(conn)) return;
+    conn->poll = poll;
+    conn->pollinterval = interval;
+}
+
+void altcp_err(struct altcp_pcb* conn, altcp_err_fn err){
+    if(usable(conn)) conn->err = err;
+}
+
+void altcp_recved(struct altcp_pcb* conn, u16_t len){
+    if(usable(conn)) host_net.recved += len;
+}
+
+err_t altcp_connect(struct altcp_pcb* conn, const ip_addr_t* ipaddr, u16_t port, altcp_connected_fn on_connected){
+    if(!usable(conn)) return ERR_VAL;
+    connected = on_connected;
+    return ERR_OK;
+}
+
+err_t altcp_write(struct altcp_pcb* conn, const void* dataptr, u16_t len, u8_t apiflags){
+    if(!usable(conn)) return ERR_CONN;
+    if(host_net.write_result != ERR_OK) return host_net.write_result;
+    if(host_net.request_len + len > sizeof(host_net.request)) return ERR_MEM;
+    memcpy(host_net.request + host_net.request_len, dataptr, len);
+    host_net.request_len += len;
+    return ERR_OK;
+}
+
+err_t altcp_output(struct altcp_pcb* conn){
+    return usable(conn) ? ERR_OK : ERR_CONN;
+}
+
+err_t altcp_close(struct altcp_pcb* conn){
+    if(!usable(conn)) return ERR_VAL;
+    if(host_net.close_result != ERR_OK) return host_net.close_result;
+    connection_open = false;
+    host_net.closes++;
+    return ERR_OK;
+}
+
+void altcp_abort(struct altcp_pcb* conn){
+    if(!usable(conn)) return;
+    connection_open = false;
+    host_net.aborts++;
+    if(conn->err) conn->err(conn->arg, ERR_ABRT);
+}
+
+
+/* Mbed TLS *******************************************************************/
+
+int mbedtls_ssl_set_hostname(mbedtls_ssl_context* ssl, const char* hostname){
+    snprintf(ssl->hostname, sizeof(ssl->hostname), "%s", hostname);
+    return 0;
+}
+
+int mbedtls_ssl_set_session(mbedtls_ssl_context* ssl, const mbedtls_ssl_session* session){
+    ssl->offered = *session;
+    ssl->offering = true;
+    return 0;
+}
+
+int mbedtls_ssl_get_session(const mbedtls_ssl_context* ssl, mbedtls_ssl_session* session){
+    *session = ssl->session;
+    return 0;
+}
+
+void mbedtls_ssl_session_init(mbedtls_ssl_session* session){
+    memset(session, 0, sizeof(*session));
+}
+
+void mbedtls_ssl_session_free(mbedtls_ssl_session* session){
+    memset(session, 0, sizeof(*session));
+}
+
+int mbedtls_ssl_session_save(const mbedtls_ssl_session* session, unsigned char* buf, size_t buf_len, size_t* olen){
+    *olen = sizeof(session->master);
+    if(buf_len < sizeof(session->master)) return -0x6A00;  // MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL
+    memcpy(buf, session->master, sizeof(session->master));
+    return 0;
+}
+
+int mbedtls_ssl_session_load(mbedtls_ssl_session* session, const unsigned char* buf, size_t len){
+    if(len != sizeof(session->master)) return -0x7100;      // MBEDTLS_ERR_SSL_BAD_INPUT_DATA
+    memcpy(session->master, buf, len);
+    return 0;
+}
@@ -0,0 +1,84 @@
+/* Simulated clock ************************************************************
+ *                                                                            *
+ *  Time only passes when a test calls host_advance_us() or the code under    *
+ *  test sleeps, so timeouts and schedules are deterministic.                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <time.h>
+
+#include "pico/stdlib.h"
+
+#include "host.h"
+
+
+static uint64_t now_us = 0;
+static void (*idle_hook)(void) = NULL;
+
+
+void host_advance_us(uint64_t us){
+    now_us += us;
+}
+
+void host_set_idle(void (*idle)(void)){
+    idle_hook = idle;
+}
+
+uint64_t host_now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+absolute_time_t get_absolute_time(void){
+    return now_us;
+}
+
+absolute_time_t make_timeout_time_ms(uint32_t ms){
+    return now_us + (uint64_t)ms * 1000;
+}
+
+absolute_time_t make_timeout_time_us(uint64_t us){
+    return now_us + us;
+}
+
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to){
+    return (int64_t)(to - from);
+}
+
+uint32_t to_ms_since_boot(absolute_time_t t){
+    return (uint32_t)(t / 1000);
+}
+
+uint64_t to_us_since_boot(absolute_time_t t){
+    return t;
+}
+
+uint32_t time_us_32(void){
+    return (uint32_t)now_us;
+}
+
+uint64_t time_us_64(void){
+    return now_us;
+}
+
+void tight_loop_contents(void){
+    if(idle_hook) idle_hook();
+}
+
+void sleep_us(uint64_t us){
+    tight_loop_contents();
+    now_us += us;
+}
+
+void sleep_ms(uint32_t ms){
+    sleep_us((uint64_t)ms * 1000);
+}
+
+bool best_effort_wfe_or_timeout(absolute_time_t timeout){
+    tight_loop_contents();
+    if(now_us < timeout) now_us = timeout;
+    return true;
+}
@@ -0,0 +1,46 @@
+/* Host stand-in for lwip/altcp.h *********************************************/
+//
+//  Connections are played by host_net.c; see host.h.
+//
+
+#ifndef HOST_LWIP_ALTCP_H
+#define HOST_LWIP_ALTCP_H
+
+#include "lwip/err.h"
+#include "lwip/ip_addr.h"
+#include "lwip/pbuf.h"
+
+#define TCP_WRITE_FLAG_COPY                         0x01
+
+struct altcp_pcb;
+
+typedef err_t (*altcp_accept_fn)(void* arg, struct altcp_pcb* new_conn, err_t err);
+typedef err_t (*altcp_connected_fn)(void* arg, struct altcp_pcb* conn, err_t err);
+typedef err_t (*altcp_recv_fn)(void* arg, struct altcp_pcb* conn, struct pbuf* p, err_t err);
+typedef err_t (*altcp_sent_fn)(void* arg, struct altcp_pcb* conn, u16_t len);
+typedef err_t (*altcp_poll_fn)(void* arg, struct altcp_pcb* conn);
+typedef void (*altcp_err_fn)(void* arg, err_t err);
+
+struct altcp_pcb{
+    void* arg;
+    altcp_recv_fn recv;
+    altcp_sent_fn sent;
+    altcp_poll_fn poll;
+    altcp_err_fn err;
+    u8_t pollinterval;
+    void* state;                    // altcp_mbedtls_state_t
+};
+
+void altcp_arg(struct altcp_pcb* conn, void* arg);
+void altcp_recv(struct altcp_pcb* conn, altcp_recv_fn recv);
+void altcp_sent(struct altcp_pcb* conn, altcp_sent_fn sent);
+void altcp_poll(struct altcp_pcb* conn, altcp_poll_fn poll, u8_t interval);
+void altcp_err(struct altcp_pcb* conn, altcp_err_fn err);
+void altcp_recved(struct altcp_pcb* conn, u16_t len);
+err_t altcp_connect(struct altcp_pcb* conn, const ip_addr_t* ipaddr, u16_t port, altcp_connected_fn connected);
+err_t altcp_write(struct altcp_pcb* conn, const void* dataptr, u16_t len, u8_t apiflags);
+err_t altcp_output(struct altcp_pcb* conn);
+err_t altcp_close(struct altcp_pcb* conn);
+void altcp_abort(struct altcp_pcb* conn);
+
+#endif //HOST_LWIP_ALTCP_H
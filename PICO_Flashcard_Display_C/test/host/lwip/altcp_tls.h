@@ -0,0 +1,13 @@
+/* Host stand-in for lwip/altcp_tls.h *****************************************/
+
+#ifndef HOST_LWIP_ALTCP_TLS_H
+#define HOST_LWIP_ALTCP_TLS_H
+
+#include "lwip/altcp.h"
+
+struct altcp_tls_config;
+
+struct altcp_tls_config* altcp_tls_create_config_client(const u8_t* cert, size_t cert_len);
+struct altcp_pcb* altcp_tls_new(struct altcp_tls_config* config, u8_t ip_type);
+
+#endif //HOST_LWIP_ALTCP_TLS_H
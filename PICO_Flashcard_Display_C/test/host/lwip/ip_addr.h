@@ -0,0 +1,16 @@
+/* Host stand-in for lwip/ip_addr.h *******************************************/
+
+#ifndef HOST_LWIP_IP_ADDR_H
+#define HOST_LWIP_IP_ADDR_H
+
+#include <stdint.h>
+
+typedef struct ip_addr{
+    uint32_t addr;                  // Network byte order
+} ip_addr_t;
+
+#define IPADDR_TYPE_V4                              0
+
+char* ipaddr_ntoa(const ip_addr_t* addr);
+
+#endif //HOST_LWIP_IP_ADDR_H
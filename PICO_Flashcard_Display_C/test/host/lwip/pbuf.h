@@ -0,0 +1,18 @@
+/* Host stand-in for lwip/pbuf.h **********************************************/
+
+#ifndef HOST_LWIP_PBUF_H
+#define HOST_LWIP_PBUF_H
+
+#include "lwip/err.h"
+
+struct pbuf{
+    struct pbuf* next;
+    void* payload;
+    u16_t tot_len;                  // This and the rest of the chain
+    u16_t len;                      // This buffer
+};
+
+// Frees the whole chain
+u8_t pbuf_free(struct pbuf* p);
+
+#endif //HOST_LWIP_PBUF_H
@@ -0,0 +1,8 @@
+/* Host stand-in for lwip/prot/iana.h *****************************************/
+
+#ifndef HOST_LWIP_PROT_IANA_H
+#define HOST_LWIP_PROT_IANA_H
+
+#define LWIP_IANA_PORT_HTTPS                        443
+
+#endif //HOST_LWIP_PROT_IANA_H
@@ -0,0 +1 @@
+/* Host stand-in for mbedtls/check_config.h ***********************************/
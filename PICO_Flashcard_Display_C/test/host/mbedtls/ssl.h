@@ -0,0 +1,32 @@
+/* Host stand-in for mbedtls/ssl.h ********************************************/
+//
+//  Just enough of a TLS session for resumption: its master secret. See
+//  host_net.c for how the stand-in server decides to resume.
+//
+
+#ifndef HOST_MBEDTLS_SSL_H
+#define HOST_MBEDTLS_SSL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct mbedtls_ssl_session{
+    unsigned char master[48];
+} mbedtls_ssl_session;
+
+typedef struct mbedtls_ssl_context{
+    char hostname[256];
+    mbedtls_ssl_session offered;    // Set by mbedtls_ssl_set_session()
+    bool offering;
+    mbedtls_ssl_session session;    // Negotiated by the handshake
+} mbedtls_ssl_context;
+
+int mbedtls_ssl_set_hostname(mbedtls_ssl_context* ssl, const char* hostname);
+int mbedtls_ssl_set_session(mbedtls_ssl_context* ssl, const mbedtls_ssl_session* session);
+int mbedtls_ssl_get_session(const mbedtls_ssl_context* ssl, mbedtls_ssl_session* session);
+void mbedtls_ssl_session_init(mbedtls_ssl_session* session);
+void mbedtls_ssl_session_free(mbedtls_ssl_session* session);
+int mbedtls_ssl_session_save(const mbedtls_ssl_session* session, unsigned char* buf, size_t buf_len, size_t* olen);
+int mbedtls_ssl_session_load(mbedtls_ssl_session* session, const unsigned char* buf, size_t len);
+
+#endif //HOST_MBEDTLS_SSL_H
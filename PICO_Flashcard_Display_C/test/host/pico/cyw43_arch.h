@@ -0,0 +1,38 @@
+/* Host stand-in for pico/cyw43_arch.h ****************************************/
+//
+//  The wireless chip is played by host_net.c; see host.h.
+//
+
+#ifndef HOST_PICO_CYW43_ARCH_H
+#define HOST_PICO_CYW43_ARCH_H
+
+#include <stdint.h>
+
+#define CYW43_COUNTRY(A, B, REV)                    ((unsigned char)(A) | ((unsigned char)(B) << 8) | ((REV) << 16))
+#define CYW43_COUNTRY_UK                            CYW43_COUNTRY('G', 'B', 0)
+
+#define CYW43_ITF_STA                               0
+#define CYW43_AUTH_WPA2_AES_PSK                     0x00400004
+
+#define CYW43_LINK_DOWN                             0
+#define CYW43_LINK_JOIN                             1
+#define CYW43_LINK_NOIP                             2
+#define CYW43_LINK_UP                               3
+#define CYW43_LINK_FAIL                             -1
+#define CYW43_LINK_NONET                            -2
+#define CYW43_LINK_BADAUTH                          -3
+
+typedef struct cyw43_t{
+    int unused;
+} cyw43_t;
+
+extern cyw43_t cyw43_state;
+
+int cyw43_arch_init_with_country(uint32_t country);
+void cyw43_arch_enable_sta_mode(void);
+int cyw43_arch_wifi_connect_async(const char* ssid, const char* pw, uint32_t auth);
+int cyw43_tcpip_link_status(cyw43_t* self, int itf);
+void cyw43_arch_lwip_begin(void);
+void cyw43_arch_lwip_end(void);
+
+#endif //HOST_PICO_CYW43_ARCH_H
@@ -0,0 +1,11 @@
+/* Host stand-in for pico/flash.h *********************************************/
+
+#ifndef HOST_PICO_FLASH_H
+#define HOST_PICO_FLASH_H
+
+#include "pico/stdlib.h"
+
+// Runs `func` straight away; fails once the flash has lost power
+int flash_safe_execute(void (*func)(void*), void* param, uint32_t enter_exit_timeout_ms);
+
+#endif //HOST_PICO_FLASH_H
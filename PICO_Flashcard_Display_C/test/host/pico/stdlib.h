@@ -0,0 +1,49 @@
+/* Host stand-in for pico/stdlib.h ********************************************
+ *                                                                            *
+ *  Just the parts of the Pico SDK the libraries use, on a simulated clock    *
+ *  that only moves when a test advances it or something sleeps (see          *
+ *  host.h).                                                                  *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef unsigned int uint;
+
+// pico/error.h
+enum{
+    PICO_OK = 0,
+    PICO_ERROR_GENERIC = -1
+};
+typedef uint64_t absolute_time_t;
+
+absolute_time_t get_absolute_time(void);
+absolute_time_t make_timeout_time_ms(uint32_t ms);
+absolute_time_t make_timeout_time_us(uint64_t us);
+int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to);
+uint32_t to_ms_since_boot(absolute_time_t t);
+uint64_t to_us_since_boot(absolute_time_t t);
+uint32_t time_us_32(void);
+uint64_t time_us_64(void);
+
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+bool best_effort_wfe_or_timeout(absolute_time_t timeout);
+
+// pico/stdio_usb.h; see host_net.c
+typedef struct stdio_driver stdio_driver_t;
+extern stdio_driver_t stdio_usb;
+bool stdio_usb_init(void);
+void stdio_set_translate_crlf(stdio_driver_t* driver, bool translate);
+
+// Busy-wait body; runs the host idle hook, standing for the hardware
+// getting on with things while the CPU spins
+void tight_loop_contents(void);
+
+#endif //HOST_PICO_STDLIB_H
@@ -0,0 +1,8 @@
+/* Host stand-in for pico/time.h **********************************************/
+
+#ifndef HOST_PICO_TIME_H
+#define HOST_PICO_TIME_H
+
+#include "pico/stdlib.h"
+
+#endif //HOST_PICO_TIME_H
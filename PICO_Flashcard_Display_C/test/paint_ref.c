@@ -0,0 +1,326 @@
+/* Reference renderer *********************************************************
+ *                                                                            *
+ *  Copied from GUI_Paint.c as it was before the fast paths, with one fix:    *
+ *  the original bounds check let a point at x == Width or y == Height        *
+ *  through, writing into the next row; it is rejected here, as the pixel     *
+ *  writers do.                                                               *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "paint_ref.h"
+
+
+void ref_SetPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color)
+{
+    if (Xpoint >= Paint.Width || Ypoint >= Paint.Height)
+        return;
+    UWORD X, Y;
+
+    switch (Paint.Rotate)
+    {
+    case 0:
+        X = Xpoint;
+        Y = Ypoint;
+        break;
+    case 90:
+        X = Paint.WidthMemory - Ypoint - 1;
+        Y = Xpoint;
+        break;
+    case 180:
+        X = Paint.WidthMemory - Xpoint - 1;
+        Y = Paint.HeightMemory - Ypoint - 1;
+        break;
+    case 270:
+        X = Ypoint;
+        Y = Paint.HeightMemory - Xpoint - 1;
+        break;
+    default:
+        return;
+    }
+
+    switch (Paint.Mirror)
+    {
+    case MIRROR_NONE:
+        break;
+    case MIRROR_HORIZONTAL:
+        X = Paint.WidthMemory - X - 1;
+        break;
+    case MIRROR_VERTICAL:
+        Y = Paint.HeightMemory - Y - 1;
+        break;
+    case MIRROR_ORIGIN:
+        X = Paint.WidthMemory - X - 1;
+        Y = Paint.HeightMemory - Y - 1;
+        break;
+    default:
+        return;
+    }
+
+    if (Paint.Scale == 2)
+    {
+        UDOUBLE Addr = X / 8 + Y * Paint.WidthByte;
+        UBYTE Rdata = Paint.Image[Addr];
+        if ((Color & 0xff) == BLACK)
+            Paint.Image[Addr] = Rdata & ~(0x80 >> (X % 8));
+        else
+            Paint.Image[Addr] = Rdata | (0x80 >> (X % 8));
+    }
+    else if (Paint.Scale == 4)
+    {
+        UDOUBLE Addr = X / 4 + Y * Paint.WidthByte;
+        Color = Color % 4;
+        UBYTE Rdata = Paint.Image[Addr];
+
+        Rdata = Rdata & (~(0xC0 >> ((X % 4) * 2)));
+        Paint.Image[Addr] = Rdata | ((Color << 6) >> ((X % 4) * 2));
+    }
+    else if (Paint.Scale == 16)
+    {
+        UDOUBLE Addr = X / 2 + Y * Paint.WidthByte;
+        UBYTE Rdata = Paint.Image[Addr];
+        Color = Color % 16;
+        Rdata = Rdata & (~(0xf0 >> ((X % 2) * 4)));
+        Paint.Image[Addr] = Rdata | ((Color << 4) >> ((X % 2) * 4));
+    }
+    else if (Paint.Scale == 65)
+    {
+        UDOUBLE Addr = X * 2 + Y * Paint.WidthByte;
+        Paint.Image[Addr] = 0xff & (Color >> 8);
+        Paint.Image[Addr + 1] = 0xff & Color;
+    }
+}
+
+void ref_DrawChar(UWORD Xpoint, UWORD Ypoint, const char Acsii_Char,
+                  sFONT *Font, UWORD Color_Foreground, UWORD Color_Background)
+{
+    UWORD Page, Column;
+
+    if (Xpoint > Paint.Width || Ypoint > Paint.Height)
+        return;
+
+    uint32_t Char_Offset = (Acsii_Char - ' ') * Font->Height * (Font->Width / 8 + (Font->Width % 8 ? 1 : 0));
+    const unsigned char *ptr = &Font->table[Char_Offset];
+
+    for (Page = 0; Page < Font->Height; Page++)
+    {
+        for (Column = 0; Column < Font->Width; Column++)
+        {
+            if (*ptr & (0x80 >> (Column % 8)))
+                ref_SetPixel(Xpoint + Column, Ypoint + Page, Color_Background);
+            else
+                ref_SetPixel(Xpoint + Column, Ypoint + Page, Color_Foreground);
+            if (Column % 8 == 7)
+                ptr++;
+        }
+        if (Font->Width % 8 != 0)
+            ptr++;
+    }
+}
+
+void ref_DrawPoint(UWORD Xpoint, UWORD Ypoint, UWORD Color,
+                   DOT_PIXEL Dot_Pixel, DOT_STYLE Dot_Style)
+{
+    if (Xpoint > Paint.Width || Ypoint > Paint.Height)
+    {
+        return;
+    }
+
+    int16_t XDir_Num, YDir_Num;
+    if (Dot_Style == DOT_FILL_AROUND)
+    {
+        for (XDir_Num = 0; XDir_Num < 2 * Dot_Pixel - 1; XDir_Num++)
+        {
+            for (YDir_Num = 0; YDir_Num < 2 * Dot_Pixel - 1; YDir_Num++)
+            {
+                if (Xpoint + XDir_Num - Dot_Pixel < 0 || Ypoint + YDir_Num - Dot_Pixel < 0)
+                    break;
+                ref_SetPixel(Xpoint + XDir_Num - Dot_Pixel, Ypoint + YDir_Num - Dot_Pixel, Color);
+            }
+        }
+    }
+    else
+    {
+        for (XDir_Num = 0; XDir_Num < Dot_Pixel; XDir_Num++)
+        {
+            for (YDir_Num = 0; YDir_Num < Dot_Pixel; YDir_Num++)
+            {
+                ref_SetPixel(Xpoint + XDir_Num - 1, Ypoint + YDir_Num - 1, Color);
+            }
+        }
+    }
+}
+
+void ref_DrawLine(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+                  UWORD Color, DOT_PIXEL Line_width, LINE_STYLE Line_Style)
+{
+    if (Xstart > Paint.Width || Ystart > Paint.Height ||
+        Xend > Paint.Width || Yend > Paint.Height)
+    {
+        return;
+    }
+
+    UWORD Xpoint = Xstart;
+    UWORD Ypoint = Ystart;
+    int dx = (int)Xend - (int)Xstart >= 0 ? Xend - Xstart : Xstart - Xend;
+    int dy = (int)Yend - (int)Ystart <= 0 ? Yend - Ystart : Ystart - Yend;
+
+    // Increment direction, 1 is positive, -1 is counter;
+    int XAddway = Xstart < Xend ? 1 : -1;
+    int YAddway = Ystart < Yend ? 1 : -1;
+
+    // Cumulative error
+    int Esp = dx + dy;
+    char Dotted_Len = 0;
+
+    for (;;)
+    {
+        Dotted_Len++;
+        // Painted dotted line, 2 point is really virtual
+        if (Line_Style == LINE_STYLE_DOTTED && Dotted_Len % 3 == 0)
+        {
+            if (Color)
+                ref_DrawPoint(Xpoint, Ypoint, BLACK, Line_width, DOT_STYLE_DFT);
+            else
+                ref_DrawPoint(Xpoint, Ypoint, WHITE, Line_width, DOT_STYLE_DFT);
+            Dotted_Len = 0;
+        }
+        else
+        {
+            ref_DrawPoint(Xpoint, Ypoint, Color, Line_width, DOT_STYLE_DFT);
+        }
+        if (2 * Esp >= dy)
+        {
+            if (Xpoint == Xend)
+                break;
+            Esp += dy;
+            Xpoint += XAddway;
+        }
+        if (2 * Esp <= dx)
+        {
+            if (Ypoint == Yend)
+                break;
+            Esp += dx;
+            Ypoint += YAddway;
+        }
+    }
+}
+
+void ref_DrawRectangle(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+                       UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    if (Xstart > Paint.Width || Ystart > Paint.Height ||
+        Xend > Paint.Width || Yend > Paint.Height)
+    {
+        return;
+    }
+
+    if (Draw_Fill)
+    {
+        UWORD Ypoint;
+        for (Ypoint = Ystart; Ypoint < Yend; Ypoint++)
+        {
+            ref_DrawLine(Xstart, Ypoint, Xend, Ypoint, Color, Line_width, LINE_STYLE_SOLID);
+        }
+    }
+    else
+    {
+        ref_DrawLine(Xstart, Ystart, Xend, Ystart, Color, Line_width, LINE_STYLE_SOLID);
+        ref_DrawLine(Xstart, Ystart, Xstart, Yend, Color, Line_width, LINE_STYLE_SOLID);
+        ref_DrawLine(Xend, Yend, Xend, Ystart, Color, Line_width, LINE_STYLE_SOLID);
+        ref_DrawLine(Xend, Yend, Xstart, Yend, Color, Line_width, LINE_STYLE_SOLID);
+    }
+}
+
+void ref_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius,
+                    UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill)
+{
+    if (X_Center > Paint.Width || Y_Center >= Paint.Height)
+    {
+        return;
+    }
+
+    // Draw a circle from(0, R) as a starting point
+    int16_t XCurrent, YCurrent;
+    XCurrent = 0;
+    YCurrent = Radius;
+
+    // Cumulative error,judge the next point of the logo
+    int16_t Esp = 3 - (Radius << 1);
+
+    int16_t sCountY;
+    if (Draw_Fill == DRAW_FILL_FULL)
+    {
+        while (XCurrent <= YCurrent)
+        { // Realistic circles
+            for (sCountY = XCurrent; sCountY <= YCurrent; sCountY++)
+            {
+                ref_DrawPoint(X_Center + XCurrent, Y_Center + sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT); // 1
+                ref_DrawPoint(X_Center - XCurrent, Y_Center + sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT); // 2
+                ref_DrawPoint(X_Center - sCountY, Y_Center + XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT); // 3
+                ref_DrawPoint(X_Center - sCountY, Y_Center - XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT); // 4
+                ref_DrawPoint(X_Center - XCurrent, Y_Center - sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT); // 5
+                ref_DrawPoint(X_Center + XCurrent, Y_Center - sCountY, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT); // 6
+                ref_DrawPoint(X_Center + sCountY, Y_Center - XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT); // 7
+                ref_DrawPoint(X_Center + sCountY, Y_Center + XCurrent, Color, DOT_PIXEL_DFT, DOT_STYLE_DFT);
+            }
+            if (Esp < 0)
+                Esp += 4 * XCurrent + 6;
+            else
+            {
+                Esp += 10 + 4 * (XCurrent - YCurrent);
+                YCurrent--;
+            }
+            XCurrent++;
+        }
+    }
+    else
+    { // Draw a hollow circle
+        while (XCurrent <= YCurrent)
+        {
+            ref_DrawPoint(X_Center + XCurrent, Y_Center + YCurrent, Color, Line_width, DOT_STYLE_DFT); // 1
+            ref_DrawPoint(X_Center - XCurrent, Y_Center + YCurrent, Color, Line_width, DOT_STYLE_DFT); // 2
+            ref_DrawPoint(X_Center - YCurrent, Y_Center + XCurrent, Color, Line_width, DOT_STYLE_DFT); // 3
+            ref_DrawPoint(X_Center - YCurrent, Y_Center - XCurrent, Color, Line_width, DOT_STYLE_DFT); // 4
+            ref_DrawPoint(X_Center - XCurrent, Y_Center - YCurrent, Color, Line_width, DOT_STYLE_DFT); // 5
+            ref_DrawPoint(X_Center + XCurrent, Y_Center - YCurrent, Color, Line_width, DOT_STYLE_DFT); // 6
+            ref_DrawPoint(X_Center + YCurrent, Y_Center - XCurrent, Color, Line_width, DOT_STYLE_DFT); // 7
+            ref_DrawPoint(X_Center + YCurrent, Y_Center + XCurrent, Color, Line_width, DOT_STYLE_DFT); // 0
+
+            if (Esp < 0)
+                Esp += 4 * XCurrent + 6;
+            else
+            {
+                Esp += 10 + 4 * (XCurrent - YCurrent);
+                YCurrent--;
+            }
+            XCurrent++;
+        }
+    }
+}
+
+void ref_Clear(UWORD Color)
+{
+    if (Paint.Scale == 2 || Paint.Scale == 4)
+    {
+        for (UWORD Y = 0; Y < Paint.HeightByte; Y++)
+        {
+            for (UWORD X = 0; X < Paint.WidthByte; X++)
+            {
+                UDOUBLE Addr = X + Y * Paint.WidthByte;
+                Paint.Image[Addr] = Color;
+            }
+        }
+    }
+}
+
+void ref_ClearWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color)
+{
+    UWORD X, Y;
+    for (Y = Ystart; Y < Yend; Y++)
+    {
+        for (X = Xstart; X < Xend; X++)
+        {
+            ref_SetPixel(X, Y, Color);
+        }
+    }
+}
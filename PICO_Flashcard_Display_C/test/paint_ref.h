@@ -0,0 +1,30 @@
+/* Reference renderer *********************************************************
+ *                                                                            *
+ *  GUI_Paint's original per-pixel code: every pixel goes through             *
+ *  ref_SetPixel(), which decides rotation, mirroring and bit depth afresh.   *
+ *  Works on the same global Paint as GUI_Paint.c, so the tests can draw the  *
+ *  same thing both ways and compare images bit for bit, and the benchmarks   *
+ *  can time the original against the fast paths.                             *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef PAINT_REF_H
+#define PAINT_REF_H
+
+#include "GUI_Paint.h"
+
+void ref_SetPixel(UWORD Xpoint, UWORD Ypoint, UWORD Color);
+void ref_Clear(UWORD Color);                // Scale 2 and 4 only
+void ref_ClearWindows(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend, UWORD Color);
+void ref_DrawChar(UWORD Xpoint, UWORD Ypoint, const char Acsii_Char,
+                  sFONT *Font, UWORD Color_Foreground, UWORD Color_Background);
+void ref_DrawPoint(UWORD Xpoint, UWORD Ypoint, UWORD Color,
+                   DOT_PIXEL Dot_Pixel, DOT_STYLE Dot_Style);
+void ref_DrawLine(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+                  UWORD Color, DOT_PIXEL Line_width, LINE_STYLE Line_Style);
+void ref_DrawRectangle(UWORD Xstart, UWORD Ystart, UWORD Xend, UWORD Yend,
+                       UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+void ref_DrawCircle(UWORD X_Center, UWORD Y_Center, UWORD Radius,
+                    UWORD Color, DOT_PIXEL Line_width, DRAW_FILL Draw_Fill);
+
+#endif //PAINT_REF_H
@@ -0,0 +1,29 @@
+/* Host test helpers **********************************************************
+ *                                                                            *
+ *  Each test is its own executable: CHECK() records a failure and carries    *
+ *  on, and test_result() turns the count into the exit status ctest sees.    *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+
+static int test_failures = 0;
+
+#define CHECK(cond) do{                                                        \
+    if(!(cond)){                                                               \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        test_failures++;                                                       \
+    }                                                                          \
+} while(0)
+
+// Exit status for main()
+static inline int test_result(const char* name){
+    if(test_failures) printf("%s: %d check(s) failed\n", name, test_failures);
+    else printf("%s: passed\n", name);
+    return test_failures ? 1 : 0;
+}
+
+#endif //TEST_H
@@ -0,0 +1,152 @@
+/* Deck CSV parser tests ******************************************************
+ *                                                                            *
+ *  Feeds decks to deck_csv in one piece and in random fragments (down to     *
+ *  single bytes, so quotes, "" escapes and CRLFs are split every possible    *
+ *  way) and requires the same cards either way; checks the cards against     *
+ *  the generator's, and covers the truncation and skipping rules.            *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "deck_csv.h"
+
+#include "deck_gen.h"
+#include "test.h"
+
+
+#define FRAGMENTINGS        200
+
+
+// Cards collected as "front\0back\0" pairs
+typedef struct{
+    char* text;
+    size_t len;
+    size_t size;
+    uint32_t cards;
+} cards_t;
+
+static deck_csv_parser_t parser;
+static uint32_t seed = 1;
+
+
+static uint32_t random_next(void){
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+static void collect(const char* front, const char* back, void* arg){
+    cards_t* cards = arg;
+    size_t f = strlen(front) + 1, b = strlen(back) + 1;
+    if(cards->len + f + b > cards->size){
+        cards->size = 2 * (cards->size + f + b);
+        cards->text = realloc(cards->text, cards->size);
+    }
+    memcpy(cards->text + cards->len, front, f);
+    memcpy(cards->text + cards->len + f, back, b);
+    cards->len += f + b;
+    cards->cards++;
+}
+
+// Parse `csv` in pieces of 1..`max_piece` bytes (0: in one piece)
+static cards_t parse(const char* csv, size_t len, size_t max_piece){
+    cards_t cards = {NULL, 0, 0, 0};
+    deck_csv_init(&parser, collect, &cards);
+    size_t offset = 0;
+    while(offset < len){
+        size_t piece = max_piece ? 1 + random_next() % max_piece : len;
+        if(piece > len - offset) piece = len - offset;
+        deck_csv_feed(&parser, csv + offset, piece);
+        offset += piece;
+    }
+    CHECK(deck_csv_finish(&parser) == cards.cards);
+    return cards;
+}
+
+static bool same(const cards_t* a, const cards_t* b){
+    return a->cards == b->cards && a->len == b->len && memcmp(a->text, b->text, a->len) == 0;
+}
+
+// Random fragmentation gives the same cards as a one-shot parse
+static void test_fragmentation(void){
+    static const size_t max_pieces[] = {1, 2, 7, 64, 1460};
+    for(uint32_t d = 0; d < 5; d++){
+        deck_gen_t deck;
+        deck_gen(&deck, 200, d);
+        cards_t whole = parse(deck.csv, deck.len, 0);
+
+        CHECK(whole.cards == deck.cards);
+        const char* card = whole.text;
+        for(uint32_t i = 0; i < deck.cards && i < whole.cards; i++){
+            CHECK(strcmp(card, deck.front[i]) == 0);
+            card += strlen(card) + 1;
+            CHECK(strcmp(card, deck.back[i]) == 0);
+            card += strlen(card) + 1;
+        }
+
+        for(int f = 0; f < FRAGMENTINGS; f++){
+            cards_t pieces = parse(deck.csv, deck.len, max_pieces[f % 5]);
+            CHECK(same(&whole, &pieces));
+            free(pieces.text);
+        }
+        free(whole.text);
+        deck_gen_free(&deck);
+    }
+}
+
+// Parse a literal and compare against "front\0back\0..." pairs
+static void expect(const char* csv, const char* pairs, size_t pairs_len, uint32_t count){
+    cards_t want = {(char*)pairs, pairs_len, pairs_len, count};
+    for(size_t max_piece = 0; max_piece <= 3; max_piece++){
+        cards_t got = parse(csv, strlen(csv), max_piece);
+        CHECK(same(&want, &got));
+        free(got.text);
+    }
+}
+
+#define EXPECT(csv, pairs, count)   expect(csv, pairs, sizeof(pairs) - 1, count)
+
+static void test_rules(void){
+    EXPECT("a,b\n", "a\0b\0", 1);
+    EXPECT("a,b", "a\0b\0", 1);                                     // Unterminated
+    EXPECT("\"a,\"\"x\"\"\",\"b\r\nc\"\r\n", "a,\"x\"\0b\r\nc\0", 1);
+    EXPECT("a,b,c\n", "a\0b,c\0", 1);                               // Comma in back
+    EXPECT("\n\r\njunk\n a , b \n", "a\0b\0", 1);                   // Skipped, trimmed
+    EXPECT("a,\n,b\n\"\",\"\"\nc,d\n", "c\0d\0", 1);                // Empty fields
+    EXPECT("\"a\"x,b\n", "a\0b\0", 1);                              // Junk after quote
+}
+
+// Over-long fields are truncated, and a long front leaves room for the back
+static void test_truncation(void){
+    static char csv[8 * DECK_CSV_MAX_RECORD];
+    static const size_t fronts[] = {10, DECK_CSV_MAX_RECORD / 2 - 1, DECK_CSV_MAX_RECORD / 2,
+                                    DECK_CSV_MAX_RECORD - 2, DECK_CSV_MAX_RECORD, 3000};
+    for(unsigned i = 0; i < sizeof(fronts) / sizeof(fronts[0]); i++){
+        for(size_t back = 1; back <= 3000; back = back * 4 + 1){
+            memset(csv, 'f', fronts[i]);
+            csv[fronts[i]] = ',';
+            memset(csv + fronts[i] + 1, 'b', back);
+            strcpy(csv + fronts[i] + 1 + back, "\nx,y\n");
+
+            cards_t cards = parse(csv, strlen(csv), 0);
+            CHECK(cards.cards == 2);
+            size_t front_kept = strlen(cards.text);
+            size_t back_kept = strlen(cards.text + front_kept + 1);
+            size_t front_room = DECK_CSV_MAX_RECORD / 2 - 1;
+            size_t want_front = fronts[i] < front_room ? fronts[i] : front_room;
+            size_t back_room = DECK_CSV_MAX_RECORD - 2 - want_front;
+            CHECK(front_kept == want_front);
+            CHECK(back_kept == (back < back_room ? back : back_room));
+            CHECK(parser.truncated == (fronts[i] > front_room || back > back_room));
+            free(cards.text);
+        }
+    }
+}
+
+int main(void){
+    test_fragmentation();
+    test_rules();
+    test_truncation();
+    return test_result("test_deck_csv");
+}
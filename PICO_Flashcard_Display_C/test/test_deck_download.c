@@ -0,0 +1,230 @@
+/* Deck download test *********************************************************
+ *                                                                            *
+ *  A stand-in server on a local TCP socket serves a synthetic deck of about  *
+ *  1 MB, and the client side runs the device's pipeline on what arrives:     *
+ *  http_response de-frames the body, deck_csv parses it and deck_store       *
+ *  writes it to the RAM flash stand-in. After a simulated reboot the stored  *
+ *  deck must match the generated one: whole when it fits, and otherwise the  *
+ *  cards that fit, in order, with the rest counted as dropped and no ETag    *
+ *  kept, so the next refresh is not answered with 304.                       *
+ *                                                                            *
+ *  The server writes in random sizes and the client reads in random sizes,   *
+ *  so the body reaches the parsers cut at arbitrary points.                  *
+ *                                                                            *
+ ******************************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "deck_csv.h"
+#include "deck_store.h"
+#include "http_response.h"
+
+#include "deck_gen.h"
+#include "host.h"
+#include "test.h"
+
+
+#define SEGMENT             1460    // Largest piece read or written at once
+
+
+typedef struct{
+    int listener;
+    const deck_gen_t* deck;
+    bool chunked;
+    uint32_t seed;
+} server_t;
+
+typedef struct{
+    deck_csv_parser_t csv;
+    char etag[DECK_STORE_ETAG_SIZE];
+} client_t;
+
+
+static uint32_t random_next(uint32_t* seed){
+    *seed = *seed * 1103515245 + 12345;
+    return *seed >> 8;
+}
+
+static bool send_all(int fd, const char* data, size_t len){
+    while(len){
+        ssize_t sent = send(fd, data, len, 0);
+        if(sent <= 0) return false;
+        data += sent;
+        len -= sent;
+    }
+    return true;
+}
+
+
+/* Stand-in server ************************************************************/
+
+static void* serve(void* arg){
+    server_t* server = arg;
+    int fd = accept(server->listener, NULL, NULL);
+    if(fd < 0) return NULL;
+
+    // Read the request up to its blank line
+    char request[1024];
+    size_t len = 0;
+    while(len < sizeof(request) - 1){
+        ssize_t got = recv(fd, request + len, sizeof(request) - 1 - len, 0);
+        if(got <= 0) break;
+        len += got;
+        request[len] = '\0';
+        if(strstr(request, "\r\n\r\n")) break;
+    }
+
+    const deck_gen_t* deck = server->deck;
+    char header[256];
+    int header_len = snprintf(header, sizeof(header),
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/csv\r\n"
+        "ETag: \"deck-%u\"\r\n",
+        deck->cards);
+    if(server->chunked){
+        header_len += snprintf(header + header_len, sizeof(header) - header_len,
+                               "Transfer-Encoding: chunked\r\n\r\n");
+    } else{
+        header_len += snprintf(header + header_len, sizeof(header) - header_len,
+                               "Content-Length: %zu\r\n\r\n", deck->len);
+    }
+    send_all(fd, header, header_len);
+
+    for(size_t offset = 0; offset < deck->len;){
+        size_t piece = 1 + random_next(&server->seed) % SEGMENT;
+        if(piece > deck->len - offset) piece = deck->len - offset;
+        if(server->chunked){
+            char size[16];
+            send_all(fd, size, snprintf(size, sizeof(size), "%zx\r\n", piece));
+        }
+        send_all(fd, deck->csv + offset, piece);
+        if(server->chunked) send_all(fd, "\r\n", 2);
+        offset += piece;
+    }
+    if(server->chunked) send_all(fd, "0\r\n\r\n", 5);
+
+    close(fd);
+    return NULL;
+}
+
+
+/* Device side ****************************************************************/
+
+static void store_card(const char* front, const char* back, void* arg){
+    (void)arg;
+    deck_store_add(front, back);
+}
+
+static void on_header(const char* name, const char* value, void* arg){
+    client_t* client = arg;
+    if(strcasecmp(name, "ETag") == 0) snprintf(client->etag, sizeof(client->etag), "%s", value);
+}
+
+static void on_body(const char* data, size_t len, void* arg){
+    client_t* client = arg;
+    deck_csv_feed(&client->csv, data, len);
+}
+
+// Fetch the deck from the server at `port` into the store
+static bool download(uint16_t port, uint32_t seed){
+    static client_t client;
+    static http_response_parser_t response;
+    memset(&client, 0, sizeof(client));
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(port)};
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) return false;
+    static const char request[] = "GET /deck.csv HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    send_all(fd, request, sizeof(request) - 1);
+
+    if(!deck_store_begin()) return false;
+    deck_csv_init(&client.csv, store_card, NULL);
+    http_response_init(&response, on_header, on_body, &client);
+    char buffer[SEGMENT];
+    for(;;){
+        ssize_t got = recv(fd, buffer, 1 + random_next(&seed) % SEGMENT, 0);
+        if(got <= 0) break;
+        http_response_feed(&response, buffer, got);
+    }
+    close(fd);
+
+    bool complete = http_response_close(&response);
+    CHECK(complete);
+    CHECK(response.status == 200);
+    CHECK(deck_csv_finish(&client.csv) == deck_store_staged() + deck_store_dropped());
+    return complete && deck_store_finish(client.etag, NULL);
+}
+
+// Serve `deck` once and download it
+static bool fetch(const deck_gen_t* deck, bool chunked, uint32_t seed){
+    server_t server = {socket(AF_INET, SOCK_STREAM, 0), deck, chunked, seed};
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = 0};
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    if(bind(server.listener, (struct sockaddr*)&addr, sizeof(addr)) != 0) return false;
+    if(listen(server.listener, 1) != 0) return false;
+    getsockname(server.listener, (struct sockaddr*)&addr, &addr_len);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, serve, &server);
+    bool fetched = download(ntohs(addr.sin_port), seed);
+    pthread_join(thread, NULL);
+    close(server.listener);
+    return fetched;
+}
+
+
+/* Tests **********************************************************************/
+
+// Whether the stored deck is `deck`, less the dropped cards
+static bool matches(const deck_gen_t* deck, uint32_t dropped){
+    uint32_t stored = 0;
+    for(uint32_t i = 0; i < deck->cards && stored < deck_count(); i++){
+        if(
+            strcmp(deck_front(stored), deck->front[i]) == 0
+            && strcmp(deck_back(stored), deck->back[i]) == 0
+        ) stored++;
+    }
+    return stored == deck_count() && stored + dropped == deck->cards;
+}
+
+static void test_download(uint32_t cards, bool chunked){
+    deck_gen_t deck;
+    deck_gen(&deck, cards, cards);
+    char etag[32];
+    snprintf(etag, sizeof(etag), "\"deck-%u\"", cards);
+
+    host_flash_reset();
+    deck_store_load();
+    uint64_t start = host_now_ns();
+    CHECK(fetch(&deck, chunked, cards));
+    double ms = (host_now_ns() - start) / 1e6;
+    uint32_t dropped = deck_store_dropped();
+
+    CHECK(deck_store_load());                   // Reboot
+    CHECK(matches(&deck, dropped));
+    CHECK(strcmp(deck_etag(), dropped ? "" : etag) == 0);   // Truncated: refetch in full
+    CHECK(host_flash_stats.overwrites == 0);
+    printf("%7zu bytes %s: %5u cards stored, %5u dropped, %u sectors erased, %u pages programmed, %.0f ms\n",
+           deck.len, chunked ? "chunked" : "length ", deck_count(), dropped,
+           host_flash_stats.erases, host_flash_stats.programs, ms);
+    deck_gen_free(&deck);
+}
+
+int main(void){
+    test_download(2000, false);                 // ~180 KB, fits
+    test_download(2000, true);
+    test_download(12000, false);                // ~1 MB, overflows the slot
+    test_download(12000, true);
+    return test_result("test_deck_download");
+}
@@ -0,0 +1,137 @@
+/* Deck image test ************************************************************
+ *                                                                            *
+ *  Checks csvToDeckImage.py against the C code it mirrors. A generated CSV   *
+ *  (with over-long fields, junk lines and multi-byte UTF-8 mixed in) is      *
+ *  turned into a slot image by the script and, separately, parsed by         *
+ *  deck_csv into deck_store; the two slots must be identical byte for byte.  *
+ *  The script's image is then mmap()ed over the slot in the flash stand-in,  *
+ *  so deck_store reads it in place as through XIP, and every card is walked  *
+ *  and compared with the parse.                                              *
+ *                                                                            *
+ *  Usage: test_deck_image <python> <csvToDeckImage.py>                       *
+ *                                                                            *
+ ******************************************************************************/
+
+#define _DEFAULT_SOURCE
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "deck_csv.h"
+#include "deck_store.h"
+
+#include "deck_gen.h"
+#include "host.h"
+#include "test.h"
+
+
+#define CSV_PATH            "deck_image.csv"
+#define IMAGE_PATH          "deck_image.bin"
+
+
+// Cards as parsed, for the walk
+typedef struct{
+    char** front;
+    char** back;
+    uint32_t count;
+} parsed_t;
+
+
+static void store_card(const char* front, const char* back, void* arg){
+    parsed_t* parsed = arg;
+    parsed->front[parsed->count] = strdup(front);
+    parsed->back[parsed->count] = strdup(back);
+    parsed->count++;
+    CHECK(deck_store_add(front, back));
+}
+
+// The generated deck plus the awkward cases
+static size_t write_csv(const deck_gen_t* deck){
+    FILE* file = fopen(CSV_PATH, "wb");
+    fwrite(deck->csv, 1, deck->len, file);
+    fputs("\n\njunk without a comma\n  spaced front  ,\t spaced back \r\n", file);
+    fputs("\"quoted \"\"front\"\"\"junk,back\n", file);
+    fputs("日本語,にほんご\n", file);
+    for(int i = 0; i < 1500; i++) fputc('f', file);         // Front over half a record
+    fputs(",short back\n", file);
+    fputs("front,", file);
+    for(int i = 0; i < 1500; i++) fputc('b', file);         // Back over the rest
+    fputs("\nlast,unterminated", file);
+    long len = ftell(file);
+    fclose(file);
+    return len;
+}
+
+int main(int argc, char** argv){
+    if(argc != 3){
+        fprintf(stderr, "usage: %s <python> <csvToDeckImage.py>\n", argv[0]);
+        return 2;
+    }
+
+    deck_gen_t deck;
+    deck_gen(&deck, 3000, 13);
+    size_t csv_len = write_csv(&deck);
+    char command[1024];
+    snprintf(command, sizeof(command), "\"%s\" \"%s\" %s %s >/dev/null",
+             argv[1], argv[2], CSV_PATH, IMAGE_PATH);
+    if(system(command) != 0){
+        fprintf(stderr, "%s failed\n", command);
+        return 1;
+    }
+
+    // Same CSV through the C parser into slot 0, as the first deck written
+    parsed_t parsed = {malloc((deck.cards + 16) * sizeof(char*)), malloc((deck.cards + 16) * sizeof(char*)), 0};
+    static deck_csv_parser_t parser;
+    char* csv = malloc(csv_len);
+    FILE* file = fopen(CSV_PATH, "rb");
+    CHECK(fread(csv, 1, csv_len, file) == csv_len);
+    fclose(file);
+    host_flash_reset();
+    CHECK(!deck_store_load());
+    CHECK(deck_store_begin());
+    deck_csv_init(&parser, store_card, &parsed);
+    deck_csv_feed(&parser, csv, csv_len);
+    CHECK(deck_csv_finish(&parser) == parsed.count);
+    CHECK(deck_store_finish(NULL, NULL));
+    CHECK(parsed.count == deck.cards + 6);
+
+    // Byte for byte against the script's image
+    int fd = open(IMAGE_PATH, O_RDONLY);
+    struct stat st;
+    CHECK(fd >= 0 && fstat(fd, &st) == 0);
+    CHECK(st.st_size % FLASH_PAGE_SIZE == 0 && st.st_size <= DECK_STORE_SLOT_SIZE);
+    uint8_t* slot = host_flash + DECK_FLASH_OFFSET;
+    uint8_t* image = malloc(st.st_size);
+    CHECK(pread(fd, image, st.st_size, 0) == st.st_size);
+    CHECK(memcmp(slot, image, st.st_size) == 0);
+    free(image);
+
+    // Map the image where flash would be and walk it in place
+    host_flash_reset();
+    CHECK(mmap(slot, st.st_size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == slot);
+    close(fd);
+    CHECK(deck_store_load());
+    CHECK(deck_count() == parsed.count);
+    for(uint32_t i = 0; i < deck_count() && i < parsed.count; i++){
+        const char* front = deck_front(i);
+        const char* back = deck_back(i);
+        CHECK((const uint8_t*)front >= slot && (const uint8_t*)back < slot + st.st_size);
+        CHECK(strcmp(front, parsed.front[i]) == 0);
+        CHECK(strcmp(back, parsed.back[i]) == 0);
+        uint32_t hash = deck_flash_crc32(deck_flash_crc32(0, front, strlen(front) + 1), back, strlen(back) + 1);
+        CHECK(deck_hash(i) == hash);
+        free(parsed.front[i]);
+        free(parsed.back[i]);
+    }
+    printf("%u cards, %lld byte image\n", deck_count(), (long long)st.st_size);
+
+    free(parsed.front);
+    free(parsed.back);
+    free(csv);
+    deck_gen_free(&deck);
+    return test_result("test_deck_image");
+}
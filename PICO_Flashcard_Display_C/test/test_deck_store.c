@@ -0,0 +1,191 @@
+/* Deck store tests ***********************************************************
+ *                                                                            *
+ *  Writes decks through deck_store into the RAM flash stand-in and reads     *
+ *  them back after a simulated reboot. Power is cut at points throughout a   *
+ *  deck write, including every byte of the header page, and the store must   *
+ *  then come up with either the previous deck or the new one, whole, and     *
+ *  carry on writing decks. Corrupt slots must be passed over.                *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "deck_store.h"
+
+#include "deck_gen.h"
+#include "host.h"
+#include "test.h"
+
+
+#define CUT_STEP            1499    // Bytes between power cuts in the sweep
+
+
+static uint8_t saved_flash[PICO_FLASH_SIZE_BYTES];
+
+
+// Write a whole deck; false if any step failed
+static bool write_deck(const deck_gen_t* deck, const char* etag){
+    if(!deck_store_begin()) return false;
+    for(uint32_t i = 0; i < deck->cards; i++){
+        if(!deck_store_add(deck->front[i], deck->back[i])) return false;
+    }
+    return deck_store_finish(etag, NULL);
+}
+
+// Whether the current deck is exactly `deck`
+static bool holds(const deck_gen_t* deck, const char* etag){
+    if(deck_count() != deck->cards) return false;
+    if(strcmp(deck_etag(), etag) != 0) return false;
+    for(uint32_t i = 0; i < deck->cards; i++){
+        if(strcmp(deck_front(i), deck->front[i]) != 0) return false;
+        if(strcmp(deck_back(i), deck->back[i]) != 0) return false;
+        uint32_t found;
+        if(!deck_find(deck_hash(i), &found) || strcmp(deck_front(found), deck->front[i]) != 0) return false;
+    }
+    return true;
+}
+
+// Each deck replaces the last, in alternating slots, and survives a reboot
+static void test_round_trip(void){
+    deck_gen_t decks[3];
+    const char* etags[] = {"\"a\"", "\"b\"", ""};
+    for(int d = 0; d < 3; d++) deck_gen(&decks[d], 100 + 200 * d, d);
+
+    host_flash_reset();
+    CHECK(!deck_store_load());
+    CHECK(deck_count() == 0);
+    for(int d = 0; d < 3; d++){
+        CHECK(write_deck(&decks[d], etags[d]));
+        CHECK(holds(&decks[d], etags[d]));
+        CHECK(deck_store_load());
+        CHECK(holds(&decks[d], etags[d]));
+    }
+
+    // An abandoned deck leaves the current one in place
+    CHECK(deck_store_begin());
+    CHECK(deck_store_add("front", "back"));
+    deck_store_abort();
+    CHECK(!deck_store_finish(NULL, NULL));
+    CHECK(holds(&decks[2], etags[2]));
+    CHECK(deck_store_load());
+    CHECK(holds(&decks[2], etags[2]));
+
+    // A deck that did not all fit is kept, but without its validators
+    static char text[DECK_STORE_SLOT_SIZE / 4];
+    memset(text, 'x', sizeof(text) - 1);
+    CHECK(deck_store_begin());
+    while(deck_store_add(text, "back"));
+    CHECK(deck_store_dropped() == 1);
+    CHECK(deck_store_add("front", "back"));
+    CHECK(deck_store_finish("\"full\"", "Mon, 01 Jan 2024 00:00:00 GMT"));
+    CHECK(deck_count() == deck_store_staged());
+    CHECK(deck_etag()[0] == '\0' && deck_last_modified()[0] == '\0');
+
+    CHECK(host_flash_stats.overwrites == 0);
+    for(int d = 0; d < 3; d++) deck_gen_free(&decks[d]);
+}
+
+// Cut power `cut` bytes into writing `next` over `previous`, then reboot
+static void cut_and_reboot(uint32_t cut, const deck_gen_t* previous, const deck_gen_t* next,
+                           uint32_t* old_kept, uint32_t* new_kept){
+    memcpy(host_flash, saved_flash, sizeof(saved_flash));
+    host_flash_power_on();
+    CHECK(deck_store_load());
+
+    host_flash_cut_power(cut);
+    bool written = write_deck(next, "\"next\"");
+    bool lost = host_flash_power_lost();
+    CHECK(written != lost);
+
+    host_flash_power_on();
+    deck_store_load();
+    if(holds(previous, "\"previous\"")) ++*old_kept;
+    else if(holds(next, "\"next\"")) ++*new_kept;
+    else{
+        fprintf(stderr, "cut at %u: neither deck intact\n", cut);
+        test_failures++;
+    }
+}
+
+// Power lost anywhere in a deck write leaves one whole deck
+static void test_power_loss(void){
+    deck_gen_t previous, next, after;
+    deck_gen(&previous, 300, 10);
+    deck_gen(&next, 400, 11);
+    deck_gen(&after, 50, 12);
+
+    host_flash_reset();
+    CHECK(!deck_store_load());
+    CHECK(write_deck(&previous, "\"previous\""));
+    memcpy(saved_flash, host_flash, sizeof(saved_flash));
+
+    // Bytes a full write takes; the header page comes last
+    CHECK(deck_store_load());
+    uint32_t start = host_flash_stats.bytes;
+    CHECK(write_deck(&next, "\"next\""));
+    uint32_t total = host_flash_stats.bytes - start;
+
+    uint32_t old_kept = 0, new_kept = 0;
+    for(uint32_t cut = 0; cut < total - FLASH_PAGE_SIZE; cut += CUT_STEP){
+        cut_and_reboot(cut, &previous, &next, &old_kept, &new_kept);
+        CHECK(new_kept == 0);
+
+        // The slot holding the torn deck is written over as normal
+        if(cut % (8 * CUT_STEP) == 0){
+            CHECK(write_deck(&after, ""));
+            CHECK(deck_store_load());
+            CHECK(holds(&after, ""));
+        }
+    }
+
+    // Torn header: every byte of it
+    for(uint32_t cut = total - FLASH_PAGE_SIZE; cut < total; cut++){
+        cut_and_reboot(cut, &previous, &next, &old_kept, &new_kept);
+    }
+    CHECK(old_kept > 0);
+    CHECK(new_kept > 0);
+    CHECK(new_kept < FLASH_PAGE_SIZE);      // Not before the header is all in
+    printf("%u power cuts: previous deck kept %u times, new deck %u\n",
+           old_kept + new_kept, old_kept, new_kept);
+
+    CHECK(host_flash_stats.overwrites == 0);
+    deck_gen_free(&previous);
+    deck_gen_free(&next);
+    deck_gen_free(&after);
+}
+
+// A slot that fails its checks is passed over for the older one
+static void test_corruption(void){
+    deck_gen_t older, newer;
+    deck_gen(&older, 100, 20);
+    deck_gen(&newer, 100, 21);
+
+    static const uint32_t offsets[] = {
+        0,                                      // Magic
+        offsetof(deck_store_header_t, cards),
+        offsetof(deck_store_header_t, etag),
+        DECK_STORE_INDEX + 5,
+        DECK_STORE_STRINGS + 1000
+    };
+    for(unsigned i = 0; i < sizeof(offsets) / sizeof(offsets[0]); i++){
+        host_flash_reset();
+        CHECK(!deck_store_load());
+        CHECK(write_deck(&older, "\"previous\""));
+        CHECK(write_deck(&newer, "\"next\""));
+        uint32_t slot = 1;                      // Second deck written to slot 1
+        host_flash[DECK_FLASH_OFFSET + slot * DECK_STORE_SLOT_SIZE + offsets[i]] ^= 0x10;
+        CHECK(deck_store_load());
+        CHECK(holds(&older, "\"previous\""));
+    }
+
+    deck_gen_free(&older);
+    deck_gen_free(&newer);
+}
+
+int main(void){
+    test_round_trip();
+    test_power_loss();
+    test_corruption();
+    return test_result("test_deck_store");
+}
@@ -0,0 +1,338 @@
+/* Inflate tests **************************************************************
+ *                                                                            *
+ *  Golden vectors: payloads compressed by the system zlib as gzip (with and  *
+ *  without optional header fields), zlib and raw deflate, at several levels  *
+ *  and strategies, are fed to http_inflate 1, 7 and all bytes at a time and  *
+ *  must come out exactly. Corrupt streams must be rejected: bad CRC-32,      *
+ *  ISIZE and Adler-32, back-references before the start of the output or     *
+ *  beyond the window, over-subscribed and incomplete codes, bad block types  *
+ *  and stored lengths. Truncated streams must stay incomplete.               *
+ *                                                                            *
+ *  Also built with a 1 KB window (HTTP_INFLATE_WINDOW_BITS 10), where        *
+ *  streams that need more must be refused.                                   *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "http_inflate.h"
+
+#include "deck_gen.h"
+#include "test.h"
+
+
+// zlib windowBits per wrapper, for the window under test (zlib's least is 9)
+#define WBITS               (HTTP_INFLATE_WINDOW_BITS < 9 ? 9 : HTTP_INFLATE_WINDOW_BITS)
+#define WBITS_GZIP          (16 + WBITS)
+#define WBITS_ZLIB          WBITS
+#define WBITS_RAW           (-WBITS)
+
+
+typedef struct{
+    uint8_t* data;
+    size_t len;
+    size_t size;
+} buffer_t;
+
+static http_inflate_t inflater;
+
+
+static void append(buffer_t* buffer, const void* data, size_t len){
+    if(buffer->len + len > buffer->size){
+        buffer->size = 2 * (buffer->len + len);
+        buffer->data = realloc(buffer->data, buffer->size);
+    }
+    memcpy(buffer->data + buffer->len, data, len);
+    buffer->len += len;
+}
+
+static void on_output(const char* data, size_t len, void* arg){
+    append(arg, data, len);
+}
+
+// Compress with zlib; `header` adds gzip name/comment/extra/header CRC
+static buffer_t compress_with(const buffer_t* plain, int wbits, int level, int strategy, bool header){
+    z_stream z = {0};
+    CHECK(deflateInit2(&z, level, Z_DEFLATED, wbits, 8, strategy) == Z_OK);
+    static unsigned char extra[] = "XYextra";
+    gz_header gz = {0};
+    gz.name = (unsigned char*)"deck.csv";
+    gz.comment = (unsigned char*)"comment";
+    gz.extra = extra;
+    gz.extra_len = sizeof(extra);
+    gz.hcrc = 1;
+    if(header) CHECK(deflateSetHeader(&z, &gz) == Z_OK);
+
+    buffer_t out = {malloc(deflateBound(&z, plain->len) + 64), 0, 0};
+    out.size = deflateBound(&z, plain->len) + 64;
+    z.next_in = plain->data;
+    z.avail_in = plain->len;
+    z.next_out = out.data;
+    z.avail_out = out.size;
+    CHECK(deflate(&z, Z_FINISH) == Z_STREAM_END);
+    out.len = z.total_out;
+    deflateEnd(&z);
+    return out;
+}
+
+// Inflate `len` bytes of `stream` in pieces of `piece` bytes
+static buffer_t inflate_pieces(http_inflate_format_t format, const uint8_t* stream, size_t len, size_t piece){
+    buffer_t out = {NULL, 0, 0};
+    http_inflate_init(&inflater, format, on_output, &out);
+    for(size_t offset = 0; offset < len; offset += piece){
+        size_t n = len - offset < piece ? len - offset : piece;
+        if(!http_inflate_feed(&inflater, stream + offset, n)) break;
+    }
+    return out;
+}
+
+static void check_vector(const buffer_t* plain, http_inflate_format_t format, const buffer_t* stream){
+    const size_t pieces[] = {1, 7, stream->len};
+    for(int p = 0; p < 3; p++){
+        buffer_t out = inflate_pieces(format, stream->data, stream->len, pieces[p]);
+        CHECK(!inflater.error);
+        CHECK(inflater.complete);
+        CHECK(inflater.inflated == plain->len);
+        CHECK(out.len == plain->len && (!out.len || memcmp(out.data, plain->data, out.len) == 0));
+        free(out.data);
+    }
+
+    // Cut short anywhere: incomplete, never wrong
+    for(size_t cut = 0; cut < stream->len; cut += 1 + stream->len / 13){
+        buffer_t out = inflate_pieces(format, stream->data, cut, 7);
+        CHECK(!inflater.complete);
+        CHECK(out.len <= plain->len && (!out.len || memcmp(out.data, plain->data, out.len) == 0));
+        free(out.data);
+    }
+}
+
+
+/* Golden vectors *************************************************************/
+
+static void test_golden(void){
+    static const struct{
+        int level;
+        int strategy;
+    } settings[] = {
+        {0, Z_DEFAULT_STRATEGY},        // Stored blocks
+        {1, Z_DEFAULT_STRATEGY},
+        {6, Z_DEFAULT_STRATEGY},
+        {9, Z_DEFAULT_STRATEGY},
+        {6, Z_FIXED},                   // Fixed Huffman blocks
+        {6, Z_HUFFMAN_ONLY},            // Literals only
+        {6, Z_RLE}                      // Distance 1 only
+    };
+
+    // Payloads: empty, tiny, a CSV deck, incompressible, long repeats
+    buffer_t plains[5] = {{0}};
+    append(&plains[1], "a", 1);
+    deck_gen_t deck;
+    deck_gen(&deck, 3000, 16);
+    append(&plains[2], deck.csv, deck.len);
+    deck_gen_free(&deck);
+    uint32_t seed = 16;
+    for(int i = 0; i < 100000; i++){
+        seed = seed * 1103515245 + 12345;
+        uint8_t byte = seed >> 24;
+        append(&plains[3], &byte, 1);
+    }
+    for(int i = 0; i < 3000; i++) append(&plains[4], "abcabcabcd0123456789", 7 + i % 13);
+
+    for(int p = 0; p < 5; p++){
+        for(unsigned s = 0; s < sizeof(settings) / sizeof(settings[0]); s++){
+            int level = settings[s].level, strategy = settings[s].strategy;
+            buffer_t gzip = compress_with(&plains[p], WBITS_GZIP, level, strategy, false);
+            buffer_t gzip_header = compress_with(&plains[p], WBITS_GZIP, level, strategy, true);
+            buffer_t zlib = compress_with(&plains[p], WBITS_ZLIB, level, strategy, false);
+            buffer_t raw = compress_with(&plains[p], WBITS_RAW, level, strategy, false);
+            check_vector(&plains[p], HTTP_INFLATE_GZIP, &gzip);
+            check_vector(&plains[p], HTTP_INFLATE_GZIP, &gzip_header);
+            check_vector(&plains[p], HTTP_INFLATE_ZLIB, &zlib);
+            check_vector(&plains[p], HTTP_INFLATE_RAW, &raw);
+            check_vector(&plains[p], HTTP_INFLATE_ZLIB, &raw);      // Sent as "deflate"
+            free(gzip.data);
+            free(gzip_header.data);
+            free(zlib.data);
+            free(raw.data);
+        }
+    }
+
+    // Anything after the end of the stream is ignored
+    buffer_t gzip = compress_with(&plains[2], WBITS_GZIP, 6, Z_DEFAULT_STRATEGY, false);
+    append(&gzip, "trailing junk", 13);
+    buffer_t out = inflate_pieces(HTTP_INFLATE_GZIP, gzip.data, gzip.len, 7);
+    CHECK(inflater.complete && !inflater.error && out.len == plains[2].len);
+    free(out.data);
+    free(gzip.data);
+
+    for(int p = 0; p < 5; p++) free(plains[p].data);
+}
+
+
+/* Corrupt streams ************************************************************/
+
+// Deflate bit writer, LSB first
+typedef struct{
+    uint8_t data[256];
+    size_t bits;
+} bits_t;
+
+static void put_bits(bits_t* b, uint32_t value, int count){
+    for(int i = 0; i < count; i++, b->bits++){
+        if(value >> i & 1) b->data[b->bits / 8] |= 1 << (b->bits % 8);
+    }
+}
+
+// Huffman codes are sent most significant bit first
+static void put_code(bits_t* b, uint32_t code, int count){
+    for(int i = count - 1; i >= 0; i--) put_bits(b, code >> i & 1, 1);
+}
+
+// Fixed Huffman literal/length code for `symbol`
+static void put_fixed(bits_t* b, int symbol){
+    if(symbol < 144) put_code(b, 0x30 + symbol, 8);
+    else if(symbol < 256) put_code(b, 0x190 + symbol - 144, 9);
+    else if(symbol < 280) put_code(b, symbol - 256, 7);
+    else put_code(b, 0xc0 + symbol - 280, 8);
+}
+
+static bool rejects(http_inflate_format_t format, const uint8_t* stream, size_t len){
+    bool rejected = true;
+    const size_t pieces[] = {1, 7, len};
+    for(int p = 0; p < 3; p++){
+        buffer_t out = inflate_pieces(format, stream, len, pieces[p]);
+        rejected = rejected && inflater.error && !inflater.complete;
+        CHECK(!http_inflate_feed(&inflater, (const uint8_t*)"", 1));  // Stays failed
+        free(out.data);
+    }
+    return rejected;
+}
+
+static void test_corrupt(void){
+    buffer_t plain = {0};
+    for(int i = 0; i < 500; i++) append(&plain, "card,back\n", 10);
+
+    // Wrapper checks
+    buffer_t gzip = compress_with(&plain, WBITS_GZIP, 6, Z_DEFAULT_STRATEGY, false);
+    gzip.data[gzip.len - 8] ^= 1;                               // CRC-32
+    CHECK(rejects(HTTP_INFLATE_GZIP, gzip.data, gzip.len));
+    gzip.data[gzip.len - 8] ^= 1;
+    gzip.data[gzip.len - 4] ^= 1;                               // ISIZE
+    CHECK(rejects(HTTP_INFLATE_GZIP, gzip.data, gzip.len));
+    gzip.data[gzip.len - 4] ^= 1;
+    gzip.data[0] ^= 1;                                          // Magic
+    CHECK(rejects(HTTP_INFLATE_GZIP, gzip.data, gzip.len));
+    free(gzip.data);
+
+    buffer_t zlib = compress_with(&plain, WBITS_ZLIB, 6, Z_DEFAULT_STRATEGY, false);
+    zlib.data[zlib.len - 1] ^= 1;                               // Adler-32
+    CHECK(rejects(HTTP_INFLATE_ZLIB, zlib.data, zlib.len));
+    free(zlib.data);
+    if(HTTP_INFLATE_WINDOW_BITS < 15){                          // CINFO past the window
+        zlib = compress_with(&plain, 15, 6, Z_DEFAULT_STRATEGY, false);
+        CHECK(rejects(HTTP_INFLATE_ZLIB, zlib.data, zlib.len));
+        free(zlib.data);
+    }
+    free(plain.data);
+
+    // Distance past the start of the output: 'a', then length 3 distance 2
+    bits_t b = {{0}, 0};
+    put_bits(&b, 1, 1);                     // Final
+    put_bits(&b, 1, 2);                     // Fixed codes
+    put_fixed(&b, 'a');
+    put_fixed(&b, 257);                     // Length 3
+    put_code(&b, 1, 5);                     // Distance 2
+    put_fixed(&b, 256);
+    CHECK(rejects(HTTP_INFLATE_RAW, b.data, (b.bits + 7) / 8));
+
+    // Distance beyond the window: 32768 bytes of output, then distance 32768
+    // (fine with a 32 KB window) or 1025 (needs more than 1 KB)
+    for(int far = 0; far < 2; far++){
+        buffer_t stream = {0};
+        static const uint8_t stored[5] = {0x00, 0xff, 0x7f, 0x00, 0x80};   // LEN 32767
+        static uint8_t zeros[32768];
+        append(&stream, stored, 5);
+        append(&stream, zeros, 32767);
+        memset(&b, 0, sizeof(b));
+        put_bits(&b, 1, 1);
+        put_bits(&b, 1, 2);
+        put_fixed(&b, 'x');
+        put_fixed(&b, 257);                                         // Length 3
+        if(far) put_code(&b, 29, 5), put_bits(&b, 8191, 13);        // 24577 + 8191
+        else put_code(&b, 20, 5), put_bits(&b, 0, 9);               // 1025
+        put_fixed(&b, 256);
+        append(&stream, b.data, (b.bits + 7) / 8);
+        bool needs = far ? 32768 > HTTP_INFLATE_WINDOW_SIZE : 1025 > HTTP_INFLATE_WINDOW_SIZE;
+        if(needs) CHECK(rejects(HTTP_INFLATE_RAW, stream.data, stream.len));
+        else{
+            buffer_t out = inflate_pieces(HTTP_INFLATE_RAW, stream.data, stream.len, 7);
+            CHECK(inflater.complete && out.len == 32771);
+            free(out.data);
+        }
+        free(stream.data);
+    }
+
+    // Over-subscribed code length code: 19 codes of length 1
+    memset(&b, 0, sizeof(b));
+    put_bits(&b, 1, 1);
+    put_bits(&b, 2, 2);                     // Dynamic codes
+    put_bits(&b, 0, 5);                     // HLIT 257
+    put_bits(&b, 0, 5);                     // HDIST 1
+    put_bits(&b, 15, 4);                    // HCLEN 19
+    for(int i = 0; i < 19; i++) put_bits(&b, 1, 3);
+    CHECK(rejects(HTTP_INFLATE_RAW, b.data, (b.bits + 7) / 8));
+
+    // Over-subscribed literal/length code: all 258 lengths 1. Code length
+    // code: symbols 1 and 16 (repeat previous) of length 1, codes 0 and 1
+    static const uint8_t order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+    memset(&b, 0, sizeof(b));
+    put_bits(&b, 1, 1);
+    put_bits(&b, 2, 2);
+    put_bits(&b, 0, 5);
+    put_bits(&b, 0, 5);
+    put_bits(&b, 14, 4);                    // HCLEN 18: up to symbol 1
+    for(int i = 0; i < 18; i++) put_bits(&b, order[i] == 1 || order[i] == 16, 3);
+    put_code(&b, 0, 1);                     // Length 1
+    for(int i = 0; i < 42; i++) put_code(&b, 1, 1), put_bits(&b, 3, 2);   // 6 more each
+    put_code(&b, 1, 1), put_bits(&b, 2, 2);                                // 5 more
+    CHECK(rejects(HTTP_INFLATE_RAW, b.data, (b.bits + 7) / 8));
+
+    // Incomplete literal/length code: only symbols 0 and 256, lengths 2
+    memset(&b, 0, sizeof(b));
+    put_bits(&b, 1, 1);
+    put_bits(&b, 2, 2);
+    put_bits(&b, 0, 5);
+    put_bits(&b, 0, 5);
+    put_bits(&b, 14, 4);
+    for(int i = 0; i < 18; i++){
+        int symbol = order[i];
+        put_bits(&b, symbol == 2 || symbol == 18 || symbol == 0 || symbol == 1 ? 2 : 0, 3);
+    }
+    // Code length code (canonical, length 2): 0 -> 00, 1 -> 01, 2 -> 10, 18 -> 11
+    put_code(&b, 2, 2);                                     // Symbol 0: length 2
+    put_code(&b, 3, 2), put_bits(&b, 138 - 11, 7);          // 138 zeros
+    put_code(&b, 3, 2), put_bits(&b, 117 - 11, 7);          // 117 zeros
+    put_code(&b, 2, 2);                                     // Symbol 256: length 2
+    put_code(&b, 1, 2);                                     // Distance 0: length 1
+    CHECK(rejects(HTTP_INFLATE_RAW, b.data, (b.bits + 7) / 8));
+
+    // Reserved block type
+    uint8_t reserved[] = {0x07, 0x00};
+    CHECK(rejects(HTTP_INFLATE_RAW, reserved, sizeof(reserved)));
+
+    // Stored block with NLEN not the complement of LEN
+    uint8_t stored[] = {0x01, 0x03, 0x00, 0xfc, 0xfe, 'a', 'b', 'c'};
+    CHECK(rejects(HTTP_INFLATE_RAW, stored, sizeof(stored)));
+    stored[4] = 0xff;
+    buffer_t out = inflate_pieces(HTTP_INFLATE_RAW, stored, sizeof(stored), 1);
+    CHECK(inflater.complete && out.len == 3 && memcmp(out.data, "abc", 3) == 0);
+    free(out.data);
+}
+
+int main(void){
+    test_golden();
+    test_corrupt();
+    return test_result(HTTP_INFLATE_WINDOW_BITS == 15 ? "test_http_inflate" : "test_http_inflate_small");
+}
@@ -0,0 +1,224 @@
+/* HTTP response parser tests *************************************************
+ *                                                                            *
+ *  Each canned response is fed whole, one byte at a time and in random       *
+ *  pieces, and must give the same status, framing, header fields, body and   *
+ *  end state every way. Covers each framing (Content-Length, chunked with    *
+ *  extensions and trailers, close-delimited), 1xx interim responses, 204     *
+ *  and 304, conflicting lengths and malformed input.                         *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "http_response.h"
+
+#include "test.h"
+
+
+#define BODY_MAX            256
+
+
+typedef enum{
+    OPEN,                           // Neither complete nor in error
+    COMPLETE,                       // Complete without needing the close
+    AT_CLOSE,                       // Complete once the server closes
+    ERROR
+} outcome_t;
+
+typedef struct{
+    const char* name;
+    const char* response;
+    outcome_t outcome;
+    int status;
+    http_response_framing_t framing;
+    int64_t content_length;
+    const char* body;
+    const char* headers;            // "name=value;" for each field reported
+    size_t trailing;                // Bytes left unconsumed after the response
+} case_t;
+
+typedef struct{
+    char body[BODY_MAX];
+    size_t body_len;
+    char headers[BODY_MAX];
+    size_t consumed;
+} result_t;
+
+
+static const case_t cases[] = {
+    {"content-length",
+     "HTTP/1.1 200 OK\r\nContent-Type: text/csv\r\nContent-Length: 5\r\n\r\nhelloEXTRA",
+     COMPLETE, 200, HTTP_RESPONSE_FRAMING_LENGTH, 5, "hello",
+     "Content-Type=text/csv;Content-Length=5;", 5},
+    {"content-length zero",
+     "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n",
+     COMPLETE, 200, HTTP_RESPONSE_FRAMING_LENGTH, 0, "", "Content-Length=0;", 0},
+    {"content-length repeated",
+     "HTTP/1.1 200 OK\r\ncontent-length: 3\r\nCONTENT-LENGTH:3 \r\n\r\nabc",
+     COMPLETE, 200, HTTP_RESPONSE_FRAMING_LENGTH, 3, "abc",
+     "content-length=3;CONTENT-LENGTH=3;", 0},
+    {"conflicting lengths",
+     "HTTP/1.1 200 OK\r\nContent-Length: 3\r\nContent-Length: 4\r\n\r\nabcd",
+     ERROR, 200, HTTP_RESPONSE_FRAMING_CLOSE, 4, "", "Content-Length=3;", 0},
+    {"content-length not a number",
+     "HTTP/1.1 200 OK\r\nContent-Length: 12a\r\n\r\n",
+     ERROR, 200, HTTP_RESPONSE_FRAMING_CLOSE, 0, "", "", 0},
+    {"chunked",
+     "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+     "5\r\nhello\r\n6;name=value;x\r\n world\r\nA \r\n, chunked!\r\n0\r\n\r\n",
+     COMPLETE, 200, HTTP_RESPONSE_FRAMING_CHUNKED, -1, "hello world, chunked!",
+     "Transfer-Encoding=chunked;", 0},
+    {"chunked with trailers",
+     "HTTP/1.1 200 OK\r\nTransfer-Encoding: gzip, chunked\r\n\r\n"
+     "3;ext=\"q\"\r\nabc\r\n0;last\r\nChecksum: 1234\r\nExpires: never\r\n\r\nNEXT",
+     COMPLETE, 200, HTTP_RESPONSE_FRAMING_CHUNKED, -1, "abc",
+     "Transfer-Encoding=gzip, chunked;", 4},
+    {"chunked overrides length",
+     "HTTP/1.1 200 OK\r\nContent-Length: 100\r\nTransfer-Encoding: chunked\r\n\r\n2\r\nok\r\n0\r\n\r\n",
+     COMPLETE, 200, HTTP_RESPONSE_FRAMING_CHUNKED, -1, "ok",
+     "Content-Length=100;Transfer-Encoding=chunked;", 0},
+    {"chunked not last coding",
+     "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked, gzip\r\n\r\nraw bytes",
+     AT_CLOSE, 200, HTTP_RESPONSE_FRAMING_CLOSE, -1, "raw bytes",
+     "Transfer-Encoding=chunked, gzip;", 0},
+    {"chunk data without CRLF",
+     "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n2\r\nokX\r\n0\r\n\r\n",
+     ERROR, 200, HTTP_RESPONSE_FRAMING_CHUNKED, -1, "ok", "Transfer-Encoding=chunked;", 0},
+    {"chunk size not hex",
+     "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n",
+     ERROR, 200, HTTP_RESPONSE_FRAMING_CHUNKED, -1, "", "Transfer-Encoding=chunked;", 0},
+    {"chunk size too large",
+     "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n1000000000000000\r\n",
+     ERROR, 200, HTTP_RESPONSE_FRAMING_CHUNKED, -1, "", "Transfer-Encoding=chunked;", 0},
+    {"close-delimited",
+     "HTTP/1.0 200 OK\r\nServer: x\r\n\r\nall of\r\nthis",
+     AT_CLOSE, 200, HTTP_RESPONSE_FRAMING_CLOSE, -1, "all of\r\nthis", "Server=x;", 0},
+    {"interim responses",
+     "HTTP/1.1 100 Continue\r\n\r\n"
+     "HTTP/1.1 103 Early Hints\r\nLink: </style.css>\r\n\r\n"
+     "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nhi",
+     COMPLETE, 200, HTTP_RESPONSE_FRAMING_LENGTH, 2, "hi", "Content-Length=2;", 0},
+    {"no content",
+     "HTTP/1.1 204 No Content\r\nContent-Length: 5\r\n\r\nhello",
+     COMPLETE, 204, HTTP_RESPONSE_FRAMING_NONE, 5, "", "Content-Length=5;", 5},
+    {"not modified",
+     "HTTP/1.1 304 Not Modified\r\nETag: \"v1\"\r\nTransfer-Encoding: chunked\r\n\r\n",
+     COMPLETE, 304, HTTP_RESPONSE_FRAMING_NONE, -1, "",
+     "ETag=\"v1\";Transfer-Encoding=chunked;", 0},
+    {"error status with body",
+     "HTTP/1.1 404 Not Found\r\nContent-Length: 9\r\n\r\nnot found",
+     COMPLETE, 404, HTTP_RESPONSE_FRAMING_LENGTH, 9, "not found", "Content-Length=9;", 0},
+    {"status without reason",
+     "\r\nHTTP/1.1 200\nContent-Length: 1\n\nx",
+     COMPLETE, 200, HTTP_RESPONSE_FRAMING_LENGTH, 1, "x", "Content-Length=1;", 0},
+    {"bad status line",
+     "HTTP/2 200 OK\r\n\r\n",
+     ERROR, 0, HTTP_RESPONSE_FRAMING_CLOSE, -1, "", "", 0},
+    {"bad status code",
+     "HTTP/1.1 2x0 OK\r\n\r\n",
+     ERROR, 0, HTTP_RESPONSE_FRAMING_CLOSE, -1, "", "", 0},
+    {"header without colon",
+     "HTTP/1.1 200 OK\r\nBroken header\r\n\r\n",
+     ERROR, 200, HTTP_RESPONSE_FRAMING_CLOSE, -1, "", "", 0},
+    {"truncated length body",
+     "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nshort",
+     OPEN, 200, HTTP_RESPONSE_FRAMING_LENGTH, 10, "short", "Content-Length=10;", 0},
+    {"truncated chunked body",
+     "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n",
+     OPEN, 200, HTTP_RESPONSE_FRAMING_CHUNKED, -1, "hello", "Transfer-Encoding=chunked;", 0},
+    {"truncated header",
+     "HTTP/1.1 200 OK\r\nContent-Len",
+     OPEN, 200, HTTP_RESPONSE_FRAMING_CLOSE, -1, "", "", 0},
+};
+
+static uint32_t seed = 1;
+
+
+static uint32_t random_next(void){
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+static void on_header(const char* name, const char* value, void* arg){
+    result_t* result = arg;
+    size_t len = strlen(result->headers);
+    snprintf(result->headers + len, sizeof(result->headers) - len, "%s=%s;", name, value);
+}
+
+static void on_body(const char* data, size_t len, void* arg){
+    result_t* result = arg;
+    if(result->body_len + len <= BODY_MAX){
+        memcpy(result->body + result->body_len, data, len);
+    }
+    result->body_len += len;
+}
+
+// Feed `response` in pieces of 1..`max_piece` bytes (0: whole)
+static bool run(const case_t* test, size_t max_piece){
+    static http_response_parser_t parser;
+    result_t result = {{0}, 0, {0}, 0};
+    http_response_init(&parser, on_header, on_body, &result);
+
+    size_t len = strlen(test->response);
+    size_t offset = 0;
+    while(offset < len){
+        size_t piece = max_piece ? 1 + random_next() % max_piece : len;
+        if(piece > len - offset) piece = len - offset;
+        size_t consumed = http_response_feed(&parser, test->response + offset, piece);
+        result.consumed += consumed;
+        if(consumed < piece) break;                 // Parsing stopped
+        offset += piece;
+    }
+    bool complete_before_close = parser.complete;
+    bool complete = http_response_close(&parser);
+
+    outcome_t outcome = parser.error ? ERROR
+                      : complete_before_close ? COMPLETE
+                      : complete ? AT_CLOSE
+                      : OPEN;
+    bool ok = outcome == test->outcome
+        && parser.status == test->status
+        && parser.framing == test->framing
+        && (test->outcome == ERROR || parser.content_length == test->content_length)
+        && result.body_len == strlen(test->body)
+        && parser.body_received == result.body_len
+        && memcmp(result.body, test->body, result.body_len) == 0
+        && strcmp(result.headers, test->headers) == 0
+        && (test->outcome == ERROR || result.consumed == len - test->trailing);
+    if(!ok){
+        fprintf(stderr, "%s (pieces up to %zu): outcome %d status %d framing %d length %lld"
+                " body \"%.*s\" headers \"%s\" consumed %zu\n",
+                test->name, max_piece, outcome, parser.status, parser.framing,
+                (long long)parser.content_length, (int)result.body_len, result.body,
+                result.headers, result.consumed);
+    }
+    return ok;
+}
+
+// A header line longer than the line buffer is cut short, not overrun
+static void test_long_line(void){
+    static char response[4 * HTTP_RESPONSE_LINE_SIZE];
+    strcpy(response, "HTTP/1.1 200 OK\r\nX-Long: ");
+    size_t len = strlen(response);
+    memset(response + len, 'v', 2 * HTTP_RESPONSE_LINE_SIZE);
+    strcpy(response + len + 2 * HTTP_RESPONSE_LINE_SIZE, "\r\nContent-Length: 2\r\n\r\nok");
+
+    static http_response_parser_t parser;
+    result_t result = {{0}, 0, {0}, 0};
+    http_response_init(&parser, on_header, on_body, &result);
+    http_response_feed(&parser, response, strlen(response));
+    CHECK(parser.complete);
+    CHECK(result.body_len == 2 && memcmp(result.body, "ok", 2) == 0);
+    CHECK(strlen(result.headers) < HTTP_RESPONSE_LINE_SIZE + 32);
+}
+
+int main(void){
+    for(unsigned i = 0; i < sizeof(cases) / sizeof(cases[0]); i++){
+        CHECK(run(&cases[i], 0));
+        CHECK(run(&cases[i], 1));
+        for(int r = 0; r < 50; r++) CHECK(run(&cases[i], 1 + r % 16));
+    }
+    test_long_line();
+    return test_result("test_http_response");
+}
@@ -0,0 +1,309 @@
+/* Key input tests ************************************************************
+ *                                                                            *
+ *  The event queue: order, overflow, index wrap, and a producer and a        *
+ *  consumer on two threads. The debouncer: synthetic edge timings played     *
+ *  against its timer deadlines, as the GPIO interrupt and alarms would,      *
+ *  including contact bounce, changes hidden by the lockout, long presses,    *
+ *  the 32-bit microsecond clock wrapping, and random bouncy presses checked  *
+ *  against the presses that made them.                                       *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#include "input_debounce.h"
+#include "input_keys.h"
+#include "input_queue.h"
+
+#include "test.h"
+
+
+#define THREAD_EVENTS       200000
+#define MAX_EVENTS          4096
+#define LONG_PRESS_US       (INPUT_LONG_PRESS_MS * 1000u)
+
+
+// Edge on the synthetic key
+typedef struct{
+    uint32_t at;                    // us from the start
+    bool pressed;                   // Level after it
+} edge_t;
+
+
+static input_queue_t queue;
+static input_event_t got[MAX_EVENTS];       // Events taken, times from the
+static uint32_t got_count;                  // start
+static uint32_t start;                      // Clock (us) at the start
+static uint32_t seed;
+
+
+static uint32_t random_next(void){
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+static void drain(void){
+    input_event_t event;
+    while(input_queue_pop(&queue, &event)){
+        event.time -= start;
+        if(got_count < MAX_EVENTS) got[got_count++] = event;
+    }
+}
+
+// Play edges from the start to `until`, running the timer at its deadlines
+// (before an edge at the same time), and take the events
+//
+//  A deadline already past runs the timer straight away, as an alarm set in
+//  the past would; one that never moves on fails the test.
+//
+static void play(input_debounce_t* state, const edge_t* edges, uint32_t count, uint32_t until){
+    bool level = state->pressed;
+    uint32_t now = 0;                       // From the start
+    uint32_t i = 0;
+    for(uint32_t steps = 0; ; steps++){
+        if(steps > 3 * count + 100){
+            fprintf(stderr, "debounce timer stuck at %u us\n", now);
+            test_failures++;
+            return;
+        }
+        uint32_t when;
+        uint32_t next = i < count ? edges[i].at : until;
+        if(input_debounce_deadline(state, &when) && (int32_t)(when - start - next) <= 0){
+            if((int32_t)(when - start - now) > 0) now = when - start;
+            input_debounce_timer(state, level, start + now, &queue);
+        } else if(i < count){
+            now = edges[i].at;
+            level = edges[i].pressed;
+            input_debounce_edge(state, level, start + now, &queue);
+            i++;
+        } else {
+            break;
+        }
+        drain();
+    }
+}
+
+static void begin(input_debounce_t* state, uint32_t at){
+    memset(&queue, 0, sizeof(queue));
+    got_count = 0;
+    start = at;
+    input_debounce_init(state, INPUT_KEY1, false);
+}
+
+static bool event(uint32_t i, input_type_t type, uint32_t time){
+    return i < got_count && got[i].key == INPUT_KEY1 && got[i].type == type && got[i].time == time;
+}
+
+
+/* Queue **********************************************************************/
+
+// First in, first out; pushed onto a full queue is dropped and counted
+static void test_queue_order(void){
+    memset(&queue, 0, sizeof(queue));
+    CHECK(!input_queue_pending(&queue));
+    for(uint32_t i = 0; i < INPUT_QUEUE_SIZE; i++){
+        CHECK(input_queue_push(&queue, (input_event_t){.key = i % INPUT_KEYS, .type = i % 3, .time = i}));
+    }
+    CHECK(!input_queue_push(&queue, (input_event_t){.time = 999}));
+    CHECK(queue.dropped == 1);
+    input_event_t e;
+    for(uint32_t i = 0; i < INPUT_QUEUE_SIZE; i++){
+        CHECK(input_queue_pending(&queue));
+        CHECK(input_queue_pop(&queue, &e));
+        CHECK(e.time == i && e.key == i % INPUT_KEYS && e.type == i % 3);
+    }
+    CHECK(!input_queue_pending(&queue));
+    CHECK(!input_queue_pop(&queue, &e));
+}
+
+// Across the 2^32 wrap of the indices, at every fill level
+static void test_queue_wrap(void){
+    memset(&queue, 0, sizeof(queue));
+    queue.head = queue.tail = UINT32_MAX - INPUT_QUEUE_SIZE / 2;
+    uint32_t pushed = 0, popped = 0;
+    for(uint32_t fill = 1; fill <= INPUT_QUEUE_SIZE; fill++){
+        while(pushed - popped < fill) CHECK(input_queue_push(&queue, (input_event_t){.time = pushed++}));
+        if(fill == INPUT_QUEUE_SIZE) CHECK(!input_queue_push(&queue, (input_event_t){.time = pushed}));
+        input_event_t e;
+        while(popped < pushed - fill / 2){
+            CHECK(input_queue_pop(&queue, &e));
+            CHECK(e.time == popped++);
+        }
+    }
+    CHECK(queue.head < INPUT_QUEUE_SIZE * INPUT_QUEUE_SIZE);  // Wrapped
+    CHECK(queue.dropped == 1);
+}
+
+// Waits for room rather than dropping, so every event crosses over
+static void* producer(void* arg){
+    (void)arg;
+    for(uint32_t i = 0; i < THREAD_EVENTS; i++){
+        while(queue.head - queue.tail == INPUT_QUEUE_SIZE) sched_yield();
+        input_queue_push(&queue, (input_event_t){.key = i % INPUT_KEYS, .type = i % 3, .time = i});
+    }
+    return NULL;
+}
+
+// Every event arrives whole and in order
+static void test_queue_threads(void){
+    memset(&queue, 0, sizeof(queue));
+    pthread_t thread;
+    CHECK(pthread_create(&thread, NULL, producer, NULL) == 0);
+    uint32_t received = 0, torn = 0, disordered = 0;
+    for(;;){
+        input_event_t e;
+        if(!input_queue_pop(&queue, &e)){
+            if(received == THREAD_EVENTS) break;
+            sched_yield();
+            continue;
+        }
+        if(e.key != e.time % INPUT_KEYS || e.type != e.time % 3) torn++;
+        if(e.time != received) disordered++;
+        received++;
+    }
+    pthread_join(thread, NULL);
+    CHECK(torn == 0);
+    CHECK(disordered == 0);
+    CHECK(queue.dropped == 0);
+}
+
+
+/* Debouncer ******************************************************************/
+
+// No bounce: each change reported as it happens
+static void test_clean(void){
+    input_debounce_t state;
+    begin(&state, 5000000);
+    const edge_t edges[] = {{1000, true}, {200000, false}, {500000, true}, {600000, false}};
+    play(&state, edges, 4, 3000000);
+    CHECK(got_count == 4);
+    CHECK(event(0, INPUT_PRESS, 1000));
+    CHECK(event(1, INPUT_RELEASE, 200000));
+    CHECK(event(2, INPUT_PRESS, 500000));
+    CHECK(event(3, INPUT_RELEASE, 600000));
+    uint32_t when;
+    CHECK(!input_debounce_deadline(&state, &when));
+}
+
+// Bounce within the lockout: one event per change, at its first edge
+static void test_bounce(void){
+    input_debounce_t state;
+    begin(&state, 0);
+    const edge_t edges[] = {
+        {1000, true}, {1200, false}, {1500, true}, {2100, false}, {3000, true},
+        {300000, false}, {300400, true}, {301000, false}, {310000, true}, {312000, false}
+    };
+    play(&state, edges, 10, 2000000);
+    CHECK(got_count == 2);
+    CHECK(event(0, INPUT_PRESS, 1000));
+    CHECK(event(1, INPUT_RELEASE, 300000));
+}
+
+// A change the lockout hid is reported when it ends, and locks out again
+static void test_hidden(void){
+    input_debounce_t state;
+    begin(&state, 0);
+    const edge_t edges[] = {{0, true}, {5000, false}, {30000, true}};
+    play(&state, edges, 3, 2000000);
+    CHECK(got_count == 4);
+    CHECK(event(0, INPUT_PRESS, 0));
+    CHECK(event(1, INPUT_RELEASE, INPUT_DEBOUNCE_US));
+    CHECK(event(2, INPUT_PRESS, 2 * INPUT_DEBOUNCE_US));
+    CHECK(event(3, INPUT_LONG_PRESS, 2 * INPUT_DEBOUNCE_US + LONG_PRESS_US));
+
+    // A glitch that is over by the end of the lockout is not reported
+    begin(&state, 0);
+    const edge_t glitch[] = {{0, true}, {5000, false}, {9000, true}, {400000, false}};
+    play(&state, glitch, 4, 2000000);
+    CHECK(got_count == 2);
+    CHECK(event(0, INPUT_PRESS, 0));
+    CHECK(event(1, INPUT_RELEASE, 400000));
+}
+
+// Held for the long-press time, and only just not
+static void test_long_press(void){
+    input_debounce_t state;
+    begin(&state, 0);
+    const edge_t edges[] = {
+        {1000, true}, {1000 + LONG_PRESS_US + 5000, false},
+        {2000000, true}, {2000000 + LONG_PRESS_US - 1, false}
+    };
+    play(&state, edges, 4, 4000000);
+    CHECK(got_count == 5);
+    CHECK(event(0, INPUT_PRESS, 1000));
+    CHECK(event(1, INPUT_LONG_PRESS, 1000 + LONG_PRESS_US));
+    CHECK(event(2, INPUT_RELEASE, 1000 + LONG_PRESS_US + 5000));
+    CHECK(event(3, INPUT_PRESS, 2000000));
+    CHECK(event(4, INPUT_RELEASE, 2000000 + LONG_PRESS_US - 1));
+}
+
+// time_us_32() wraps every 71 minutes, part way through a long press
+static void test_wrap(void){
+    input_debounce_t state;
+    begin(&state, UINT32_MAX - LONG_PRESS_US / 2);
+    const edge_t edges[] = {{0, true}, {700, false}, {1500, true}, {LONG_PRESS_US + 100000, false}};
+    play(&state, edges, 4, 2000000);
+    CHECK(got_count == 3);
+    CHECK(event(0, INPUT_PRESS, 0));
+    CHECK(event(1, INPUT_LONG_PRESS, LONG_PRESS_US));
+    CHECK(event(2, INPUT_RELEASE, LONG_PRESS_US + 100000));
+}
+
+// Random presses, each change bouncing for up to most of the lockout: the
+// events are exactly the presses, at their first edges
+static void test_random(void){
+    static edge_t edges[MAX_EVENTS];
+    static uint32_t change_at[MAX_EVENTS];
+    input_debounce_t state;
+    seed = 25;
+    begin(&state, random_next());
+    uint32_t count = 0, changes = 0, at = 1000;
+    bool pressed = false;
+    while(count < MAX_EVENTS - 16 && changes < MAX_EVENTS / 4){
+        pressed = !pressed;
+        change_at[changes++] = at;
+        uint32_t bounces = random_next() % 6;
+        uint32_t t = at;
+        for(uint32_t b = 0; b < 2 * bounces; b++){
+            edges[count++] = (edge_t){t, b % 2 == 0 ? pressed : !pressed};
+            t += 1 + random_next() % (INPUT_DEBOUNCE_US / 12);
+        }
+        edges[count++] = (edge_t){t, pressed};
+        uint32_t hold = random_next() % 3 == 0 ? LONG_PRESS_US + random_next() % 400000 : random_next() % LONG_PRESS_US;
+        at += INPUT_DEBOUNCE_US + hold;
+    }
+    play(&state, edges, count, at + 2 * LONG_PRESS_US);
+
+    uint32_t e = 0, longs = 0;
+    for(uint32_t c = 0; c < changes; c++){
+        bool press = c % 2 == 0;
+        if(!event(e++, press ? INPUT_PRESS : INPUT_RELEASE, change_at[c])){
+            fprintf(stderr, "change %u at %u: not reported as it happened\n", c, change_at[c]);
+            test_failures++;
+            break;
+        }
+        uint32_t release = c + 1 < changes ? change_at[c + 1] : UINT32_MAX;
+        if(press && release - change_at[c] >= LONG_PRESS_US){
+            CHECK(event(e++, INPUT_LONG_PRESS, change_at[c] + LONG_PRESS_US));
+            longs++;
+        }
+    }
+    CHECK(e == got_count);
+    CHECK(longs > 0);
+    printf("%u changes in %u edges: %u events, %u long presses\n", changes, count, got_count, longs);
+}
+
+int main(void){
+    test_queue_order();
+    test_queue_wrap();
+    test_queue_threads();
+    test_clean();
+    test_bounce();
+    test_hidden();
+    test_long_press();
+    test_wrap();
+    test_random();
+    return test_result("test_input");
+}
@@ -0,0 +1,171 @@
+/* Asynchronous OLED flush tests **********************************************
+ *                                                                            *
+ *  Drives the DMA flush state machine with simulated DMA completions: the    *
+ *  test decides when each transfer lands, and checks what is in flight,      *
+ *  when the completion callback runs, and what ends up on the panel.         *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "OLED_1in3_c.h"
+
+#include "host.h"
+#include "test.h"
+
+
+#define WIDTH               OLED_1in3_C_ROW_BYTES
+#define FRAME_BYTES         (WIDTH * OLED_1in3_C_HEIGHT)
+
+
+static UBYTE image[FRAME_BYTES];
+static int done_calls = 0;
+
+
+static void done(void){
+    done_calls++;
+}
+
+static UBYTE reverse(UBYTE temp){
+    temp = ((temp & 0x55) << 1) | ((temp & 0xaa) >> 1);
+    temp = ((temp & 0x33) << 2) | ((temp & 0xcc) >> 2);
+    temp = ((temp & 0x0f) << 4) | ((temp & 0xf0) >> 4);
+    return temp;
+}
+
+static void fill(UBYTE* frame, uint32_t seed){
+    for(int i = 0; i < FRAME_BYTES; i++){
+        seed = seed * 1103515245 + 12345;
+        frame[i] = seed >> 16;
+    }
+}
+
+// Whether the panel shows `frame`: image row j is panel column 63 - j
+static bool panel_shows(const UBYTE* frame){
+    for(int j = 0; j < OLED_1in3_C_HEIGHT; j++){
+        for(int i = 0; i < WIDTH; i++){
+            if(host_panel[i][63 - j] != reverse(frame[i + j * WIDTH])) return false;
+        }
+    }
+    return true;
+}
+
+// Land transfers one at a time; the callback must only run after the last
+static uint32_t finish_all(void){
+    uint32_t transfers = 0;
+    while(host_dev_dma_pending()){
+        CHECK(OLED_1in3_C_Display_Poll());
+        CHECK(done_calls == 0);
+        host_dev_dma_finish();
+        transfers++;
+    }
+    return transfers;
+}
+
+static void start(void){
+    host_dev_reset();
+    OLED_1in3_C_Init();
+    host_dev_dma_auto(false);
+    done_calls = 0;
+}
+
+static void test_full_frame(void){
+    start();
+    fill(image, 1);
+    static UBYTE sent[FRAME_BYTES];
+    memcpy(sent, image, sizeof(sent));
+
+    OLED_1in3_C_Display_Start(image, done);
+    CHECK(OLED_1in3_C_Display_Poll());
+    CHECK(host_dev_dma_pending());
+
+    // The image is staged, so it can be redrawn while the flush runs
+    fill(image, 2);
+
+    CHECK(finish_all() == OLED_1in3_C_HEIGHT);
+    CHECK(done_calls == 1);
+    CHECK(!OLED_1in3_C_Display_Poll());
+    CHECK(panel_shows(sent));
+    CHECK(host_dev_stats.errors == 0);
+}
+
+static void test_rows(void){
+    start();
+    fill(image, 3);
+    OLED_1in3_C_Display_Start(image, NULL);
+    finish_all();
+
+    static UBYTE next[FRAME_BYTES];
+    fill(next, 4);
+    UBYTE rows[OLED_1in3_C_HEIGHT / 8] = {0};
+    rows[0] = 0x01;                         // Rows 0, 13 and 63
+    rows[1] = 0x20;
+    rows[7] = 0x80;
+    OLED_1in3_C_Display_Rows(next, rows, done);
+    CHECK(finish_all() == 3);
+    CHECK(done_calls == 1);
+
+    for(int j = 0; j < OLED_1in3_C_HEIGHT; j++){
+        if(j == 0 || j == 13 || j == 63) memcpy(&image[j * WIDTH], &next[j * WIDTH], WIDTH);
+    }
+    CHECK(panel_shows(image));
+    CHECK(host_dev_stats.errors == 0);
+}
+
+static void test_diff(void){
+    start();
+    fill(image, 5);
+    OLED_1in3_C_Display_Start(image, NULL);
+    finish_all();
+
+    // Two bytes apart in one row: one run covering both
+    image[10 * WIDTH + 3] ^= 0xff;
+    image[10 * WIDTH + 9] ^= 0x0f;
+    host_dev_stats.spi_bytes = 0;
+    OLED_1in3_C_Display_Diff(image, NULL, done);
+    CHECK(finish_all() == 1);
+    CHECK(done_calls == 1);
+    CHECK(OLED_1in3_C_Frame_Bytes() == 3 + 7);
+    CHECK(host_dev_stats.spi_bytes == 3 + 7);
+    CHECK(panel_shows(image));
+
+    // Nothing changed: done at once, nothing sent
+    OLED_1in3_C_Display_Diff(image, NULL, done);
+    CHECK(!host_dev_dma_pending());
+    CHECK(!OLED_1in3_C_Display_Poll());
+    CHECK(done_calls == 2);
+    CHECK(OLED_1in3_C_Frame_Bytes() == 0);
+    CHECK(host_dev_stats.errors == 0);
+}
+
+static void test_overlap(void){
+    start();
+    fill(image, 6);
+    OLED_1in3_C_Display_Start(image, done);
+    host_dev_dma_finish();
+
+    // A new frame waits for the one in flight (DMA lands while it spins)
+    host_dev_dma_auto(true);
+    static UBYTE next[FRAME_BYTES];
+    fill(next, 7);
+    OLED_1in3_C_Display_Start(next, done);
+    CHECK(done_calls == 1);
+    OLED_1in3_C_Display_Wait();
+    CHECK(done_calls == 2);
+    CHECK(!OLED_1in3_C_Display_Poll());
+    CHECK(panel_shows(next));
+
+    // The blocking path waits too
+    OLED_1in3_C_Display_Start(image, NULL);
+    OLED_1in3_C_Display(image);
+    CHECK(panel_shows(image));
+    CHECK(host_dev_stats.errors == 0);
+}
+
+int main(void){
+    test_full_frame();
+    test_rows();
+    test_diff();
+    test_overlap();
+    return test_result("test_oled_async");
+}
@@ -0,0 +1,187 @@
+/* Pixel writer golden-image tests ********************************************
+ *                                                                            *
+ *  For every rotation x mirror x scale combination, draws the same pixels    *
+ *  and primitives through GUI_Paint (its generated pixel writers, span       *
+ *  fills and glyph blitter) and through the original per-pixel code in       *
+ *  paint_ref.c, on identical scribbled images, and requires the results to   *
+ *  match bit for bit, including the bytes past the end of the image.         *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "GUI_Paint.h"
+
+#include "paint_ref.h"
+#include "test.h"
+
+
+// An odd-sized image, so rows end in a partial byte and rotation matters
+#define WIDTH               45
+#define HEIGHT              30
+#define BUFFER_BYTES        4096    // Past the largest image (Scale 65)
+
+
+static UBYTE expected[BUFFER_BYTES];
+static UBYTE actual[BUFFER_BYTES];
+static uint32_t seed;
+
+static const UWORD rotations[] = {ROTATE_0, ROTATE_90, ROTATE_180, ROTATE_270};
+static const UBYTE mirrors[] = {MIRROR_NONE, MIRROR_HORIZONTAL, MIRROR_VERTICAL, MIRROR_ORIGIN};
+static const UBYTE scales[] = {2, 4, 16, 65};
+
+
+static uint32_t random_next(void){
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+// A colour the current scale can store
+static UWORD colour(void){
+    switch(Paint.Scale){
+        case 2: return random_next() & 1 ? WHITE : BLACK;
+        case 4: return random_next() % 4;
+        case 16: return random_next() % 16;
+        default: return random_next();
+    }
+}
+
+static void setup(UWORD rotate, UBYTE mirror, UBYTE scale){
+    for(int i = 0; i < BUFFER_BYTES; i++) expected[i] = actual[i] = random_next();
+    Paint_NewImage(actual, WIDTH, HEIGHT, rotate, WHITE);
+    Paint_SetMirroring(mirror);
+    Paint_SetScale(scale);
+}
+
+#define BOTH(call_ref, call_paint) do{  \
+    Paint_SelectImage(expected);        \
+    call_ref;                           \
+    Paint_SelectImage(actual);          \
+    call_paint;                         \
+} while(0)
+
+static bool same(void){
+    return memcmp(expected, actual, BUFFER_BYTES) == 0;
+}
+
+// Single pixels, including ones just outside the image
+static bool pixels(void){
+    for(int i = 0; i < 3000; i++){
+        UWORD x = random_next() % (Paint.Width + 2);
+        UWORD y = random_next() % (Paint.Height + 2);
+        UWORD c = colour();
+        BOTH(ref_SetPixel(x, y, c), Paint_SetPixel(x, y, c));
+    }
+    return same();
+}
+
+static bool points(void){
+    UWORD W = Paint.Width, H = Paint.Height;
+    UWORD xs[] = {0, 1, W / 2, W - 1, W};
+    UWORD ys[] = {0, 1, H / 2, H - 1, H};
+    for(unsigned i = 0; i < 5; i++){
+        for(DOT_PIXEL size = DOT_PIXEL_1X1; size <= DOT_PIXEL_4X4; size++){
+            for(DOT_STYLE style = DOT_FILL_AROUND; style <= DOT_FILL_RIGHTUP; style++){
+                UWORD c = colour();
+                BOTH(ref_DrawPoint(xs[i], ys[4 - i], c, size, style),
+                     Paint_DrawPoint(xs[i], ys[4 - i], c, size, style));
+            }
+        }
+    }
+    return same();
+}
+
+static bool lines(void){
+    for(int i = 0; i < 60; i++){
+        UWORD x0 = random_next() % (Paint.Width + 1), y0 = random_next() % (Paint.Height + 1);
+        UWORD x1 = random_next() % (Paint.Width + 1), y1 = random_next() % (Paint.Height + 1);
+        DOT_PIXEL width = 1 + random_next() % 3;
+        LINE_STYLE style = random_next() % 2 ? LINE_STYLE_DOTTED : LINE_STYLE_SOLID;
+        UWORD c = colour();
+        BOTH(ref_DrawLine(x0, y0, x1, y1, c, width, style),
+             Paint_DrawLine(x0, y0, x1, y1, c, width, style));
+    }
+    return same();
+}
+
+static bool rectangles(void){
+    for(int i = 0; i < 60; i++){
+        UWORD x0 = random_next() % (Paint.Width + 1), y0 = random_next() % (Paint.Height + 1);
+        UWORD x1 = random_next() % (Paint.Width + 1), y1 = random_next() % (Paint.Height + 1);
+        DOT_PIXEL width = 1 + random_next() % 3;
+        DRAW_FILL fill = random_next() % 2 ? DRAW_FILL_FULL : DRAW_FILL_EMPTY;
+        UWORD c = colour();
+        BOTH(ref_DrawRectangle(x0, y0, x1, y1, c, width, fill),
+             Paint_DrawRectangle(x0, y0, x1, y1, c, width, fill));
+    }
+    return same();
+}
+
+static bool circles(void){
+    for(int i = 0; i < 30; i++){
+        UWORD x = random_next() % Paint.Width, y = random_next() % Paint.Height;
+        UWORD r = random_next() % 20;
+        DOT_PIXEL width = 1 + random_next() % 2;
+        DRAW_FILL fill = random_next() % 2 ? DRAW_FILL_FULL : DRAW_FILL_EMPTY;
+        UWORD c = colour();
+        BOTH(ref_DrawCircle(x, y, r, c, width, fill),
+             Paint_DrawCircle(x, y, r, c, width, fill));
+    }
+    return same();
+}
+
+static bool windows(void){
+    for(int i = 0; i < 40; i++){
+        UWORD x0 = random_next() % (Paint.Width + 2), y0 = random_next() % (Paint.Height + 2);
+        UWORD x1 = random_next() % (Paint.Width + 2), y1 = random_next() % (Paint.Height + 2);
+        UWORD c = colour();
+        BOTH(ref_ClearWindows(x0, y0, x1, y1, c), Paint_ClearWindows(x0, y0, x1, y1, c));
+    }
+    return same();
+}
+
+// Glyphs inside the image and clipped at its right and bottom edges
+static bool glyphs(void){
+    sFONT* fonts[] = {&Font8, &Font12};
+    for(int i = 0; i < 40; i++){
+        sFONT* font = fonts[i % 2];
+        UWORD x = random_next() % Paint.Width, y = random_next() % Paint.Height;
+        char ch = ' ' + random_next() % 95;
+        UWORD fg = colour(), bg = colour();
+        BOTH(ref_DrawChar(x, y, ch, font, fg, bg),
+             Paint_DrawChar(x, y, ch, font, fg, bg));
+    }
+    return same();
+}
+
+int main(void){
+    static const struct{
+        const char* name;
+        bool (*run)(void);
+    } cases[] = {
+        {"pixels", pixels},
+        {"points", points},
+        {"lines", lines},
+        {"rectangles", rectangles},
+        {"circles", circles},
+        {"windows", windows},
+        {"glyphs", glyphs}
+    };
+
+    for(unsigned c = 0; c < sizeof(cases) / sizeof(cases[0]); c++){
+        for(unsigned r = 0; r < 4; r++){
+            for(unsigned m = 0; m < 4; m++){
+                for(unsigned s = 0; s < 4; s++){
+                    seed = c * 64 + r * 16 + m * 4 + s;
+                    setup(rotations[r], mirrors[m], scales[s]);
+                    if(!cases[c].run()){
+                        fprintf(stderr, "%s differ: rotate %u mirror %u scale %u\n",
+                                cases[c].name, rotations[r], mirrors[m], scales[s]);
+                        test_failures++;
+                    }
+                }
+            }
+        }
+    }
+    return test_result("test_paint");
+}
@@ -0,0 +1,348 @@
+/* HTTPS client state machine tests *******************************************
+ *                                                                            *
+ *  Drives picohttps_start()/picohttps_poll() against the network stand-in    *
+ *  (host_net.c) on the simulated clock: complete requests, with and without  *
+ *  a network join, DNS query and full handshake; every phase timing out;     *
+ *  connection errors and the server hanging up at each stage; send and       *
+ *  close failures. Every request must end DONE or FAILED as it should, with  *
+ *  the connection closed, no packet buffer leaked and the connection never   *
+ *  touched after lwIP freed it.                                              *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "pico/cyw43_arch.h"
+#include "lwip/dns.h"
+#include "lwip/altcp_tls.h"
+
+#include "picohttps.h"
+
+#include "host.h"
+#include "test.h"
+
+
+#define RESPONSE_OK                                                            \
+    "HTTP/1.1 200 OK\r\n"                                                      \
+    "ETag: \"v2\"\r\n"                                                         \
+    "Last-Modified: Sat, 17 Oct 2026 09:00:00 GMT\r\n"                         \
+    "Transfer-Encoding: chunked\r\n"                                           \
+    "\r\n"                                                                     \
+    "5\r\nhello\r\n6\r\n world\r\n0\r\n\r\n"
+
+
+static char body[4096];
+static size_t body_len;
+
+
+static void on_body(const char* data, size_t len, void* arg){
+    if(body_len + len <= sizeof(body)) memcpy(body + body_len, data, len);
+    body_len += len;
+}
+
+static void advance_ms(uint32_t ms){
+    host_advance_us((uint64_t)ms * 1000);
+}
+
+// Start a request on a reset network
+static void start(const picohttps_validators_t* cached, picohttps_validators_t* received){
+    host_net_reset();
+    body_len = 0;
+    CHECK(picohttps_start(cached, received, on_body, NULL));
+    CHECK(picohttps_busy());
+}
+
+// Start a request and join the network, up to the DNS query
+static void to_resolving(void){
+    start(NULL, NULL);
+    CHECK(picohttps_poll() == PICOHTTPS_JOINING);
+    CHECK(host_net.joins == 1);
+    host_net.link = CYW43_LINK_UP;
+    CHECK(picohttps_poll() == PICOHTTPS_RESOLVING);
+    CHECK(host_net.queries == 1);
+}
+
+// On to the TLS handshake
+static void to_connecting(void){
+    to_resolving();
+    CHECK(host_net_resolve(true));
+    CHECK(host_net_open() && host_net_attached());
+    CHECK(picohttps_poll() == PICOHTTPS_CONNECTING);
+}
+
+// On to awaiting the response, the request sent and acknowledged
+static void to_receiving(void){
+    to_connecting();
+    CHECK(host_net_connected());
+    CHECK(picohttps_poll() == PICOHTTPS_SENDING);
+    host_net_ack(host_net.request_len);
+    CHECK(picohttps_poll() == PICOHTTPS_RECEIVING);
+}
+
+// A finished request must have let go of the connection cleanly
+static void check_finished(picohttps_state_t expected){
+    CHECK(picohttps_poll() == expected);
+    CHECK(!picohttps_busy());
+    CHECK(!host_net_open());
+    CHECK(host_net.pbufs == 0);
+    CHECK(host_net.errors == 0);
+}
+
+static void receive(const char* text, size_t piece){
+    host_net_receive(text, strlen(text), piece);
+}
+
+
+/* Complete requests **********************************************************/
+
+static void test_done(void){
+
+    // Network join, DNS query, full handshake, conditional request
+    picohttps_validators_t cached = {"\"v1\"", "Fri, 16 Oct 2026 09:00:00 GMT"};
+    picohttps_validators_t received;
+    start(&cached, &received);
+    advance_ms(100);
+    CHECK(picohttps_poll() == PICOHTTPS_JOINING);
+    advance_ms(400);
+    host_net.link = CYW43_LINK_UP;
+    CHECK(picohttps_poll() == PICOHTTPS_RESOLVING);
+    advance_ms(30);
+    CHECK(host_net_resolve(true));
+    CHECK(picohttps_poll() == PICOHTTPS_CONNECTING);
+    advance_ms(1200);
+    CHECK(host_net_connected());
+    CHECK(strstr(host_net.request, "GET /anki-csv-decks/cards.csv HTTP/1.1\r\n") == host_net.request);
+    CHECK(strstr(host_net.request, "If-None-Match: \"v1\"\r\n"));
+    CHECK(strstr(host_net.request, "If-Modified-Since: Fri, 16 Oct 2026 09:00:00 GMT\r\n"));
+    CHECK(host_net.request_len > 4 && !memcmp(host_net.request + host_net.request_len - 4, "\r\n\r\n", 4));
+
+    // Acknowledged piecewise
+    host_net_ack(10);
+    CHECK(picohttps_poll() == PICOHTTPS_SENDING);
+    host_net_ack(host_net.request_len - 10);
+    CHECK(picohttps_poll() == PICOHTTPS_RECEIVING);
+
+    // Response in two segments, each a chain of small packet buffers
+    const char* response = RESPONSE_OK;
+    size_t half = strlen(response) / 2;
+    advance_ms(200);
+    host_net_receive(response, half, 16);
+    CHECK(picohttps_poll() == PICOHTTPS_RECEIVING);
+    host_net_receive(response + half, strlen(response) - half, 7);
+    check_finished(PICOHTTPS_DONE);
+
+    CHECK(response_status == 200);
+    CHECK(body_len == 11 && !memcmp(body, "hello world", 11));
+    CHECK(!strcmp(received.etag, "\"v2\""));
+    CHECK(!strcmp(received.last_modified, "Sat, 17 Oct 2026 09:00:00 GMT"));
+    CHECK(host_net.recved == strlen(response));
+    CHECK(host_net.closes == 1 && host_net.aborts == 0);
+    CHECK(host_net.configs == 1);
+    CHECK(picohttps_timing.join_ms == 500);
+    CHECK(picohttps_timing.resolve_ms == 30);
+    CHECK(picohttps_timing.handshake_ms == 1200);
+    CHECK(picohttps_timing.transfer_ms == 200);
+    CHECK(!picohttps_timing.resumed);
+
+    // Still joined, address cached, session resumed, file unchanged
+    host_net_reset();
+    host_net.link = CYW43_LINK_UP;
+    host_net.dns_result = ERR_OK;
+    host_net.resume = true;
+    body_len = 0;
+    CHECK(picohttps_start(&received, NULL, on_body, NULL));
+    CHECK(picohttps_poll() == PICOHTTPS_CONNECTING);
+    CHECK(host_net.joins == 0);
+    CHECK(host_net_connected());
+    CHECK(strstr(host_net.request, "If-None-Match: \"v2\"\r\n"));
+    host_net_ack(host_net.request_len);
+    receive("HTTP/1.1 304 Not Modified\r\nETag: \"v2\"\r\n\r\n", 1460);
+    check_finished(PICOHTTPS_DONE);
+    CHECK(response_status == 304);
+    CHECK(body_len == 0);
+    CHECK(picohttps_timing.join_ms == 0);
+    CHECK(picohttps_timing.resumed);
+    CHECK(host_net.configs == 0);       // Kept from the first connection
+
+    // A new request only once the last is over
+    to_receiving();
+    CHECK(!picohttps_start(NULL, NULL, on_body, NULL));
+    receive("HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\nabc", 1460);
+    check_finished(PICOHTTPS_DONE);
+    CHECK(body_len == 3);
+
+    // The body ends when the server closes, if nothing else frames it
+    to_receiving();
+    receive("HTTP/1.1 200 OK\r\n\r\nto the end", 1460);
+    CHECK(picohttps_poll() == PICOHTTPS_RECEIVING);
+    host_net_close();
+    check_finished(PICOHTTPS_DONE);
+    CHECK(body_len == 10);
+
+    // A connection that will not close gracefully is aborted, without its
+    // error callback reaching the finished request
+    to_receiving();
+    host_net.close_result = ERR_MEM;
+    receive("HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n", 1460);
+    check_finished(PICOHTTPS_DONE);
+    CHECK(host_net.closes == 0 && host_net.aborts == 1);
+}
+
+
+/* Timeouts *******************************************************************/
+
+static void test_timeouts(void){
+
+    // Network never joined
+    start(NULL, NULL);
+    CHECK(picohttps_poll() == PICOHTTPS_JOINING);
+    host_net.link = CYW43_LINK_JOIN;
+    advance_ms(PICOHTTPS_WIFI_TIMEOUT - 1);
+    CHECK(picohttps_poll() == PICOHTTPS_JOINING);
+    advance_ms(1);
+    check_finished(PICOHTTPS_FAILED);
+    CHECK(host_net.joins == 1 && host_net.queries == 0);
+
+    // DNS never answers; a late answer is ignored
+    to_resolving();
+    advance_ms(PICOHTTPS_TIMEOUT - 1);
+    CHECK(picohttps_poll() == PICOHTTPS_RESOLVING);
+    advance_ms(1);
+    check_finished(PICOHTTPS_FAILED);
+    CHECK(host_net_resolve(true));
+    CHECK(host_net.connections == 0);
+    CHECK(picohttps_poll() == PICOHTTPS_FAILED);
+
+    // Handshake never completes
+    to_connecting();
+    advance_ms(PICOHTTPS_TIMEOUT);
+    check_finished(PICOHTTPS_FAILED);
+    CHECK(host_net.closes == 1);
+    CHECK(!host_net_connected());
+
+    // Request never acknowledged, nothing received
+    to_connecting();
+    CHECK(host_net_connected());
+    advance_ms(PICOHTTPS_TIMEOUT - 1);
+    CHECK(picohttps_poll() == PICOHTTPS_SENDING);
+    advance_ms(1);
+    check_finished(PICOHTTPS_FAILED);
+    CHECK(host_net.closes == 1);
+
+    // Response stalls; the timeout runs from the last data received
+    to_receiving();
+    receive("HTTP/1.1 200 OK\r\nContent-Length: 100\r\n\r\nfirst", 1460);
+    advance_ms(PICOHTTPS_TIMEOUT - 1);
+    CHECK(picohttps_poll() == PICOHTTPS_RECEIVING);
+    receive("second", 1460);
+    advance_ms(PICOHTTPS_TIMEOUT - 1);
+    CHECK(picohttps_poll() == PICOHTTPS_RECEIVING);
+    advance_ms(1);
+    check_finished(PICOHTTPS_FAILED);
+    CHECK(host_net.closes == 1);
+    CHECK(body_len == 11);
+}
+
+
+/* Errors *********************************************************************/
+
+static void test_errors(void){
+
+    // Join refused outright, or failing later
+    start(NULL, NULL);
+    host_net.join_result = -1;
+    check_finished(PICOHTTPS_FAILED);
+    start(NULL, NULL);
+    CHECK(picohttps_poll() == PICOHTTPS_JOINING);
+    host_net.link = CYW43_LINK_BADAUTH;
+    check_finished(PICOHTTPS_FAILED);
+
+    // Hostname unknown, synchronously or not
+    to_resolving();
+    CHECK(host_net_resolve(false));
+    check_finished(PICOHTTPS_FAILED);
+    start(NULL, NULL);
+    host_net.link = CYW43_LINK_UP;
+    host_net.dns_result = ERR_ARG;
+    check_finished(PICOHTTPS_FAILED);
+    CHECK(host_net.connections == 0);
+
+    // Handshake fails; lwIP has freed the connection, so it must not be
+    // closed again
+    to_connecting();
+    host_net_fail(ERR_ABRT);
+    check_finished(PICOHTTPS_FAILED);
+    CHECK(host_net.closes == 0 && host_net.aborts == 0);
+
+    // Connection reset part way through the body
+    to_receiving();
+    receive("HTTP/1.1 200 OK\r\nContent-Length: 100\r\n\r\npartial", 1460);
+    host_net_fail(ERR_RST);
+    check_finished(PICOHTTPS_FAILED);
+    CHECK(host_net.closes == 0 && body_len == 7);
+
+    // Request cannot be queued
+    to_connecting();
+    host_net.write_result = ERR_MEM;
+    CHECK(host_net_connected());
+    check_finished(PICOHTTPS_FAILED);
+    CHECK(host_net.closes == 1);
+
+    // Malformed response: fails at once, without waiting for the server
+    to_receiving();
+    receive("HTTP/1.1 abc\r\n\r\n", 1460);
+    check_finished(PICOHTTPS_FAILED);
+
+    // Body in a coding we cannot undo
+    to_receiving();
+    receive("HTTP/1.1 200 OK\r\nContent-Encoding: br\r\nContent-Length: 4\r\n\r\nxxxx", 1460);
+    check_finished(PICOHTTPS_FAILED);
+    CHECK(body_len == 0);
+}
+
+
+/* Server hanging up early ****************************************************/
+
+static void test_early_close(void){
+
+    // During the handshake
+    to_connecting();
+    host_net_close();
+    check_finished(PICOHTTPS_FAILED);
+    CHECK(host_net.closes == 1);
+
+    // Before any response
+    to_receiving();
+    host_net_close();
+    check_finished(PICOHTTPS_FAILED);
+    CHECK(host_net.closes == 1);
+
+    // Part way through the header
+    to_receiving();
+    receive("HTTP/1.1 200 OK\r\nContent-Le", 1460);
+    host_net_close();
+    check_finished(PICOHTTPS_FAILED);
+
+    // Short of Content-Length
+    to_receiving();
+    receive("HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nshort", 1460);
+    host_net_close();
+    check_finished(PICOHTTPS_FAILED);
+    CHECK(body_len == 5);
+
+    // Before the last chunk
+    to_receiving();
+    receive("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n", 1460);
+    host_net_close();
+    check_finished(PICOHTTPS_FAILED);
+    CHECK(body_len == 5);
+}
+
+int main(void){
+    test_done();
+    test_timeouts();
+    test_errors();
+    test_early_close();
+    return test_result("test_picohttps");
+}
@@ -0,0 +1,299 @@
+/* Review journal tests *******************************************************
+ *                                                                            *
+ *  Grades cards through review_sched and review_journal, as main.c does, on  *
+ *  the RAM flash stand-in, and reboots with the schedule wiped from RAM. The *
+ *  journal must bring the schedule back as it was after one of the last few  *
+ *  grades, no further back than a batch, with the clock where that grade     *
+ *  left it, and carry on logging. Power is cut at every byte of every page   *
+ *  programmed while a log sector fills (records, the snapshot's states and   *
+ *  header, the next sector's header) and part way through every erase.       *
+ *  Snapshots that fail leave the log to grow round the ring.                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hardware/flash.h"
+
+#include "review_journal.h"
+#include "review_sched.h"
+
+#include "host.h"
+#include "test.h"
+
+
+#define CARDS               300
+#define SECTOR_RECORDS      ((FLASH_SECTOR_SIZE - sizeof(review_journal_sector_t)) / sizeof(review_journal_record_t))
+#define STEPS               (REVIEW_JOURNAL_BATCH + 1)  // A torn batch, and the grade before
+#define SWEEP_GRADES        (5 * REVIEW_JOURNAL_BATCH)  // Through a sector filling
+#define MAX_OPS             64
+
+
+// Schedule after a grade
+typedef struct{
+    review_card_t cards[CARDS];
+    uint32_t time;                  // Clock (s) of the grade
+} step_t;
+
+// Flash operation
+typedef struct{
+    uint32_t start;                 // host_flash_stats.bytes before it
+    uint32_t len;
+    bool erase;
+} op_t;
+
+
+static step_t steps[STEPS];                 // By grade % STEPS
+static uint32_t graded;                     // Grades kept so far
+static uint32_t now;                        // Clock (s)
+static uint32_t seed;
+static bool snapshots_fail = false;         // No RAM while logging a grade
+
+static bool fail_malloc = false;
+static uint32_t snapshot_erases;
+static uint32_t sector_erases[REVIEW_JOURNAL_LOG_SECTORS];
+static bool logging = false;
+static op_t ops[MAX_OPS];
+static uint32_t op_count;
+
+static uint8_t saved_region[REVIEW_JOURNAL_SIZE];
+
+
+/* Wrappers *******************************************************************/
+
+void* __real_malloc(size_t size);
+void __real_flash_range_erase(uint32_t flash_offs, size_t count);
+void __real_flash_range_program(uint32_t flash_offs, const uint8_t* data, size_t count);
+
+void* __wrap_malloc(size_t size){
+    return fail_malloc ? NULL : __real_malloc(size);
+}
+
+static void log_op(size_t count, bool erase){
+    if(logging && op_count < MAX_OPS) ops[op_count++] = (op_t){host_flash_stats.bytes, count, erase};
+}
+
+void __wrap_flash_range_erase(uint32_t flash_offs, size_t count){
+    uint32_t log = REVIEW_JOURNAL_OFFSET + 2 * REVIEW_JOURNAL_SNAPSHOT_SIZE;
+    if(count == REVIEW_JOURNAL_SNAPSHOT_SIZE) snapshot_erases++;
+    else if(flash_offs >= log) sector_erases[(flash_offs - log) / FLASH_SECTOR_SIZE]++;
+    log_op(count, true);
+    __real_flash_range_erase(flash_offs, count);
+}
+
+void __wrap_flash_range_program(uint32_t flash_offs, const uint8_t* data, size_t count){
+    log_op(count, false);
+    __real_flash_range_program(flash_offs, data, count);
+}
+
+
+/* Tests **********************************************************************/
+
+static uint32_t random_next(void){
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+// Never 0
+static uint32_t card_hash(uint32_t index){
+    return (index + 1) * 2654435761u;
+}
+
+static void save_step(void){
+    uint32_t count;
+    const review_card_t* cards = review_sched_cards(&count);
+    memcpy(steps[graded % STEPS].cards, cards, sizeof(steps[0].cards));
+    steps[graded % STEPS].time = now;
+}
+
+// Boot as main.c does. Nothing of the schedule survives in RAM: restoring
+// the state of a card the deck lacks makes the load start every card anew.
+static void boot(void){
+    static const review_card_t nobody = {.hash = 0};
+    host_flash_power_on();
+    review_sched_restore(&nobody, 1);
+    CHECK(review_journal_init());
+    CHECK(review_sched_load(CARDS, card_hash, 1));
+    review_journal_replay();
+}
+
+// Erased flash, first boot
+static void fresh(uint32_t test_seed){
+    host_flash_reset();
+    snapshot_erases = 0;
+    memset(sector_erases, 0, sizeof(sector_erases));
+    seed = test_seed;
+    graded = 0;
+    now = 0;
+    boot();
+    CHECK(review_journal_clock() == 0);
+    save_step();
+}
+
+// Grade `count` cards, unless power is lost first
+static void grade(uint32_t count){
+    for(uint32_t i = 0; i < count && !host_flash_power_lost(); i++){
+        uint32_t index;
+        CHECK(review_sched_next(now, &index));
+        review_grade_t grade = random_next() % (REVIEW_GRADE_EASY + 1);
+        review_sched_grade(grade, now);
+        graded++;
+        save_step();
+        fail_malloc = snapshots_fail;
+        review_journal_record(card_hash(index), grade, now);
+        fail_malloc = false;
+        now += 1 + random_next() % 600;
+    }
+}
+
+// Reboot, and find which grade the schedule came back to
+//
+//  It must be one of the last `lost` + 1; the grades after it are gone, and
+//  the test carries on from there. The clock comes back to that grade's, or
+//  the next one's if it opened a log sector before being lost.
+//
+//  @return         Grades lost
+//
+static uint32_t reboot(uint32_t lost){
+    boot();
+    uint32_t count;
+    const review_card_t* cards = review_sched_cards(&count);
+    CHECK(count == CARDS);
+    for(uint32_t back = 0; back <= lost && back <= graded; back++){
+        const step_t* step = &steps[(graded - back) % STEPS];
+        uint32_t latest = back > 0 ? steps[(graded - back + 1) % STEPS].time : step->time;
+        uint32_t clock = review_journal_clock();
+        if(memcmp(cards, step->cards, sizeof(step->cards)) == 0 && (clock == step->time || clock == latest)){
+            graded -= back;
+            return back;
+        }
+    }
+    fprintf(stderr, "reboot after %u grades: schedule not that of the last %u\n", graded, lost + 1);
+    test_failures++;
+    save_step();
+    return 0;
+}
+
+// The log wraps round the ring several times, with reboots in between,
+// taking one snapshot per sector filled and wearing the sectors evenly
+static void test_round_trip(void){
+    fresh(1);
+    CHECK(reboot(0) == 0);
+    while(graded < 3 * REVIEW_JOURNAL_LOG_SECTORS * SECTOR_RECORDS){
+        grade(1 + random_next() % 700);
+        reboot(REVIEW_JOURNAL_BATCH - 1);
+    }
+    CHECK(snapshot_erases == graded / SECTOR_RECORDS);
+    uint32_t least = UINT32_MAX, most = 0;
+    for(uint32_t i = 0; i < REVIEW_JOURNAL_LOG_SECTORS; i++){
+        if(sector_erases[i] < least) least = sector_erases[i];
+        if(sector_erases[i] > most) most = sector_erases[i];
+    }
+    CHECK(most - least <= 1);
+    CHECK(host_flash_stats.overwrites == 0);
+}
+
+// Power cut `cut` bytes into the sweep's grades, then reboot
+static void cut_and_reboot(uint32_t cut, uint32_t base_graded, uint32_t base_now,
+                           uint32_t base_seed, const step_t* base, uint32_t* kept, uint32_t* lost){
+    memcpy(host_flash + REVIEW_JOURNAL_OFFSET, saved_region, sizeof(saved_region));
+    graded = base_graded;
+    now = base_now;
+    seed = base_seed;
+    steps[graded % STEPS] = *base;
+    CHECK(reboot(0) == 0);
+
+    host_flash_cut_power(cut);
+    grade(SWEEP_GRADES);
+    CHECK(host_flash_power_lost());
+    if(reboot(REVIEW_JOURNAL_BATCH) == 0) ++*kept;
+    else ++*lost;
+
+    // Logging carries on past whatever was torn
+    grade(2 * REVIEW_JOURNAL_BATCH + 1);
+    reboot(REVIEW_JOURNAL_BATCH - 1);
+}
+
+// Torn records, snapshot and sector headers, and erases
+static void test_power_loss(void){
+    // Close to the end of a log sector, once the log has been round the
+    // ring: a torn snapshot has only the older one to fall back on
+    fresh(2);
+    grade((REVIEW_JOURNAL_LOG_SECTORS + 2) * SECTOR_RECORDS - 3 * REVIEW_JOURNAL_BATCH - 5);
+    reboot(REVIEW_JOURNAL_BATCH - 1);
+    memcpy(saved_region, host_flash + REVIEW_JOURNAL_OFFSET, sizeof(saved_region));
+    uint32_t base_graded = graded, base_now = now, base_seed = seed;
+    step_t base = steps[graded % STEPS];
+
+    // The flash operations the sweep's grades take
+    uint32_t start = host_flash_stats.bytes;
+    op_count = 0;
+    logging = true;
+    grade(SWEEP_GRADES);
+    logging = false;
+    CHECK(op_count < MAX_OPS);
+    bool snapshot = false, sector = false;
+    for(uint32_t i = 0; i < op_count; i++){
+        if(ops[i].erase && ops[i].len == REVIEW_JOURNAL_SNAPSHOT_SIZE) snapshot = true;
+        if(ops[i].erase && ops[i].len == FLASH_SECTOR_SIZE) sector = true;
+    }
+    CHECK(snapshot && sector);
+
+    // Every byte programmed; the start, middle and end of each erase
+    uint32_t kept = 0, lost = 0;
+    for(uint32_t i = 0; i < op_count; i++){
+        uint32_t at = ops[i].start - start;
+        if(ops[i].erase){
+            uint32_t cuts[] = {at, at + ops[i].len / 2, at + ops[i].len - 1};
+            for(unsigned c = 0; c < 3; c++){
+                cut_and_reboot(cuts[c], base_graded, base_now, base_seed, &base, &kept, &lost);
+            }
+        } else {
+            for(uint32_t b = 0; b < ops[i].len; b++){
+                cut_and_reboot(at + b, base_graded, base_now, base_seed, &base, &kept, &lost);
+            }
+        }
+    }
+    CHECK(kept > 0);
+    CHECK(lost > 0);
+    printf("%u power cuts in %u flash operations: every grade kept %u times, part of a batch lost %u\n",
+           kept + lost, op_count, kept, lost);
+    CHECK(host_flash_stats.overwrites == 0);
+}
+
+// A failed snapshot leaves its sectors to the next; with every snapshot
+// failing the log fills the ring, and takes no more until one succeeds
+static void test_failed_snapshot(void){
+    fresh(3);
+    snapshots_fail = true;
+    grade(SECTOR_RECORDS + 10);
+    snapshots_fail = false;
+    reboot(REVIEW_JOURNAL_BATCH - 1);
+    grade(SECTOR_RECORDS);
+    reboot(REVIEW_JOURNAL_BATCH - 1);
+
+    // Grades are only lost once there is nowhere left to put them
+    uint32_t full = (2 + REVIEW_JOURNAL_LOG_SECTORS) * SECTOR_RECORDS;
+    snapshots_fail = true;
+    grade(full - graded);
+    grade(REVIEW_JOURNAL_BATCH);
+    snapshots_fail = false;
+    CHECK(reboot(REVIEW_JOURNAL_BATCH) == REVIEW_JOURNAL_BATCH);
+    CHECK(graded == full);
+
+    // Snapshotting again makes room
+    grade(2 * REVIEW_JOURNAL_BATCH + 1);
+    reboot(REVIEW_JOURNAL_BATCH - 1);
+    CHECK(graded > full);
+    grade(2 * SECTOR_RECORDS);
+    reboot(REVIEW_JOURNAL_BATCH - 1);
+    CHECK(host_flash_stats.overwrites == 0);
+}
+
+int main(void){
+    test_round_trip();
+    test_power_loss();
+    test_failed_snapshot();
+    return test_result("test_review_journal");
+}